@@ -2,13 +2,46 @@
 
 #include <stdint.h>
 
+#include "crsf_protocol.h"
+
+// CRC8 lookup table, generated at compile time
+template <uint8_t POLY>
+struct Crc8Lut {
+    uint8_t lut[256];
+    constexpr Crc8Lut() : lut()
+    {
+        for (int idx=0; idx<256; ++idx)
+        {
+            uint8_t crc = idx;
+            for (int shift=0; shift<8; ++shift)
+            {
+                crc = (crc << 1) ^ ((crc & 0x80) ? POLY : 0);
+            }
+            lut[idx] = crc & 0xff;
+        }
+    }
+};
+
+template <uint8_t POLY>
 class Crc8
 {
 public:
-    Crc8(uint8_t poly);
-    uint8_t calc(uint8_t *data, uint8_t len);
+    // Continues from crc, so data can be given in pieces
+    static uint8_t calc(const uint8_t *data, uint8_t len, uint8_t crc = 0)
+    {
+        while (len--)
+        {
+            crc = _lut.lut[crc ^ *data++];
+        }
+        return crc;
+    }
 
 protected:
-    uint8_t _lut[256];
-    void init(uint8_t poly);
-};
\ No newline at end of file
+    static constexpr Crc8Lut<POLY> _lut{};
+};
+
+// CRSF uses the DVB-S2 polynomial
+typedef Crc8<CRSF_CRC_POLY> CrsfCrc8;
+
+// Command frames carry a second CRC over the type and payload
+typedef Crc8<CRSF_COMMAND_CRC_POLY> CrsfCmdCrc8;
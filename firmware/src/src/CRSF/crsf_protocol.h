@@ -5,6 +5,7 @@
 #define PACKED __attribute__((packed))
 
 #define CRSF_CRC_POLY 0xd5
+#define CRSF_COMMAND_CRC_POLY 0xba
 
 #define CRSF_BAUDRATE BAUD420000
 
@@ -108,6 +109,13 @@ enum {
     CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE = 6,
 };
 
+// General command sub commands, CRSF speed negotiation
+enum {
+    CRSF_COMMAND_SUBCMD_GENERAL = 0x0A,
+    CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL = 0x70, // port id, baud rate (u32 big endian)
+    CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_RESPONSE = 0x71, // port id, accepted
+};
+
 typedef enum
 {
     CRSF_ADDRESS_BROADCAST = 0x00,
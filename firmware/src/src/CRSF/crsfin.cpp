@@ -9,6 +9,7 @@
 #include <zephyr/logging/log.h>
 
 #include "crsfout.h"
+#include "chcodec.h"
 #include "defines.h"
 
 #include "uart_mode.h"
@@ -21,6 +22,7 @@ CrsfSerial *crsfin = nullptr;
 
 static void crsfShiftyByte(uint8_t b)
 {
+  ARG_UNUSED(b);
   // LOG_INF("CRSF, shifty byte %c", b);
 }
 
@@ -88,7 +90,8 @@ void CrsfInInit()
 }
 
 CrsfSerial::CrsfSerial(uint32_t baud) :
-    _crc(0xd5),
+    _rxHead(0),
+    _rxTail(0),
     _baud(baud),
     _lastReceive(0),
     _lastChannelsPacket(0),
@@ -106,21 +109,25 @@ void CrsfSerial::loop() { handleSerialIn(); }
 void CrsfSerial::handleSerialIn()
 {
   while (AuxSerial_Available()) {
-    uint8_t b;
-    if (AuxSerial_Read(&b, 1) != 1) continue;
+    // Read as much as fits in the ring without wrapping
+    uint8_t head = _rxHead & (CRSF_RX_RING - 1);
+    uint8_t space = MIN(CRSF_RX_RING - rxAvailable(), CRSF_RX_RING - head);
+    uint32_t cnt = AuxSerial_Read(&_rxBuf[head], space);
+    if (cnt == 0) break;
     _lastReceive = millis();
 
     if (_passthroughMode) {
-      if (onShiftyByte) onShiftyByte(b);
+      for (uint32_t i = 0; i < cnt; i++)
+        if (onShiftyByte) onShiftyByte(_rxBuf[head + i]);
       continue;
     }
 
-    _rxBuf[_rxBufPos++] = b;
-    handleByteReceived();
+    _rxHead += cnt;
+    parseRxBuffer();
 
-    if (_rxBufPos == (sizeof(_rxBuf) / sizeof(_rxBuf[0]))) {
+    if (rxAvailable() == CRSF_RX_RING) {
       // Packet buffer filled and no valid packet found, dump the whole thing
-      _rxBufPos = 0;
+      _rxTail = _rxHead;
     }
   }
 
@@ -128,41 +135,44 @@ void CrsfSerial::handleSerialIn()
   checkLinkDown();
 }
 
-void CrsfSerial::handleByteReceived()
+// CRC of len bytes starting offset bytes into the packet, in at most two pieces of the ring
+uint8_t CrsfSerial::rxCrc(uint8_t offset, uint8_t len)
 {
-  bool reprocess;
-  do {
-    reprocess = false;
-    if (_rxBufPos > 1) {
-      uint8_t len = _rxBuf[1];
-      // Sanity check the declared length, can't be shorter than Type, X, CRC
-      if (len < 3 || len > CRSF_MAX_PACKET_LEN) {
-        shiftRxBuffer(1);
-        reprocess = true;
-      }
-
-      else if (_rxBufPos >= (len + 2)) {
-        uint8_t inCrc = _rxBuf[2 + len - 1];
-        uint8_t crc = _crc.calc(&_rxBuf[2], len - 1);
-        if (crc == inCrc) {
-          processPacketIn(len);
-          shiftRxBuffer(len + 2);
-          reprocess = true;
-        } else {
-          shiftRxBuffer(1);
-          reprocess = true;
-        }
-      }  // if complete packet
-    }    // if pos > 1
-  } while (reprocess);
+  uint8_t start = (uint8_t)(_rxTail + offset) & (CRSF_RX_RING - 1);
+  uint8_t first = MIN(len, CRSF_RX_RING - start);
+  uint8_t crc = CrsfCrc8::calc(&_rxBuf[start], first);
+  return CrsfCrc8::calc(&_rxBuf[0], len - first, crc);
+}
+
+// Validates and dispatches all complete packets in the ring
+void CrsfSerial::parseRxBuffer()
+{
+  while (rxAvailable() > 1) {
+    uint8_t len = rxByte(1);
+    // Sanity check the declared length, can't be shorter than Type, X, CRC
+    if (len < 3 || len > CRSF_MAX_PACKET_LEN) {
+      dropRxBytes(1);
+      continue;
+    }
+
+    // Wait for the complete packet
+    if (rxAvailable() < len + 2) return;
+
+    if (rxCrc(2, len - 1) == rxByte(len + 1)) {
+      processPacketIn(len);
+      _rxTail += len + 2;
+    } else {
+      dropRxBytes(1);
+    }
+  }
 }
 
 void CrsfSerial::checkPacketTimeout()
 {
   // If we haven't received data in a long time, flush the buffer a byte at a time (to trigger
   // shiftyByte)
-  if (_rxBufPos > 0 && millis() - _lastReceive > CRSF_PACKET_TIMEOUT_MS)
-    while (_rxBufPos) shiftRxBuffer(1);
+  if (rxAvailable() > 0 && millis() - _lastReceive > CRSF_PACKET_TIMEOUT_MS)
+    while (rxAvailable()) dropRxBytes(1);
 }
 
 void CrsfSerial::checkLinkDown()
@@ -175,63 +185,51 @@ void CrsfSerial::checkLinkDown()
 
 void CrsfSerial::processPacketIn(uint8_t len)
 {
-  const crsf_header_t *hdr = (crsf_header_t *)_rxBuf;
-  if (hdr->device_addr == CRSF_ADDRESS_FLIGHT_CONTROLLER) {
-    switch (hdr->type) {
-      case CRSF_FRAMETYPE_GPS:
-        packetGps(hdr);
-        break;
-      case CRSF_FRAMETYPE_RC_CHANNELS_PACKED:
-        packetChannelsPacked(hdr);
-        break;
-      case CRSF_FRAMETYPE_LINK_STATISTICS:
-        packetLinkStatistics(hdr);
-        break;
-    }
-  }  // CRSF_ADDRESS_FLIGHT_CONTROLLER
+  // Only addressed to us are handled, copied out of the ring for the handlers
+  if (rxByte(0) != CRSF_ADDRESS_FLIGHT_CONTROLLER) return;
+  switch (rxByte(2)) {
+    case CRSF_FRAMETYPE_GPS:
+    case CRSF_FRAMETYPE_RC_CHANNELS_PACKED:
+    case CRSF_FRAMETYPE_LINK_STATISTICS:
+      break;
+    default:
+      return;
+  }
+  for (uint8_t i = 0; i < len + 2; i++) _packet[i] = rxByte(i);
+
+  const crsf_header_t *hdr = (crsf_header_t *)_packet;
+  switch (hdr->type) {
+    case CRSF_FRAMETYPE_GPS:
+      packetGps(hdr);
+      break;
+    case CRSF_FRAMETYPE_RC_CHANNELS_PACKED:
+      packetChannelsPacked(hdr);
+      break;
+    case CRSF_FRAMETYPE_LINK_STATISTICS:
+      packetLinkStatistics(hdr);
+      break;
+  }
 }
 
-// Shift the bytes in the RxBuf down by cnt bytes
-void CrsfSerial::shiftRxBuffer(uint8_t cnt)
+// Drop cnt bytes from the start of the ring
+void CrsfSerial::dropRxBytes(uint8_t cnt)
 {
-  // If removing the whole thing, just set pos to 0
-  if (cnt >= _rxBufPos) {
-    _rxBufPos = 0;
+  // If removing the whole thing, just empty it
+  if (cnt >= rxAvailable()) {
+    _rxTail = _rxHead;
     return;
   }
 
-  if (cnt == 1 && onShiftyByte) onShiftyByte(_rxBuf[0]);
-
-  // Otherwise do the slow shift down
-  uint8_t *src = &_rxBuf[cnt];
-  uint8_t *dst = &_rxBuf[0];
-  _rxBufPos -= cnt;
-  uint8_t left = _rxBufPos;
-  while (left--) *dst++ = *src++;
+  if (cnt == 1 && onShiftyByte) onShiftyByte(rxByte(0));
+  _rxTail += cnt;
 }
 
 void CrsfSerial::packetChannelsPacked(const crsf_header_t *p)
 {
-  crsf_channels_t *ch = (crsf_channels_t *)&p->data;
-  _channels[0] = ch->ch0;
-  _channels[1] = ch->ch1;
-  _channels[2] = ch->ch2;
-  _channels[3] = ch->ch3;
-  _channels[4] = ch->ch4;
-  _channels[5] = ch->ch5;
-  _channels[6] = ch->ch6;
-  _channels[7] = ch->ch7;
-  _channels[8] = ch->ch8;
-  _channels[9] = ch->ch9;
-  _channels[10] = ch->ch10;
-  _channels[11] = ch->ch11;
-  _channels[12] = ch->ch12;
-  _channels[13] = ch->ch13;
-  _channels[14] = ch->ch14;
-  _channels[15] = ch->ch15;
-
+  uint16_t ch[CRSF_NUM_CHANNELS];
+  ChCodec::unpack(p->data, ch);
   for (unsigned int i = 0; i < CRSF_NUM_CHANNELS; ++i) {
-    _channels[i] = fmap(_channels[i], CRSF_CHANNEL_VALUE_1000, CRSF_CHANNEL_VALUE_2000, 1000, 2000);
+    _channels[i] = ChCodec::CrsfToUs::map(ch[i]);
   }
 
   if (!_linkIsUp && onLinkUp) onLinkUp();
@@ -277,7 +275,7 @@ void CrsfSerial::queuePacket(uint8_t addr, uint8_t type, const void *payload, ui
   buf[1] = len + 2;  // type + payload + crc
   buf[2] = type;
   memcpy(&buf[3], payload, len);
-  buf[len + 3] = _crc.calc(&buf[2], len + 1);
+  buf[len + 3] = CrsfCrc8::calc(&buf[2], len + 1);
 
   // Busywait until the serial port seems free
   // while (millis() - _lastReceive < 2)
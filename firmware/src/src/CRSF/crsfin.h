@@ -40,9 +40,13 @@ public:
     void (*onPacketGps)(crsf_sensor_gps_t *gpsSensor);
 
 private:
-    uint8_t _rxBuf[CRSF_MAX_PACKET_LEN+3];
-    uint8_t _rxBufPos;
-    Crc8 _crc;
+    // Received bytes, a ring indexed by _rxHead/_rxTail so nothing is moved as packets are
+    // consumed. Size must be a power of two that divides 256 and hold two packets
+    static const uint8_t CRSF_RX_RING = 128;
+    uint8_t _rxBuf[CRSF_RX_RING];
+    uint8_t _rxHead;  // Next byte written
+    uint8_t _rxTail;  // Start of the next packet
+    uint8_t _packet[CRSF_MAX_PACKET_LEN+2] __attribute__((aligned(4)));  // Valid packet
     crsfLinkStatistics_t _linkStatistics;
     crsf_sensor_gps_t _gpsSensor;
     uint32_t _baud;
@@ -53,8 +57,11 @@ private:
     int _channels[CRSF_NUM_CHANNELS];
 
     void handleSerialIn();
-    void handleByteReceived();
-    void shiftRxBuffer(uint8_t cnt);
+    void parseRxBuffer();
+    uint8_t rxAvailable() const { return _rxHead - _rxTail; }
+    uint8_t rxByte(uint8_t offset) const { return _rxBuf[(uint8_t)(_rxTail + offset) & (CRSF_RX_RING - 1)]; }
+    uint8_t rxCrc(uint8_t offset, uint8_t len);
+    void dropRxBytes(uint8_t cnt);
     void processPacketIn(uint8_t len);
     void checkPacketTimeout();
     void checkLinkDown();
@@ -1,10 +1,64 @@
 #include "crsfout.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
 #include "auxserial.h"
 #include "crc8.h"
 #include "trackersettings.h"
 
+LOG_MODULE_REGISTER(crsfout);
+
 CRSF crsfout;
 
+// Output baud rates selected by CrsfTxBaud. Output always starts at the first, faster rates
+// are proposed to the FC and only switched to once it accepts
+static const struct {
+  uint32_t baudrate;
+  uint32_t reg;
+} crsfBauds[] = {
+    {400000, BAUD400000},
+    {921600, BAUD921600},
+    {1000000, BAUD1000000},
+};
+#define CRSF_BAUD_COUNT (sizeof(crsfBauds) / sizeof(crsfBauds[0]))
+
+#define CRSF_SPEED_PROPOSALS 10        // Attempts before giving up on a faster rate
+#define CRSF_SPEED_PROPOSAL_PERIOD 200 // (ms) Between attempts
+#define CRSF_SPEED_PROPOSAL_LEN 14     // Bytes on the wire
+#define CRSF_SPEED_NONE -1
+#define CRSF_FC_TIMEOUT 1500           // (ms) Silence at a faster rate before falling back
+
+/* Telemetry sent after the RC frames, in the time left over in each frame period. When more
+ *  than one is due the longest waiting goes first. If none fit they wait, the RC rate is never
+ *  reduced
+ */
+static const struct {
+  uint16_t period;  // (ms)
+  uint8_t len;      // Bytes on the wire
+} crsfTelemetry[CRSF_TLM_COUNT] = {
+    {100, LinkStatisticsFrameLength + 4},
+    {20, CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE + 4},
+    {500, CRSF_FRAME_BATTERY_SENSOR_PAYLOAD_SIZE + 4},
+};
+
+// ELRS rate reported in link statistics, the fastest not above the output rate
+static const struct {
+  uint16_t rate;
+  uint8_t mode;
+} crsfRfModes[] = {
+    {1000, RATE_FLRC_1000HZ}, {500, RATE_LORA_500HZ}, {250, RATE_LORA_250HZ},
+    {200, RATE_LORA_200HZ},   {150, RATE_LORA_150HZ}, {100, RATE_LORA_100HZ},
+    {50, RATE_LORA_50HZ},     {25, RATE_LORA_25HZ},
+};
+
+// Bytes the line carries in a frame period (us). 10 bits a byte, less a margin for the gaps
+// between writes
+static uint32_t slotCapacity(uint32_t baudrate, uint32_t period)
+{
+  return (uint64_t)baudrate * period / 10000000 * 9 / 10;
+}
+
 void CrsfOutInit()
 {
   crsfout.Begin();
@@ -36,14 +90,162 @@ volatile uint16_t CRSF::ChannelDataInPrev[16] = {0};
 
 volatile uint8_t CRSF::ParameterUpdateData[2] = {0};
 
-volatile crsf_channels_s CRSF::PackedRCdataOut;
+volatile uint8_t CRSF::PackedRCdataOut[RCframeLength];
 volatile crsf_attitude_s CRSF::AttitudeDataOut;
 volatile crsfPayloadLinkstatistics_s CRSF::LinkStatistics;
 
+bool CRSF::txInverted = false;
+uint8_t CRSF::baudIndex = 0;
+uint8_t CRSF::proposedIndex = 0;
+uint8_t CRSF::proposalsLeft = 0;
+int64_t CRSF::nextProposal = 0;
+volatile int8_t CRSF::speedReply = CRSF_SPEED_NONE;
+volatile bool CRSF::rxValid = false;
+int64_t CRSF::lastRxValid = 0;
+uint8_t CRSF::rxFrame[CRSF_FRAME_SIZE_MAX];
+uint8_t CRSF::rxLen = 0;
+uint32_t CRSF::slotBytes = 0;
+int64_t CRSF::telemetryDue[CRSF_TLM_COUNT] = {0};
+
 void CRSF::Begin()
 {
+  baudIndex = 0;
+  proposedIndex = 0;
+  proposalsLeft = 0;
+  speedReply = CRSF_SPEED_NONE;
+  rxValid = false;
+  lastRxValid = 0;
+  openPort();
+}
+
+void CRSF::openPort()
+{
+  txInverted = trkset.getCrsfTxInv();
   AuxSerial_Close();
-  AuxSerial_Open(BAUD400000, CONF8N1);
+  AuxSerial_Open(crsfBauds[baudIndex].reg, CONF8N1, txInverted ? CONFINV_TX : 0);
+  rxLen = 0;
+}
+
+/* Asks the FC to move to a new baud rate. It answers at the current rate, after
+ *  accepting both ends switch
+ *
+ * [sync][len][COMMAND][dest][origin][GENERAL][SPEED_PROPOSAL][port][baud x4][cmd crc][crc]
+ */
+
+void CRSF::sendSpeedProposal(uint32_t baudrate)
+{
+  uint8_t outBuffer[CRSF_SPEED_PROPOSAL_LEN];
+
+  outBuffer[0] = CRSF_SYNC_BYTE;
+  outBuffer[1] = sizeof(outBuffer) - 2;
+  outBuffer[2] = CRSF_FRAMETYPE_COMMAND;
+  outBuffer[3] = CRSF_ADDRESS_FLIGHT_CONTROLLER;
+  outBuffer[4] = CRSF_ADDRESS_CRSF_RECEIVER;
+  outBuffer[5] = CRSF_COMMAND_SUBCMD_GENERAL;
+  outBuffer[6] = CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL;
+  outBuffer[7] = 0;  // Port
+  outBuffer[8] = baudrate >> 24;
+  outBuffer[9] = baudrate >> 16;
+  outBuffer[10] = baudrate >> 8;
+  outBuffer[11] = baudrate;
+  outBuffer[12] = CrsfCmdCrc8::calc(&outBuffer[2], 10);
+  outBuffer[13] = CrsfCrc8::calc(&outBuffer[2], 11);
+
+  queueFrame(outBuffer, sizeof(outBuffer));
+}
+
+/* Runs between RC frames on the sending thread, the only one that writes or reopens the port.
+ *  Proposes CrsfTxBaud until the FC answers or the attempts run out. Changing the setting
+ *  starts over. A proposal only goes out in a frame period with room left after the RC frame,
+ *  at 400000 baud that is a rate below about 900Hz
+ *
+ * If the FC restarts it is back at the default rate and nothing valid arrives at the faster
+ *  one. After CRSF_FC_TIMEOUT of that the output falls back to the default and proposes again
+ */
+
+void CRSF::negotiateSpeed(uint32_t period)
+{
+  int64_t now = k_uptime_get();
+  if (rxValid) {
+    rxValid = false;
+    lastRxValid = now;
+  }
+
+  // Inversion changed, reopen at the rate in use
+  if (txInverted != trkset.getCrsfTxInv()) openPort();
+
+  if (baudIndex != 0 && now - lastRxValid > CRSF_FC_TIMEOUT) {
+    LOG_WRN("Nothing from FC at %u baud, back to %u", crsfBauds[baudIndex].baudrate,
+            crsfBauds[0].baudrate);
+    baudIndex = 0;
+    openPort();
+    proposalsLeft = proposedIndex != baudIndex ? CRSF_SPEED_PROPOSALS : 0;
+    speedReply = CRSF_SPEED_NONE;
+    nextProposal = 0;
+  }
+
+  uint8_t want = MIN(trkset.getCrsfTxBaud(), CRSF_BAUD_COUNT - 1);
+  if (want != proposedIndex) {
+    proposedIndex = want;
+    proposalsLeft = want != baudIndex ? CRSF_SPEED_PROPOSALS : 0;
+    speedReply = CRSF_SPEED_NONE;
+    nextProposal = 0;
+  }
+  if (proposalsLeft == 0) return;
+
+  int8_t reply = speedReply;
+  if (reply != CRSF_SPEED_NONE) {
+    speedReply = CRSF_SPEED_NONE;
+    proposalsLeft = 0;
+    if (reply) {
+      LOG_INF("CRSF output now %u baud", crsfBauds[proposedIndex].baudrate);
+      baudIndex = proposedIndex;
+      lastRxValid = now;
+      openPort();
+    } else {
+      LOG_WRN("FC rejected %u baud", crsfBauds[proposedIndex].baudrate);
+    }
+    return;
+  }
+
+  if (now < nextProposal) return;
+  if (slotBytes + CRSF_SPEED_PROPOSAL_LEN > slotCapacity(crsfBauds[baudIndex].baudrate, period))
+    return;
+  nextProposal = now + CRSF_SPEED_PROPOSAL_PERIOD;
+  sendSpeedProposal(crsfBauds[proposedIndex].baudrate);
+  if (--proposalsLeft == 0)
+    LOG_WRN("No answer to %u baud proposal", crsfBauds[proposedIndex].baudrate);
+}
+
+// Collects frames sent back by the FC. Any valid one shows the rate in use works, only speed
+// responses are looked into
+void CRSF::loop()
+{
+  uint8_t chunk[32];
+  uint32_t len;
+  while ((len = AuxSerial_Read(chunk, sizeof(chunk))) > 0) {
+    for (uint32_t i = 0; i < len; i++) {
+      uint8_t c = chunk[i];
+      if (rxLen == 0 && c != CRSF_SYNC_BYTE) continue;
+      if (rxLen == 1 && (c < CRSF_FRAME_LENGTH_TYPE_CRC || c > CRSF_PAYLOAD_SIZE_MAX)) {
+        rxLen = 0;
+        continue;
+      }
+      rxFrame[rxLen++] = c;
+      if (rxLen < 2 || rxLen < rxFrame[1] + 2) continue;
+
+      uint8_t framelen = rxFrame[1];
+      rxLen = 0;
+      if (CrsfCrc8::calc(&rxFrame[2], framelen - 1) != rxFrame[framelen + 1]) continue;
+      rxValid = true;
+      if (rxFrame[2] != CRSF_FRAMETYPE_COMMAND || framelen < 9) continue;
+      if (CrsfCmdCrc8::calc(&rxFrame[2], framelen - 2) != rxFrame[framelen]) continue;
+      if (rxFrame[3] == CRSF_ADDRESS_CRSF_RECEIVER &&
+          rxFrame[5] == CRSF_COMMAND_SUBCMD_GENERAL &&
+          rxFrame[6] == CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_RESPONSE)
+        speedReply = rxFrame[8] ? 1 : 0;
+    }
+  }
 }
 
 void CRSF::sendLinkStatisticsToFC()
@@ -56,42 +258,115 @@ void CRSF::sendLinkStatisticsToFC()
 
   memcpy(outBuffer + 3, (void *)&LinkStatistics, LinkStatisticsFrameLength);
 
-  Crc8 _crc(0xd5);
-  uint8_t crc = _crc.calc(&outBuffer[2], LinkStatisticsFrameLength + 1);
+  uint8_t crc = CrsfCrc8::calc(&outBuffer[2], LinkStatisticsFrameLength + 1);
 
   outBuffer[LinkStatisticsFrameLength + 3] = crc;
 
-  AuxSerial_Write(outBuffer, LinkStatisticsFrameLength + 4);
+  queueFrame(outBuffer, LinkStatisticsFrameLength + 4);
 }
 
-void CRSF::sendRCFrameToFC()
+void CRSF::queueFrame(const uint8_t *frame, uint8_t len)
+{
+  AuxSerial_Write(frame, len);
+  slotBytes += len;
+}
+
+/* Called after each RC frame with the frame period in us. Sends whichever telemetry is due
+ *  and fits in the bytes the line can still carry before the next RC frame
+ */
+
+void CRSF::sendTelemetry(const float quat[4], float battery, uint32_t period)
 {
-  // Fix me properly, also merge CRSF better one day.
-
-  // Check the inversion status of the TX pin
-  static bool crsfoutinv = false;
-  if (crsfoutinv != trkset.getCrsfTxInv()) {
-    crsfoutinv = trkset.getCrsfTxInv();
-    // Close and re-open port with new settings
-    AuxSerial_Close();
-    uint8_t inversion = 0;
-    if (crsfoutinv) inversion |= CONFINV_TX;
-    AuxSerial_Open(BAUD400000, CONF8N1, inversion);
+  uint32_t capacity = slotCapacity(crsfBauds[baudIndex].baudrate, period);
+  int64_t now = k_uptime_get();
+
+  while (true) {
+    int next = -1;
+    for (int i = 0; i < CRSF_TLM_COUNT; i++) {
+      if (i == CRSF_TLM_BATTERY && battery < 0) continue;
+      if (now < telemetryDue[i] || slotBytes + crsfTelemetry[i].len > capacity) continue;
+      if (next < 0 || telemetryDue[i] < telemetryDue[next]) next = i;
+    }
+    if (next < 0) return;
+    telemetryDue[next] = now + crsfTelemetry[next].period;
+
+    switch (next) {
+      case CRSF_TLM_LINKSTATS: {
+        // Wired, the link is always perfect
+        uint32_t rate = 1000000 / period;
+        uint8_t rfmode = RATE_LORA_4HZ;
+        for (unsigned int i = 0; i < sizeof(crsfRfModes) / sizeof(crsfRfModes[0]); i++) {
+          if (rate >= crsfRfModes[i].rate) {
+            rfmode = crsfRfModes[i].mode;
+            break;
+          }
+        }
+        LinkStatistics.uplink_RSSI_1 = 0;
+        LinkStatistics.uplink_RSSI_2 = 0;
+        LinkStatistics.uplink_Link_quality = 100;
+        LinkStatistics.uplink_SNR = 0;
+        LinkStatistics.active_antenna = 0;
+        LinkStatistics.rf_Mode = rfmode;
+        LinkStatistics.uplink_TX_Power = 0;
+        LinkStatistics.downlink_RSSI = 0;
+        LinkStatistics.downlink_Link_quality = 100;
+        LinkStatistics.downlink_SNR = 0;
+        sendLinkStatisticsToFC();
+        break;
+      }
+      case CRSF_TLM_ATTITUDE: {
+        // Angles as sense.cpp takes them from the quaternion, the Madgwick roll is the head tilt
+        float q0 = quat[0], q1 = quat[1], q2 = quat[2], q3 = quat[3];
+        float tilt = atan2f(q0 * q1 + q2 * q3, 0.5f - q1 * q1 - q2 * q2);
+        float roll = asinf(fmaxf(-1.0f, fminf(1.0f, -2.0f * (q1 * q3 - q0 * q2))));
+        float pan = atan2f(q1 * q2 + q0 * q3, 0.5f - q2 * q2 - q3 * q3);
+        AttitudeDataOut.pitch = htobe16((int16_t)(tilt * 10000.0f));  // 100 urad
+        AttitudeDataOut.roll = htobe16((int16_t)(roll * 10000.0f));
+        AttitudeDataOut.yaw = htobe16((int16_t)(pan * 10000.0f));
+        sendAttitideToFC();
+        break;
+      }
+      case CRSF_TLM_BATTERY:
+        sendBatteryToFC(battery);
+        break;
+    }
   }
+}
+
+void CRSF::sendBatteryToFC(float volts)
+{
+  uint8_t outBuffer[CRSF_FRAME_BATTERY_SENSOR_PAYLOAD_SIZE + 4] = {0};
+
+  outBuffer[0] = CRSF_ADDRESS_FLIGHT_CONTROLLER;
+  outBuffer[1] = CRSF_FRAME_BATTERY_SENSOR_PAYLOAD_SIZE + 2;
+  outBuffer[2] = CRSF_FRAMETYPE_BATTERY_SENSOR;
+
+  // Voltage in 0.1V big endian. No current, capacity or remaining
+  uint16_t decivolts = volts * 10.0f + 0.5f;
+  outBuffer[3] = decivolts >> 8;
+  outBuffer[4] = decivolts;
 
+  outBuffer[CRSF_FRAME_BATTERY_SENSOR_PAYLOAD_SIZE + 3] =
+      CrsfCrc8::calc(&outBuffer[2], CRSF_FRAME_BATTERY_SENSOR_PAYLOAD_SIZE + 1);
+
+  queueFrame(outBuffer, CRSF_FRAME_BATTERY_SENSOR_PAYLOAD_SIZE + 4);
+}
+
+void CRSF::sendRCFrameToFC()
+{
   uint8_t outBuffer[RCframeLength + 4] = {0};
 
   outBuffer[0] = CRSF_ADDRESS_FLIGHT_CONTROLLER;
   outBuffer[1] = RCframeLength + 2;
   outBuffer[2] = CRSF_FRAMETYPE_RC_CHANNELS_PACKED;
 
-  memcpy(outBuffer + 3, (void *)&PackedRCdataOut, RCframeLength);
-  Crc8 _crc(CRSF_CRC_POLY);
-  uint8_t crc = _crc.calc(&outBuffer[2], RCframeLength + 1);
+  memcpy(outBuffer + 3, (void *)PackedRCdataOut, RCframeLength);
+  uint8_t crc = CrsfCrc8::calc(&outBuffer[2], RCframeLength + 1);
 
   outBuffer[RCframeLength + 3] = crc;
 
-  AuxSerial_Write(outBuffer, RCframeLength + 4);
+  slotBytes = 0;
+  queueFrame(outBuffer, RCframeLength + 4);
 }
 
 void CRSF::sendAttitideToFC()
@@ -102,11 +377,10 @@ void CRSF::sendAttitideToFC()
   outBuffer[1] = CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE + 2;
   outBuffer[2] = CRSF_FRAMETYPE_ATTITUDE;
 
-  memcpy(outBuffer + 3, (void *)&PackedRCdataOut, CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE);
-  Crc8 _crc(CRSF_CRC_POLY);
-  uint8_t crc = _crc.calc(&outBuffer[2], CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE + 1);
+  memcpy(outBuffer + 3, (void *)&AttitudeDataOut, CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE);
+  uint8_t crc = CrsfCrc8::calc(&outBuffer[2], CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE + 1);
 
   outBuffer[CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE + 3] = crc;
 
-  AuxSerial_Write(outBuffer, CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE + 4);
+  queueFrame(outBuffer, CRSF_FRAME_ATTITUDE_PAYLOAD_SIZE + 4);
 }
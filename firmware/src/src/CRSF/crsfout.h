@@ -96,6 +96,9 @@ static inline uint16_t BIT_to_CRSF(uint8_t Val)
 
 static inline uint16_t CRSF_to_UINT10(uint16_t Val) { return round(fmap(Val, 172.0, 1811.0, 0.0, 1023.0)); };
 
+// Telemetry frames interleaved with the RC frames
+enum { CRSF_TLM_LINKSTATS, CRSF_TLM_ATTITUDE, CRSF_TLM_BATTERY, CRSF_TLM_COUNT };
+
 class CRSF
 {
 
@@ -127,11 +130,13 @@ public:
 
     /////Variables/////
 
-    static volatile crsf_channels_s PackedRCdataOut;            // RC data in packed format for output.
+    static volatile uint8_t PackedRCdataOut[RCframeLength];     // RC data in packed format for output.
     static volatile crsf_attitude_s AttitudeDataOut;
     static volatile crsfPayloadLinkstatistics_s LinkStatistics; // Link Statisitics Stored as Struct
 
     static void Begin(); //setup timers etc
+    static void loop();           // Reads replies from the FC
+    static void negotiateSpeed(uint32_t period); // Proposes CrsfTxBaud, call from the sending thread
 
     static void duplex_set_RX();
     static void duplex_set_TX();
@@ -148,6 +153,8 @@ public:
     void sendLinkStatisticsToFC();
     void sendLinkStatisticsToTX();
     void sendAttitideToFC();
+    void sendBatteryToFC(float volts);
+    void sendTelemetry(const float quat[4], float battery, uint32_t period);
 
     //static void BuildRCPacket(crsf_addr_e addr = CRSF_ADDRESS_FLIGHT_CONTROLLER); //build packet to send to the FC
 
@@ -168,6 +175,25 @@ private:
 
     static volatile bool ignoreSerialData; //since we get a copy of the serial data use this flag to know when to ignore it
     static volatile bool CRSFframeActive;  //since we get a copy of the serial data use this flag to know when to ignore it
+
+    static void openPort();
+    static void sendSpeedProposal(uint32_t baudrate);
+
+    static bool txInverted;
+    static uint8_t baudIndex;              // Baud rate in use
+    static uint8_t proposedIndex;          // Baud rate asked for
+    static uint8_t proposalsLeft;
+    static int64_t nextProposal;
+    static volatile int8_t speedReply;     // Set by loop() when the FC answers a proposal
+    static volatile bool rxValid;          // Set by loop() on any valid frame from the FC
+    static int64_t lastRxValid;
+    static uint8_t rxFrame[CRSF_FRAME_SIZE_MAX];
+    static uint8_t rxLen;
+
+    static void queueFrame(const uint8_t *frame, uint8_t len);
+
+    static uint32_t slotBytes;             // Queued since the last RC frame
+    static int64_t telemetryDue[CRSF_TLM_COUNT];
 };
 
 extern CRSF crsfout;
\ No newline at end of file
@@ -22,6 +22,7 @@
 
 #include "defines.h"
 #include "io.h"
+#include "ringbuffer.h"
 #include "trackersettings.h"
 
 LOG_MODULE_REGISTER(ppmin);
@@ -42,13 +43,20 @@ static bool framestarted = false;
 static bool ppminstarted = false;
 static bool ppminverted = false;
 
-// Used in ISR
-static uint16_t isrchannels[16];
-static int isrch_count = 0;
+// Pulse widths captured by PPI. The ISR only queues them, they are decoded in batch by
+//  PpmIn_execute from the calculate thread
+#define PPMIN_RING_SIZE 64  // Power of two, a few frames
+static ringbuffer<uint16_t, PPMIN_RING_SIZE> pulsering;
+static volatile uint32_t ringdrops = 0;
 
-// Used to read data at once, read with isr disabled
-static uint16_t channels[16];
-static int ch_count = 0;
+// Channels of the frame being decoded
+static uint16_t decodechannels[16];
+static int decodech_count = 0;
+
+// Complete frames, readyframe is the latest. The decoder fills the other then swaps
+static uint16_t channels[2][16];
+static int ch_count[2] = {0, 0};
+static volatile int readyframe = 0;
 
 static volatile uint64_t runtime = 0;
 
@@ -60,36 +68,44 @@ ISR_DIRECT_DECLARE(PPMInGPIOTE_ISR)
     // Clear Flag
     NRF_GPIOTE->EVENTS_IN[PPMIN_GPIOTE] = 0;
 
-    // Read Timer Captured Value
+    // Queue the Timer Captured Value
     uint32_t time = PPMIN_TIMER->CC[PPMIN_TMRCOMP_CH];
+    if (!pulsering.push(MIN(time, UINT16_MAX))) ringdrops++;
+  }
 
+  ISR_DIRECT_FOOTER(1);
+  return 0;
+}
+
+// Decodes all queued pulses into frames
+static void decodePulses()
+{
+  uint16_t time;
+  while (pulsering.pop(time)) {
     // Long pulse = Start.. Minimum frame sync is 3ms.. Giving a 10us leway
     if (time > 2990) {
-      // Copy all data to another buffer so it can be read complete
-      for (int i = 0; i < 16; i++) {
-        ch_count = isrch_count;
-        channels[i] = isrchannels[i];
-      }
-      isrch_count = 0;
+      // Publish the frame in the other buffer so it can be read complete
+      int next = !readyframe;
+      memcpy(channels[next], decodechannels, sizeof(decodechannels));
+      ch_count[next] = decodech_count;
+      readyframe = next;
+      decodech_count = 0;
       framestarted = true;
 
       // Used to check if a signal is here
       runtime = micros64();
 
       // Valid Ch Range
-    } else if (time > 900 && time < 2100 && framestarted == true && isrch_count < 16) {
-      isrchannels[isrch_count] = time;
-      isrch_count++;
+    } else if (time > 900 && time < 2100 && framestarted == true && decodech_count < 16) {
+      decodechannels[decodech_count] = time;
+      decodech_count++;
 
       // Fault, Reset
     } else {
-      isrch_count = 0;
+      decodech_count = 0;
       framestarted = false;
     }
   }
-
-  ISR_DIRECT_FOOTER(1);
-  return 0;
 }
 
 // Set pin to -1 to disable
@@ -213,19 +229,26 @@ static int cyclescount = 0;  // Count this many cycles before showing data
 void PpmIn_execute()
 {
   static bool sentconn = false;
+  static uint32_t lastdrops = 0;
+
+  decodePulses();
+  if (ringdrops != lastdrops) {
+    LOG_WRN("PPM Input dropped %u pulses", ringdrops - lastdrops);
+    lastdrops = ringdrops;
+  }
 
   if (micros64() - runtime > 60000) {
     if (sentconn == false) {
       LOG_INF("PPM Input Data Lost");
       sentconn = true;
-      ch_count = 0;
+      ch_count[readyframe] = 0;
     }
     cyclescount = 0;  // No Data
   } else {
     if (cyclescount < cyclesbeforeppm)
       cyclescount++;
     else {
-      if (sentconn == true && ch_count >= 4 && ch_count <= 16) {
+      if (sentconn == true && ch_count[readyframe] >= 4 && ch_count[readyframe] <= 16) {
         LOG_INF("PPM Input Data Received");
         sentconn = false;
       }
@@ -244,12 +267,12 @@ int PpmIn_getChannels(uint16_t *ch)
 {
   if (!ppminstarted || cyclescount < cyclesbeforeppm) return 0;
 
-  __disable_irq();
-  for (int i = 0; i < ch_count; i++) {
-    ch[i] = channels[i];
+  // Frames are only swapped by the decoder, no need to lock
+  int frame = readyframe;
+  int rval = ch_count[frame];
+  for (int i = 0; i < rval; i++) {
+    ch[i] = channels[frame][i];
   }
-  int rval = ch_count;
-  __enable_irq();
 
   return rval;
 }
@@ -28,21 +28,28 @@
 LOG_MODULE_REGISTER(ppmout);
 
 #if defined(CONFIG_SOC_SERIES_NRF52X) && defined(HAS_PPMOUT)
-#include <nrfx_gpiote.h>
-#include <nrfx_ppi.h>
+#include <hal/nrf_pwm.h>
 
-#define PPMOUT_PPICH_MSK CONCAT(CONCAT(PPI_CHENSET_CH, PPMOUT_PPICH), _Msk)
-#define PPMOUT_TIMER CONCAT(NRF_TIMER, PPMOUT_TIMER_CH)
-#define PPMOUT_TIMER_IRQNO CONCAT(CONCAT(TIMER, PPMOUT_TIMER_CH), _IRQn)
-#define PPMOUT_TMRCOMP_CH_MSK CONCAT(CONCAT(TIMER_INTENSET_COMPARE, PPMOUT_TMRCOMP_CH), _Msk)
+#define PPMOUT_PWM CONCAT(NRF_PWM, PPMOUT_PWM_CH)
+#define PPMOUT_PWM_IRQNO CONCAT(CONCAT(PWM, PPMOUT_PWM_CH), _IRQn)
+
+/* The PWM peripheral plays the whole frame out of RAM with EasyDMA, one PWM period per
+ *  channel. The period is the channel value and the compare is the sync pulse. The CPU
+ *  only runs once per frame to queue the next one, so edges don't jitter with the ISR
+ *
+ *  In WaveForm mode each period is four values, the compare for the PPM pin on OUT[0],
+ *  two unused compares and the period length
+ */
+#define PPMOUT_PERIOD_VALUES 4
+#define PPMOUT_MAX_PERIODS (16 + 2)  // Channels then the last sync and frame sync
+#define PPMOUT_MAX_TOP 32767
+#define PPMOUT_POLARITY_HIGH 0x8000  // Pin starts high in the period, low after compare
 
 volatile bool interrupt = false;
 
 static volatile bool ppmoutstarted = false;
 static volatile bool ppmoutinverted = false;
 
-// Used in ISR
-// Used to read data at once, read with isr disabled
 static uint16_t ch_values[16];
 static int ch_count;
 
@@ -50,17 +57,26 @@ static uint16_t framesync = TrackerSettings::PPM_MIN_FRAMESYNC;  // Minimum Fram
 static int32_t framelength;     // Ideal frame length
 static uint16_t sync;            // Sync Pulse Length
 
-// Local data - Only build with interrupts disabled
-static uint32_t chsteps[35]{framesync, sync};
-
-// ISR Values - Values from chsteps are copied here on step 0.
-// prevent an update from happening mid stream.
-static uint32_t isrchsteps[35]{framesync, sync};
-static uint16_t chstepcnt = 1;
-static uint16_t curstep = 0;
+// Local data - Next frame, built from the channel values
+static uint16_t frame[PPMOUT_MAX_PERIODS * PPMOUT_PERIOD_VALUES];
+static uint16_t framecnt = 0;
+static volatile uint32_t frameversion = 0;
 volatile bool buildingdata = false;
 
-/* Builds an array with all the transition times
+// Sequences played by the PWM, 0 and 1 alternate each frame. The one not playing is
+// updated from frame when the other starts
+static uint16_t seqframe[2][PPMOUT_MAX_PERIODS * PPMOUT_PERIOD_VALUES];
+static uint32_t seqversion[2];
+
+static void addPeriod(int &cnt, uint16_t compare, uint16_t top)
+{
+  frame[cnt++] = compare | (ppmoutinverted ? PPMOUT_POLARITY_HIGH : 0);
+  frame[cnt++] = 0;
+  frame[cnt++] = 0;
+  frame[cnt++] = top;
+}
+
+/* Builds the PWM sequence for the frame
  */
 void buildChannels()
 {
@@ -71,26 +87,29 @@ void buildChannels()
   sync = trkset.getPpmSync();
   framelength = trkset.getPpmFrame();
 
-  int ch = 0;
-  int i;
-  uint32_t curtime = framesync;
-  chsteps[0] = curtime;
-  for (i = 1; i < ch_count * 2 + 1; i += 2) {
-    curtime += sync;
-    chsteps[i] = curtime;
-    curtime += (ch_values[ch++] - sync);
-    chsteps[i + 1] = curtime;
+  int cnt = 0;
+  int32_t curtime = 0;
+  for (int ch = 0; ch < ch_count; ch++) {
+    addPeriod(cnt, sync, ch_values[ch]);
+    curtime += ch_values[ch];
   }
-  // Add Final Sync
-  curtime += sync;
-  chsteps[i++] = curtime;
-  chstepcnt = i;
+
   // Now we know how long the train is. Try to make the entire frame == framelength
   // If possible it will add this to the frame sync pulse
-  int ft = framelength - curtime;
-  if (ft < 0)  // Not possible, no time left
-    ft = 0;
-  chsteps[i] = ft;  // Store at end of sequence
+  int32_t idle = framelength - curtime - sync;
+  if (idle < framesync)  // Not possible, use the minimum
+    idle = framesync;
+
+  // Final sync then the frame sync. Split in two if it doesn't fit one period,
+  // the second has no pulse
+  if (sync + idle > PPMOUT_MAX_TOP) {
+    addPeriod(cnt, sync, sync + idle / 2);
+    addPeriod(cnt, 0, idle - idle / 2);
+  } else {
+    addPeriod(cnt, sync, sync + idle);
+  }
+  framecnt = cnt;
+  frameversion++;
   buildingdata = false;
 }
 
@@ -100,36 +119,20 @@ void resetChannels()
   for (int i = 0; i < 16; i++) ch_values[i] = 1500;
 }
 
-ISR_DIRECT_DECLARE(PPMTimerISR)
+// Sequence started, queue the latest frame into the other one
+void PPMOutPWM_isr(const void *)
 {
-  ISR_DIRECT_HEADER();
-  if (PPMOUT_TIMER->EVENTS_COMPARE[PPMOUT_TMRCOMP_CH] == 1) {
-    // Clear event
-    PPMOUT_TIMER->EVENTS_COMPARE[PPMOUT_TMRCOMP_CH] = 0;
-
-    // Reset, don't get stuck in the wrong signal level
-    if (curstep == 0) {
-      if (ppmoutinverted)
-        NRF_GPIOTE->TASKS_SET[PPMOUT_GPIOTE] = 1;
-      else
-        NRF_GPIOTE->TASKS_CLR[PPMOUT_GPIOTE] = 1;
-    }
-
-    curstep++;
-    // Loop
-    if (curstep >= chstepcnt) {
-      if (!buildingdata) memcpy(isrchsteps, chsteps, sizeof(uint32_t) * 35);
-      PPMOUT_TIMER->TASKS_CLEAR = 1;
-      curstep = 0;
+  for (int seq = 0; seq < 2; seq++) {
+    if (PPMOUT_PWM->EVENTS_SEQSTARTED[seq] == 1) {
+      PPMOUT_PWM->EVENTS_SEQSTARTED[seq] = 0;
+      int next = !seq;
+      if (seqversion[next] != frameversion && !buildingdata) {
+        memcpy(seqframe[next], frame, framecnt * sizeof(uint16_t));
+        PPMOUT_PWM->SEQ[next].CNT = framecnt << PWM_SEQ_CNT_CNT_Pos;
+        seqversion[next] = frameversion;
+      }
     }
-
-    // Setup next capture event value
-    PPMOUT_TIMER->CC[PPMOUT_TMRCOMP_CH] =
-        isrchsteps[curstep] +
-        isrchsteps[chstepcnt];  // Offset by the extra time required to make frame length right
   }
-  ISR_DIRECT_FOOTER(1);
-  return 0;
 }
 
 // Set pin to -1 to disable
@@ -145,33 +148,32 @@ void PpmOut_startStop(bool stop)
   }
 
   // Start by disabling
+  irq_disable(PPMOUT_PWM_IRQNO);
+  PPMOUT_PWM->INTENCLR = PWM_INTENCLR_SEQSTARTED0_Msk | PWM_INTENCLR_SEQSTARTED1_Msk;
+
+  // The stop takes effect at the end of the current period, wait for it so disabling doesn't
+  //  cut a pulse short and leave the pin at the wrong level
+  if (ppmoutstarted) {
+    PPMOUT_PWM->SHORTS = 0;
+    PPMOUT_PWM->EVENTS_STOPPED = 0;
+    PPMOUT_PWM->TASKS_STOP = 1;
+    for (int i = 0; i < PPMOUT_MAX_TOP / 10 + 10 && !PPMOUT_PWM->EVENTS_STOPPED; i++)
+      k_busy_wait(10);
+    PPMOUT_PWM->EVENTS_STOPPED = 0;
+  }
 
   // Stop Interrupts
   uint32_t key = irq_lock();
 
-  // Disable Timer 3 Interrupt
-  irq_disable(PPMOUT_TIMER_IRQNO);
-
-  // Stop Timer
-  PPMOUT_TIMER->TASKS_STOP = 1;
-
-  // Stop Interrupt on peripherial
-  PPMOUT_TIMER->INTENCLR = PPMOUT_TMRCOMP_CH_MSK;
-
-  // Clear interrupt flag
-  PPMOUT_TIMER->EVENTS_COMPARE[PPMOUT_TMRCOMP_CH] = 0;
-  NRF_GPIOTE->CONFIG[PPMOUT_GPIOTE] = 0;  // Disable Config
-
-  // Disable PPI
-  NRF_PPI->CHENCLR = PPMOUT_PPICH_MSK;
+  PPMOUT_PWM->SHORTS = 0;
+  PPMOUT_PWM->ENABLE = PWM_ENABLE_ENABLE_Disabled << PWM_ENABLE_ENABLE_Pos;
+  ppmoutstarted = false;
 
   // If we want to enable it....
   if (stop == false) {
-    // Setup GPOITE[7] to toggle output on every timer capture
-    NRF_GPIOTE->CONFIG[PPMOUT_GPIOTE] =
-        (GPIOTE_CONFIG_MODE_Task << GPIOTE_CONFIG_MODE_Pos) |
-        (GPIOTE_CONFIG_POLARITY_Toggle << GPIOTE_CONFIG_POLARITY_Pos) |
-        (pin << GPIOTE_CONFIG_PSEL_Pos) | (port << GPIOTE_CONFIG_PORT_Pos);
+    // Pin idles at the level between pulses
+    pinMode(IO_PPMOUT, GPIO_OUTPUT);
+    digitalWrite(IO_PPMOUT, !ppmoutinverted);
 
     // High Drive PPM Output Pin
     if (port == 0)
@@ -181,35 +183,36 @@ void PpmOut_startStop(bool stop)
       NRF_P1->PIN_CNF[pin] = (NRF_P1->PIN_CNF[pin] & ~GPIO_PIN_CNF_DRIVE_Msk) |
                              GPIO_PIN_CNF_DRIVE_H0H1 << GPIO_PIN_CNF_DRIVE_Pos;
 
-    // Start Timers, they can stay running all the time.
-    PPMOUT_TIMER->PRESCALER = 4;  // 16Mhz/2^(4) = 1Mhz = 1us Resolution, 1.048s Max@32bit
-    PPMOUT_TIMER->MODE = TIMER_MODE_MODE_Timer << TIMER_MODE_MODE_Pos;
-    PPMOUT_TIMER->BITMODE = TIMER_BITMODE_BITMODE_16Bit << TIMER_BITMODE_BITMODE_Pos;
-
-    // On Compare equals Value, Toggle IO Pin
-    NRF_PPI->CH[PPMOUT_PPICH].EEP = (uint32_t)&PPMOUT_TIMER->EVENTS_COMPARE[PPMOUT_TMRCOMP_CH];
-    NRF_PPI->CH[PPMOUT_PPICH].TEP = (uint32_t)&NRF_GPIOTE->TASKS_OUT[PPMOUT_GPIOTE];
-
-    // Enable PPI
-    NRF_PPI->CHENSET = PPMOUT_PPICH_MSK;
-
-    // Start
-    IRQ_DIRECT_CONNECT(PPMOUT_TIMER_IRQNO, 0, PPMTimerISR, IRQ_ZERO_LATENCY);
+    PPMOUT_PWM->PSEL.OUT[0] = (pin << PWM_PSEL_OUT_PIN_Pos) | (port << PWM_PSEL_OUT_PORT_Pos) |
+                              (PWM_PSEL_OUT_CONNECT_Connected << PWM_PSEL_OUT_CONNECT_Pos);
+    PPMOUT_PWM->ENABLE = PWM_ENABLE_ENABLE_Enabled << PWM_ENABLE_ENABLE_Pos;
+    PPMOUT_PWM->MODE = PWM_MODE_UPDOWN_Up << PWM_MODE_UPDOWN_Pos;
+    PPMOUT_PWM->PRESCALER =
+        PWM_PRESCALER_PRESCALER_DIV_16 << PWM_PRESCALER_PRESCALER_Pos;  // 1Mhz 1uS Resolution
+    PPMOUT_PWM->DECODER = (PWM_DECODER_LOAD_WaveForm << PWM_DECODER_LOAD_Pos) |
+                          (PWM_DECODER_MODE_RefreshCount << PWM_DECODER_MODE_Pos);
+
+    // Both sequences start with the current frame
+    for (int seq = 0; seq < 2; seq++) {
+      memcpy(seqframe[seq], frame, framecnt * sizeof(uint16_t));
+      PPMOUT_PWM->SEQ[seq].PTR = (uint32_t)seqframe[seq] << PWM_SEQ_PTR_PTR_Pos;
+      PPMOUT_PWM->SEQ[seq].CNT = framecnt << PWM_SEQ_CNT_CNT_Pos;
+      PPMOUT_PWM->SEQ[seq].REFRESH = 0;
+      PPMOUT_PWM->SEQ[seq].ENDDELAY = 0;
+      PPMOUT_PWM->EVENTS_SEQSTARTED[seq] = 0;
+      seqversion[seq] = frameversion;
+    }
 
-    // Start timer
-    memcpy(isrchsteps, chsteps, sizeof(uint32_t) * 32);
-    PPMOUT_TIMER->CC[PPMOUT_TMRCOMP_CH] = framesync;
-    curstep = 0;
-    PPMOUT_TIMER->TASKS_CLEAR = 1;
-    PPMOUT_TIMER->TASKS_START = 1;
+    // Play sequence 0 then 1, forever
+    PPMOUT_PWM->LOOP = 1 << PWM_LOOP_CNT_Pos;
+    PPMOUT_PWM->SHORTS = PWM_SHORTS_LOOPSDONE_SEQSTART0_Msk;
 
-    irq_enable(PPMOUT_TIMER_IRQNO);
+    IRQ_CONNECT(PPMOUT_PWM_IRQNO, 2, PPMOutPWM_isr, NULL, 0);
+    PPMOUT_PWM->INTENSET = PWM_INTENSET_SEQSTARTED0_Msk | PWM_INTENSET_SEQSTARTED1_Msk;
+    irq_enable(PPMOUT_PWM_IRQNO);
 
+    PPMOUT_PWM->TASKS_SEQSTART[0] = 1;
     ppmoutstarted = true;
-
-    // Enable timer interrupt
-    PPMOUT_TIMER->EVENTS_COMPARE[PPMOUT_TMRCOMP_CH] = 0;
-    PPMOUT_TIMER->INTENSET = PPMOUT_TMRCOMP_CH_MSK;
   }
 
   irq_unlock(key);
@@ -219,6 +222,8 @@ void PpmOut_execute()
 {
   if(trkset.getPpmOutInvert() != ppmoutinverted) {
     ppmoutinverted = trkset.getPpmOutInvert();
+    buildChannels();
+    PpmOut_startStop();  // Restart with the new idle level
   }
 }
 
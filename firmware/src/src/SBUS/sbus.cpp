@@ -22,6 +22,7 @@
 #include <string.h>
 
 #include "auxserial.h"
+#include "chcodec.h"
 #include "io.h"
 
 #include "soc_flash.h"
@@ -77,46 +78,79 @@ void SbusTx()
   SBUS_TX_Start();
 }
 
-uint8_t buf_[SBUS_FRAME_LEN];
-int bytesfilled = 0;
+// Bytes are read from the aux serial in spans of this size
+#define SBUS_READ_CHUNK 32
+
+// SBUS value to PPM microseconds, clipped to the PWM limits. Built at compile time
+struct SbusToPpm {
+  uint16_t us[2048];
+  constexpr SbusToPpm() : us()
+  {
+    for (int i = 0; i < 2048; i++) us[i] = ChCodec::SbusToUs::map(i);
+  }
+};
+static constexpr SbusToPpm sbusToPpm;
+
+uint8_t buf_[SBUS_FRAME_LEN];    // Frame being received
+uint8_t frame_[SBUS_FRAME_LEN];  // Last complete frame
 int8_t state_ = 0;
 uint8_t prev_byte_ = FOOTER_;
-uint8_t cur_byte_;
+
+static uint8_t rxspan[SBUS_READ_CHUNK];
+static int rxspanlen = 0;
+static int rxspanpos = 0;
+
+static inline bool isFooter(uint8_t byte) { return byte == FOOTER_ || (byte & 0x0F) == FOOTER2_; }
 
 /* FROM -----
  * Brian R Taylor
  * brian.taylor@bolderflight.com
  *
  * Copyright (c) 2021 Bolder Flight Systems Inc
+ *
+ * Reworked to parse spans of bytes read at once. Returns true when a frame has been
+ * received into frame_, bytes after it are kept for the next call
  */
 
 bool SbusRx_Parse()
 {
-  /* Parse messages */
-  while (AuxSerial_Read(&cur_byte_, 1)) {
-    if (state_ == 0) {
-      if ((cur_byte_ == HEADER_) &&
-          ((prev_byte_ == FOOTER_) || ((prev_byte_ & 0x0F) == FOOTER2_))) {
-        buf_[state_++] = cur_byte_;
-      } else {
-        state_ = 0;
+  while (true) {
+    if (rxspanpos >= rxspanlen) {
+      rxspanlen = AuxSerial_Read(rxspan, sizeof(rxspan));
+      rxspanpos = 0;
+      if (rxspanlen == 0) return false;
+    }
+
+    // Resync, a header following a footer
+    while (state_ == 0 && rxspanpos < rxspanlen) {
+      uint8_t cur_byte_ = rxspan[rxspanpos++];
+      if (cur_byte_ == HEADER_ && isFooter(prev_byte_)) buf_[state_++] = cur_byte_;
+      prev_byte_ = cur_byte_;
+    }
+
+    // Payload, copy as much as the span has
+    if (state_ > 0 && state_ < PAYLOAD_LEN_ + HEADER_LEN_) {
+      int len = MIN(rxspanlen - rxspanpos, PAYLOAD_LEN_ + HEADER_LEN_ - state_);
+      if (len > 0) {
+        memcpy(&buf_[state_], &rxspan[rxspanpos], len);
+        state_ += len;
+        rxspanpos += len;
+        prev_byte_ = rxspan[rxspanpos - 1];
       }
-    } else if (state_ < PAYLOAD_LEN_ + HEADER_LEN_) {
-      buf_[state_++] = cur_byte_;
-    } else if (state_ < PAYLOAD_LEN_ + HEADER_LEN_ + FOOTER_LEN_) {
+    }
+
+    // Footer
+    if (state_ == PAYLOAD_LEN_ + HEADER_LEN_ && rxspanpos < rxspanlen) {
+      uint8_t cur_byte_ = rxspan[rxspanpos++];
       state_ = 0;
       prev_byte_ = cur_byte_;
-      if ((cur_byte_ == FOOTER_) || ((cur_byte_ & 0x0F) == FOOTER2_)) {
+      if (isFooter(cur_byte_)) {
+        buf_[PAYLOAD_LEN_ + HEADER_LEN_] = cur_byte_;
+        memcpy(frame_, buf_, SBUS_FRAME_LEN);
         return true;
-      } else {
-        return false;
       }
-    } else {
-      state_ = 0;
     }
-    prev_byte_ = cur_byte_;
   }
-  return false;
 }
 
 bool SbusReadChannels(uint16_t ch_[16])
@@ -128,27 +162,9 @@ bool SbusReadChannels(uint16_t ch_[16])
     newdata = true;
   }
   if (newdata) {
-    ch_[0] = static_cast<int16_t>(buf_[1] | ((buf_[2] << 8) & 0x07FF));
-    ch_[1] = static_cast<int16_t>(buf_[2] >> 3 | ((buf_[3] << 5) & 0x07FF));
-    ch_[2] = static_cast<int16_t>(buf_[3] >> 6 | ((buf_[4] << 2) | ((buf_[5] << 10) & 0x07FF)));
-    ch_[3] = static_cast<int16_t>(buf_[5] >> 1 | ((buf_[6] << 7) & 0x07FF));
-    ch_[4] = static_cast<int16_t>(buf_[6] >> 4 | ((buf_[7] << 4) & 0x07FF));
-    ch_[5] = static_cast<int16_t>(buf_[7] >> 7 | ((buf_[8] << 1) | ((buf_[9] << 9) & 0x07FF)));
-    ch_[6] = static_cast<int16_t>(buf_[9] >> 2 | ((buf_[10] << 6) & 0x07FF));
-    ch_[7] = static_cast<int16_t>(buf_[10] >> 5 | ((buf_[11] << 3) & 0x07FF));
-    ch_[8] = static_cast<int16_t>(buf_[12] | ((buf_[13] << 8) & 0x07FF));
-    ch_[9] = static_cast<int16_t>(buf_[13] >> 3 | ((buf_[14] << 5) & 0x07FF));
-    ch_[10] = static_cast<int16_t>(buf_[14] >> 6 | ((buf_[15] << 2) | ((buf_[16] << 10) & 0x07FF)));
-    ch_[11] = static_cast<int16_t>(buf_[16] >> 1 | ((buf_[17] << 7) & 0x07FF));
-    ch_[12] = static_cast<int16_t>(buf_[17] >> 4 | ((buf_[18] << 4) & 0x07FF));
-    ch_[13] = static_cast<int16_t>(buf_[18] >> 7 | ((buf_[19] << 1) | ((buf_[20] << 9) & 0x07FF)));
-    ch_[14] = static_cast<int16_t>(buf_[20] >> 2 | ((buf_[21] << 6) & 0x07FF));
-    ch_[15] = static_cast<int16_t>(buf_[21] >> 5 | ((buf_[22] << 3) & 0x07FF));
+    ChCodec::unpack(&frame_[1], ch_);
     for (int i = 0; i < 16; i++) {  // Shift + Scale SBUS to PPM Range
-      ch_[i] = (((float)ch_[i] - TrackerSettings::SBUS_CENTER) / TrackerSettings::SBUS_SCALE) +
-               TrackerSettings::PPM_CENTER;
-      if (ch_[i] > TrackerSettings::MAX_PWM) ch_[i] = TrackerSettings::MAX_PWM;
-      if (ch_[i] < TrackerSettings::MIN_PWM) ch_[i] = TrackerSettings::MIN_PWM;
+      ch_[i] = sbusToPpm.us[ch_[i]];
     }
 
 #if defined(DEBUG_SBUS)
@@ -198,28 +214,7 @@ void SbusWriteChannels(uint16_t ch_[16])
   sbusBuildingData = true;
   uint8_t *buf_ = localTXBuffer;
   buf_[0] = HEADER_;
-  buf_[1] = static_cast<uint8_t>((ch_[0] & 0x07FF));
-  buf_[2] = static_cast<uint8_t>((ch_[0] & 0x07FF) >> 8 | (ch_[1] & 0x07FF) << 3);
-  buf_[3] = static_cast<uint8_t>((ch_[1] & 0x07FF) >> 5 | (ch_[2] & 0x07FF) << 6);
-  buf_[4] = static_cast<uint8_t>((ch_[2] & 0x07FF) >> 2);
-  buf_[5] = static_cast<uint8_t>((ch_[2] & 0x07FF) >> 10 | (ch_[3] & 0x07FF) << 1);
-  buf_[6] = static_cast<uint8_t>((ch_[3] & 0x07FF) >> 7 | (ch_[4] & 0x07FF) << 4);
-  buf_[7] = static_cast<uint8_t>((ch_[4] & 0x07FF) >> 4 | (ch_[5] & 0x07FF) << 7);
-  buf_[8] = static_cast<uint8_t>((ch_[5] & 0x07FF) >> 1);
-  buf_[9] = static_cast<uint8_t>((ch_[5] & 0x07FF) >> 9 | (ch_[6] & 0x07FF) << 2);
-  buf_[10] = static_cast<uint8_t>((ch_[6] & 0x07FF) >> 6 | (ch_[7] & 0x07FF) << 5);
-  buf_[11] = static_cast<uint8_t>((ch_[7] & 0x07FF) >> 3);
-  buf_[12] = static_cast<uint8_t>((ch_[8] & 0x07FF));
-  buf_[13] = static_cast<uint8_t>((ch_[8] & 0x07FF) >> 8 | (ch_[9] & 0x07FF) << 3);
-  buf_[14] = static_cast<uint8_t>((ch_[9] & 0x07FF) >> 5 | (ch_[10] & 0x07FF) << 6);
-  buf_[15] = static_cast<uint8_t>((ch_[10] & 0x07FF) >> 2);
-  buf_[16] = static_cast<uint8_t>((ch_[10] & 0x07FF) >> 10 | (ch_[11] & 0x07FF) << 1);
-  buf_[17] = static_cast<uint8_t>((ch_[11] & 0x07FF) >> 7 | (ch_[12] & 0x07FF) << 4);
-  buf_[18] = static_cast<uint8_t>((ch_[12] & 0x07FF) >> 4 | (ch_[13] & 0x07FF) << 7);
-  buf_[19] = static_cast<uint8_t>((ch_[13] & 0x07FF) >> 1);
-  buf_[20] = static_cast<uint8_t>((ch_[13] & 0x07FF) >> 9 | (ch_[14] & 0x07FF) << 2);
-  buf_[21] = static_cast<uint8_t>((ch_[14] & 0x07FF) >> 6 | (ch_[15] & 0x07FF) << 5);
-  buf_[22] = static_cast<uint8_t>((ch_[15] & 0x07FF) >> 3);
+  ChCodec::pack(ch_, &buf_[1]);
   buf_[23] = 0x00 | (ch17_ * CH17_) | (ch18_ * CH18_) | (failsafe_ * FAILSAFE_) |
              (lost_frame_ * LOST_FRAME_);
   buf_[24] = FOOTER_;
@@ -9,8 +9,9 @@ LOG_MODULE_REGISTER(analog);
 
 #if DT_NODE_EXISTS(DT_ALIAS(adcctrl))
 
-// Simple analog input method
-// this just reads a sample then waits then returns it
+// All enabled channels are set up once and then sampled together in a single sequence, the
+//  ADC (SAADC EasyDMA on the nRF) writes every channel of a scan into the buffer in order of
+//  increasing channel number
 
 // ADC Sampling Settings
 // doc says that impedance of 800K == 40usec sample time
@@ -19,85 +20,86 @@ LOG_MODULE_REGISTER(analog);
 #define ADC_GAIN ADC_GAIN_1_6
 #define ADC_REFERENCE ADC_REF_INTERNAL
 #define ADC_ACQUISITION_TIME ADC_ACQ_TIME(ADC_ACQ_TIME_MICROSECONDS, 40)
-#define BUFFER_SIZE 6
-
-static bool _IsInitialized = false;
-static uint8_t _LastChannel = 250;
-static int16_t m_sample_buffer[BUFFER_SIZE];
-
-// the channel configuration with channel not yet filled in
-static struct adc_channel_cfg m_1st_channel_cfg = {
-    .gain = ADC_GAIN,
-    .reference = ADC_REFERENCE,
-    .acquisition_time = ADC_ACQUISITION_TIME,
-    .channel_id = 0,  // gets set during init
-    .differential = 0,
-#if CONFIG_ADC_CONFIGURABLE_INPUTS
-    .input_positive = 0,  // gets set during init
+
+// A single channel is the average of 2^ADC_OVERSAMPLING samples, the SAADC can only oversample
+//  in hardware with one channel. A scan of more reads each once so it only blocks for about
+//  40us a channel, the analog outputs are smoothed by the One Euro filters
+#if defined(CONFIG_SOC_SERIES_NRF52X)
+#define ADC_OVERSAMPLING 2
+#else
+#define ADC_OVERSAMPLING 0
 #endif
-};
 
-// initialize the adc channel
-static const struct device *init_adc(int channel)
+static const struct device *const adc_dev = DEVICE_DT_GET(DT_ALIAS(adcctrl));
+static uint32_t _ConfiguredChannels = 0;
+static int16_t m_sample_buffer[ANALOG_CHANNELS];
+
+// Sets up any channels in the mask that haven't been yet, false on failure
+static bool setupChannels(uint32_t channels)
 {
-  int ret;
-  const struct device *adc_dev = DEVICE_DT_GET(DT_ALIAS(adcctrl));
-  if (!adc_dev) {
-    LOG_ERR("Could not get device binding for ADC");
-    return 0;
-  }
-  if (_LastChannel != channel) {
-    _IsInitialized = false;
-    _LastChannel = channel;
+  if (!device_is_ready(adc_dev)) {
+    LOG_ERR("ADC device not ready");
+    return false;
   }
 
-  if (adc_dev != NULL && !_IsInitialized) {
-    // strangely channel_id gets the channel id and input_positive gets id+1
-    m_1st_channel_cfg.channel_id = channel;
+  uint32_t newchannels = channels & ~_ConfiguredChannels;
+  for (int channel = 0; channel < ANALOG_CHANNELS; channel++) {
+    if (!(newchannels & BIT(channel))) continue;
+
+    struct adc_channel_cfg cfg = {
+        .gain = ADC_GAIN,
+        .reference = ADC_REFERENCE,
+        .acquisition_time = ADC_ACQUISITION_TIME,
+        .channel_id = (uint8_t)channel,
+        .differential = 0,
 #if CONFIG_ADC_CONFIGURABLE_INPUTS
-    m_1st_channel_cfg.input_positive = channel + 1;
+        // strangely channel_id gets the channel id and input_positive gets id+1
+        .input_positive = (uint8_t)(channel + 1),
 #endif
-
-    ret = adc_channel_setup(adc_dev, &m_1st_channel_cfg);
-
-    if (ret != 0) {
-      adc_dev = NULL;
-    } else {
-      _IsInitialized = true;  // we don't have any other analog users
+    };
+    if (adc_channel_setup(adc_dev, &cfg) != 0) {
+      LOG_ERR("Unable to setup ADC channel %d", channel);
+      return false;
     }
+    _ConfiguredChannels |= BIT(channel);
   }
-
-  memset(m_sample_buffer, 0, sizeof(m_sample_buffer));
-  return adc_dev;
+  return true;
 }
 
-
 // ------------------------------------------------
-// read one channel of adc
+// read all channels in the mask in one sequence
 // ------------------------------------------------
-static int16_t readOneChannel(int channel)
+int analogScan(uint32_t channels, analog_snapshot_t *snap)
 {
+  for (int i = 0; i < ANALOG_CHANNELS; i++) snap->volts[i] = BAD_ANALOG_READ;
+  snap->channels = 0;
+
+  channels &= BIT_MASK(ANALOG_CHANNELS);
+  int count = POPCOUNT(channels);
+  if (count == 0) return 0;
+  if (!setupChannels(channels)) return -1;
+
   const struct adc_sequence sequence = {
-      .options = NULL,            // extra samples and callback
-      .channels = BIT(channel),   // bit mask of channels to read
+      .options = NULL,
+      .channels = channels,       // bit mask of channels to read
       .buffer = m_sample_buffer,  // where to put samples read
       .buffer_size = sizeof(m_sample_buffer),
       .resolution = ADC_RESOLUTION,  // desired resolution
-      .oversampling = 0,             // don't oversample
-      .calibrate = 0                 // don't calibrate
+      .oversampling = count == 1 ? (uint8_t)ADC_OVERSAMPLING : (uint8_t)0,
+      .calibrate = 0  // don't calibrate
   };
 
-  int ret;
-  int16_t sample_value = BAD_ANALOG_READ;
-  const struct device *adc_dev = init_adc(channel);
-  if (adc_dev) {
-    ret = adc_read(adc_dev, &sequence);
-    if (ret == 0) {
-      sample_value = m_sample_buffer[0];
-    }
-  }
+  int ret = adc_read(adc_dev, &sequence);
+  snap->timestamp = k_ticks_to_us_floor64(k_uptime_ticks());
+  if (ret != 0) return ret;
 
-  return sample_value;
+  // Samples are in channel order
+  int index = 0;
+  for (int channel = 0; channel < ANALOG_CHANNELS; channel++) {
+    if (!(channels & BIT(channel))) continue;
+    snap->volts[channel] = (float)m_sample_buffer[index++] / 287.0f;
+  }
+  snap->channels = channels;
   return 0;
 }
 
@@ -106,17 +108,24 @@ static int16_t readOneChannel(int channel)
 // ------------------------------------------------
 float analogRead(int channel)
 {
-  int16_t sv = readOneChannel(channel);
-  if (sv == BAD_ANALOG_READ) {
-    return sv;
-  }
-  return (float)sv / 287.0f;
+  analog_snapshot_t snap;
+  if (channel < 0 || channel >= ANALOG_CHANNELS) return BAD_ANALOG_READ;
+  analogScan(BIT(channel), &snap);
+  return snap.volts[channel];
 }
 
 #else
 
 // No analog support
 
+int analogScan(uint32_t channels, analog_snapshot_t *snap)
+{
+  for (int i = 0; i < ANALOG_CHANNELS; i++) snap->volts[i] = 0.0f;
+  snap->channels = channels;
+  snap->timestamp = k_ticks_to_us_floor64(k_uptime_ticks());
+  return 0;
+}
+
 float analogRead(int channel) {
   return 0.0f;
 }
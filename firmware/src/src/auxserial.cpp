@@ -32,6 +32,8 @@ LOG_MODULE_REGISTER(auxserial);
 
 static bool serialopened = false;
 
+#define AUXSERIAL_STOP_TIMEOUT 2000  // (us) Longest wait for the UARTE DMA to stop when closing
+
 #define SERIALIN1_PPICH_MSK CONCAT(CONCAT(PPI_CHENSET_CH, SERIALIN1_PPICH), _Msk)
 #define SERIALIN2_PPICH_MSK CONCAT(CONCAT(PPI_CHENSET_CH, SERIALIN2_PPICH), _Msk)
 #define SERIALOUT_PPICH_MSK CONCAT(CONCAT(PPI_CHENSET_CH, SERIALOUT_PPICH), _Msk)
@@ -39,6 +41,11 @@ static bool serialopened = false;
 #define SERIAL_UARTE CONCAT(NRF_UARTE, SERIAL_UARTE_CH)
 #define SERIAL_UARTE_IRQ CONCAT(CONCAT(UARTE, SERIAL_UARTE_CH), _IRQn)
 
+#define SERIALIN_RX_PPICH_MSK CONCAT(CONCAT(PPI_CHENSET_CH, SERIALIN_RX_PPICH), _Msk)
+#define SERIALIN_IDLE_TIMER CONCAT(NRF_TIMER, SERIALIN_IDLE_TIMER_CH)
+#define SERIALIN_IDLE_TIMER_IRQ CONCAT(CONCAT(TIMER, SERIALIN_IDLE_TIMER_CH), _IRQn)
+#define SERIALIN_COUNT_TIMER CONCAT(NRF_TIMER, SERIALIN_COUNT_TIMER_CH)
+
 // Aux Serial Output Pins
 #define AUXSERIALIN_PIN  PIN_TO_GPIN(PinNumber[IO_RX])
 #define AUXSERIALIN_PORT PIN_TO_GPORT(PinNumber[IO_RX])
@@ -59,37 +66,109 @@ static bool serialopened = false;
 #define SERIALIN_TPIN_IN  PIN_TO_GPIN(PinNumber[IO_RXINVI])
 #define SERIALIN_TPORT_IN PIN_TO_GPORT(PinNumber[IO_RXINVI])
 
-static uint8_t serialDMATx[SERIAL_TX_SIZE];  // DMA Access Buffer Write
-
-// In/Out Buffers
-ringbuffer<uint8_t> serialRxBuf(SERIAL_RX_SIZE);
-ringbuffer<uint8_t> serialTxBuf(SERIAL_TX_SIZE);
+// In/Out Buffers. The UARTE sends straight out of serialTxBuf, txInFlight bytes at its tail
+//  are being sent and are consumed when the DMA ends
+static ringbuffer<uint8_t, SERIAL_RX_SIZE> serialRxBuf;
+static ringbuffer<uint8_t, SERIAL_TX_SIZE> serialTxBuf;
+static size_t txInFlight = 0;
+
+/* Receive is by EasyDMA into two buffers, the UARTE moves to the other by itself when one fills
+ *  (ENDRX_STARTRX short). PPI counts every received byte on SERIALIN_COUNT_TIMER and restarts
+ *  SERIALIN_IDLE_TIMER, which interrupts once the line has been quiet for a few bytes. Received
+ *  bytes are moved to serialRxBuf when a buffer fills or the line goes idle, the idle also wakes
+ *  anyone waiting in AuxSerial_WaitRx. Both interrupts are the same priority so they never
+ *  preempt each other
+ */
+#define SERIAL_RX_DMA_SIZE 64
+#define SERIAL_RX_IDLE_BYTES 4
+static uint8_t serialDMARx[2][SERIAL_RX_DMA_SIZE];
+static uint8_t rxDmaBuf = 0;      // Buffer being filled
+static uint32_t rxDmaMoved = 0;   // Bytes of it already in serialRxBuf
+static uint32_t rxCountBase = 0;  // Byte count when it started
+K_SEM_DEFINE(serialRxSem, 0, 1);
 
 static bool invertTX = false;
 static bool invertRX = false;
 
 volatile bool isTransmitting = false;
 
-void Serial_Start_TX()
+// Points the UARTE at the next contiguous span of the TX ring, false if it's empty
+static bool Serial_Load_TX()
 {
-  size_t len = MIN(serialTxBuf.getOccupied(), sizeof(serialDMATx));
-  if (len == 0) return;
+  uint8_t *span;
+  txInFlight = serialTxBuf.peek(span);
+  if (txInFlight == 0) return false;
+  SERIAL_UARTE->TXD.PTR = (uint32_t)span;
+  SERIAL_UARTE->TXD.MAXCNT = txInFlight;
+  SERIAL_UARTE->TASKS_STARTTX = 1;
+  return true;
+}
 
+void Serial_Start_TX()
+{
   // If currently sending data, ISR will load the next payload
-  //  otherwise, load the buffer and initiat the transfer
+  //  otherwise initiate the transfer
   irq_disable(SERIAL_UARTE_IRQ);
-  if(isTransmitting == false) {
-    isTransmitting = true;
-    serialTxBuf.read(serialDMATx, len);
+  if (isTransmitting == false) {
     SERIAL_UARTE->EVENTS_ENDTX = 0;
-    SERIAL_UARTE->TXD.MAXCNT = len;
-    SERIAL_UARTE->TASKS_STARTTX = 1;
+    isTransmitting = Serial_Load_TX();
   }
   irq_enable(SERIAL_UARTE_IRQ);
 }
 
-void SerialTX_isr()
+// Moves the bytes that have arrived in the current DMA buffer, up to end, to serialRxBuf
+static void Serial_Move_RX(uint32_t end)
+{
+  end = MIN(end, SERIAL_RX_DMA_SIZE);
+  if (end > rxDmaMoved) {
+    serialRxBuf.write(&serialDMARx[rxDmaBuf][rxDmaMoved], end - rxDmaMoved);
+    rxDmaMoved = end;
+  }
+}
+
+// Bytes received into the current DMA buffer so far
+static uint32_t Serial_RX_Count()
+{
+  SERIALIN_COUNT_TIMER->TASKS_CAPTURE[0] = 1;
+  return SERIALIN_COUNT_TIMER->CC[0] - rxCountBase;
+}
+
+void SerialIdle_isr()
 {
+  if (SERIALIN_IDLE_TIMER->EVENTS_COMPARE[0]) {
+    SERIALIN_IDLE_TIMER->EVENTS_COMPARE[0] = 0;
+    Serial_Move_RX(Serial_RX_Count());
+    k_sem_give(&serialRxSem);
+  }
+}
+
+void Serial_isr()
+{
+  // Buffer full, the UARTE has already moved on to the other
+  if (SERIAL_UARTE->EVENTS_ENDRX) {
+    SERIAL_UARTE->EVENTS_ENDRX = 0;
+    uint32_t amount = SERIAL_UARTE->RXD.AMOUNT;
+    Serial_Move_RX(amount);
+    rxCountBase += amount;
+    rxDmaBuf = !rxDmaBuf;
+    rxDmaMoved = 0;
+
+    // If the line went idle before this ran, the idle interrupt has passed. Move what is
+    //  in the new buffer now, it's all been written by then
+    SERIALIN_IDLE_TIMER->TASKS_CAPTURE[1] = 1;
+    if (SERIALIN_IDLE_TIMER->CC[1] >= SERIALIN_IDLE_TIMER->CC[0]) {
+      Serial_Move_RX(Serial_RX_Count());
+      k_sem_give(&serialRxSem);
+    }
+  }
+
+  // Next buffer can be set once the current one has started. After ENDRX above, so when both
+  //  are pending rxDmaBuf is already the buffer that started
+  if (SERIAL_UARTE->EVENTS_RXSTARTED) {
+    SERIAL_UARTE->EVENTS_RXSTARTED = 0;
+    SERIAL_UARTE->RXD.PTR = (uint32_t)serialDMARx[!rxDmaBuf];
+  }
+
   // Transmission End
   if (SERIAL_UARTE->EVENTS_ENDTX) {
     SERIAL_UARTE->EVENTS_ENDTX = 0;
@@ -110,27 +189,12 @@ void SerialTX_isr()
     // Enable PPI
     NRF_PPI->CHENSET = SERIALOUT_PPICH_MSK;
 
-    // If there is more data, load and send it
-    size_t len = MIN(serialTxBuf.getOccupied(), sizeof(serialDMATx));
-    if (len > 0) {
-      serialTxBuf.read(serialDMATx, len);
-      SERIAL_UARTE->TXD.MAXCNT = len;
-      SERIAL_UARTE->TASKS_STARTTX = 1;
-    } else {
-      isTransmitting = false;
-    }
+    // Free what was sent. If there is more data, send it
+    serialTxBuf.consume(txInFlight);
+    isTransmitting = Serial_Load_TX();
   }
 }
 
-void SerialRX_isr()
-{
-  ISR_DIRECT_HEADER();
-  NRF_UART0->EVENTS_RXDRDY = 0;
-  uint8_t rxv = (uint8_t)NRF_UART0->RXD;
-  serialRxBuf.write(&rxv, 1);
-  ISR_DIRECT_FOOTER(1);
-}
-
 int AuxSerial_Open(uint32_t baudrate, uint16_t prtset, uint8_t inversions)
 {
   if (serialopened) return SERIAL_ALREADY_OPEN;
@@ -143,21 +207,14 @@ int AuxSerial_Open(uint32_t baudrate, uint16_t prtset, uint8_t inversions)
   if (inversions & CONFINV_TX) invertTX = true;
   if (inversions & CONFINV_RX) invertRX = true;
 
-  // Setup UARTE for TX
+  // Setup UARTE for TX and RX
   SERIAL_UARTE->BAUDRATE = baudrate;
   SERIAL_UARTE->CONFIG = prtset;
-  SERIAL_UARTE->TXD.PTR = (uint32_t)serialDMATx;
-  SERIAL_UARTE->TXD.MAXCNT = sizeof(serialDMATx);
   SERIAL_UARTE->PSEL.TXD =
       (SERIALOUT_TPIN << UARTE_PSEL_TXD_PIN_Pos) | (SERIALOUT_TPORT << UARTE_PSEL_TXD_PORT_Pos);
-  SERIAL_UARTE->PSEL.RXD = UARTE_PSEL_RXD_CONNECT_Disconnected << UARTE_PSEL_RXD_CONNECT_Pos;
   SERIAL_UARTE->PSEL.CTS = UARTE_PSEL_CTS_CONNECT_Disconnected << UARTE_PSEL_CTS_CONNECT_Pos;
   SERIAL_UARTE->PSEL.RTS = UARTE_PSEL_RTS_CONNECT_Disconnected << UARTE_PSEL_RTS_CONNECT_Pos;
 
-  // Setup UART0 for RX
-  NRF_UART0->BAUDRATE = baudrate;
-  NRF_UART0->CONFIG = prtset;
-
   // Below uses two GPIOTE's to read the TX pin and cause it to be inverted temp pin
   // Setup as an input, when TX pin toggles state state causes the event to trigger and through
   // PPI toggle the output pin on next GPIOTE
@@ -210,154 +267,111 @@ int AuxSerial_Open(uint32_t baudrate, uint16_t prtset, uint8_t inversions)
     // Clear output pin on every input transition high (SBUS in)
     NRF_PPI->CH[SERIALIN1_PPICH].EEP = (uint32_t)&NRF_GPIOTE->EVENTS_IN[SERIALIN0_GPIOTE];
     NRF_PPI->CH[SERIALIN1_PPICH].TEP = (uint32_t)&NRF_GPIOTE->TASKS_SET[SERIALIN2_GPIOTE];
-    // NRF_PPI->FORK[SBUSIN1_PPICH].TEP = (uint32_t)&SBUSIN_TIMER->TASKS_START; // Start Timer on
-    // HitoLow
 
     // Set output pin on every input transition low (SBUS in)
     NRF_PPI->CH[SERIALIN2_PPICH].EEP = (uint32_t)&NRF_GPIOTE->EVENTS_IN[SERIALIN1_GPIOTE];
     NRF_PPI->CH[SERIALIN2_PPICH].TEP = (uint32_t)&NRF_GPIOTE->TASKS_CLR[SERIALIN2_GPIOTE];
-    // NRF_PPI->FORK[SBUSIN2_PPICH].TEP = (uint32_t)&SBUSIN_TIMER->TASKS_CLEAR; // Reset Timer on
-    // LowtoHi
     NRF_PPI->CHENSET = SERIALIN1_PPICH_MSK | SERIALIN2_PPICH_MSK;
 
-    NRF_UART0->PSEL.RXD = (SERIALIN_TPIN_IN << UARTE_PSEL_RXD_PIN_Pos) |
-                          (SERIALIN_TPORT_IN << UARTE_PSEL_RXD_PORT_Pos);
+    SERIAL_UARTE->PSEL.RXD = (SERIALIN_TPIN_IN << UARTE_PSEL_RXD_PIN_Pos) |
+                             (SERIALIN_TPORT_IN << UARTE_PSEL_RXD_PORT_Pos);
   } else {
     NRF_GPIOTE->CONFIG[SERIALIN0_GPIOTE] = 0;
     NRF_GPIOTE->CONFIG[SERIALIN1_GPIOTE] = 0;
     NRF_GPIOTE->CONFIG[SERIALIN2_GPIOTE] = 0;
     NRF_PPI->CHENCLR = SERIALIN1_PPICH_MSK | SERIALIN2_PPICH_MSK;
 
-    NRF_UART0->PSEL.RXD =
+    SERIAL_UARTE->PSEL.RXD =
         (AUXSERIALIN_PIN << UARTE_PSEL_RXD_PIN_Pos) | (AUXSERIALIN_PORT << UARTE_PSEL_RXD_PORT_Pos);
     // Set the pin D5 + D6 back to floating inputs
     //        nrf_gpio_cfg_input(SERIALIN_TPORT_OUT * 32 + SERIALIN_TPIN_OUT,NRF_GPIO_PIN_NOPULL);
     //        nrf_gpio_cfg_input(SERIALIN_TPORT_IN * 32 + SERIALIN_TPIN_IN, NRF_GPIO_PIN_NOPULL);
   }
 
-  // Start Timer
-  //    Timer is used to know when the SBUS line is idle, if idle for 1ms then force stop the UARTE
-  //    to read the buffer.
-  /*SBUSIN_TIMER->PRESCALER = 4; // 16Mhz/2^4 = 1Mhz = 1us Resolution, 1.048s Max@32bit
-  SBUSIN_TIMER->MODE = TIMER_MODE_MODE_Timer << TIMER_MODE_MODE_Pos;
-  SBUSIN_TIMER->BITMODE = TIMER_BITMODE_BITMODE_32Bit << TIMER_BITMODE_BITMODE_Pos;
-  SBUSIN_TIMER->CC[0] = 500; // 0.5ms of no data, stop uarte for reading
-  SBUSIN_TIMER->SHORTS = TIMER_SHORTS_COMPARE0_STOP_Enabled << TIMER_SHORTS_COMPARE0_STOP_Pos; //
-  Stop timer on compare equals
-
-  // On timer compare, stop UART
-  NRF_PPI->CH[SBUSINTMR_PPICH].EEP = (uint32_t)&SBUSIN_TIMER->EVENTS_COMPARE[0]; // On Compare
-  Event, NRF_PPI->CH[SBUSINTMR_PPICH].TEP = (uint32_t)&SBUS_UARTE->TASKS_STOPRX; // Stop Receive*/
-
-  // SBUSIN_TIMER->INTENSET = TIMER_INTENSET_COMPARE0_Msk; // Enable Compare 0 Interrupt... if PPI
-  // not good
-
-  // Baud 100000, 8E2
-  // 25 Byte Data Send Length
-
-  // DMA for SBUS input
-  // SBUS_UARTE->RXD.PTR = (uint32_t)sbusDMARx;
-  // SBUS_UARTE->RXD.MAXCNT = sizeof(sbusDMARx);
-
-  // Enable TX Pin, no flow control
-
-  // Use UART for receive... Gave up on the UARTE RX DMA method.. maybe will re-visit one day. Would
-  // be less interrupts, but the ISR is pretty simple.
-
-  // Enable the interrupt vector in IRQ Controller
-  IRQ_CONNECT(SERIAL_UARTE_IRQ, 2, SerialTX_isr, NULL, 0);
+  // Received byte counter
+  SERIALIN_COUNT_TIMER->MODE = TIMER_MODE_MODE_Counter << TIMER_MODE_MODE_Pos;
+  SERIALIN_COUNT_TIMER->BITMODE = TIMER_BITMODE_BITMODE_32Bit << TIMER_BITMODE_BITMODE_Pos;
+  SERIALIN_COUNT_TIMER->TASKS_CLEAR = 1;
+  SERIALIN_COUNT_TIMER->TASKS_START = 1;
+
+  // Idle timer, 1us resolution. Restarted by every byte, compares after SERIAL_RX_IDLE_BYTES
+  //  byte times of 12 bits (8E2) with nothing received
+  uint32_t baud = ((uint64_t)baudrate * 16000000) >> 32;
+  SERIALIN_IDLE_TIMER->PRESCALER = 4;
+  SERIALIN_IDLE_TIMER->MODE = TIMER_MODE_MODE_Timer << TIMER_MODE_MODE_Pos;
+  SERIALIN_IDLE_TIMER->BITMODE = TIMER_BITMODE_BITMODE_32Bit << TIMER_BITMODE_BITMODE_Pos;
+  SERIALIN_IDLE_TIMER->CC[0] = MAX(SERIAL_RX_IDLE_BYTES * 12 * 1000000 / MAX(baud, 1), 20);
+  SERIALIN_IDLE_TIMER->EVENTS_COMPARE[0] = 0;
+  SERIALIN_IDLE_TIMER->INTENSET = TIMER_INTENSET_COMPARE0_Msk;
+  SERIALIN_IDLE_TIMER->TASKS_CLEAR = 1;
+  SERIALIN_IDLE_TIMER->TASKS_START = 1;
+
+  // Each received byte counts and restarts the idle time
+  NRF_PPI->CH[SERIALIN_RX_PPICH].EEP = (uint32_t)&SERIAL_UARTE->EVENTS_RXDRDY;
+  NRF_PPI->CH[SERIALIN_RX_PPICH].TEP = (uint32_t)&SERIALIN_COUNT_TIMER->TASKS_COUNT;
+  NRF_PPI->FORK[SERIALIN_RX_PPICH].TEP = (uint32_t)&SERIALIN_IDLE_TIMER->TASKS_CLEAR;
+  NRF_PPI->CHENSET = SERIALIN_RX_PPICH_MSK;
+
+  // Double buffered DMA receive
+  rxDmaBuf = 0;
+  rxDmaMoved = 0;
+  rxCountBase = 0;
+  SERIAL_UARTE->RXD.PTR = (uint32_t)serialDMARx[0];
+  SERIAL_UARTE->RXD.MAXCNT = SERIAL_RX_DMA_SIZE;
+  SERIAL_UARTE->SHORTS = UARTE_SHORTS_ENDRX_STARTRX_Msk;
+
+  // Enable the interrupt vectors in IRQ Controller
+  IRQ_CONNECT(SERIAL_UARTE_IRQ, 2, Serial_isr, NULL, 0);
   irq_enable(SERIAL_UARTE_IRQ);
-  // Enable interupt on end of transmission
+  IRQ_CONNECT(SERIALIN_IDLE_TIMER_IRQ, 2, SerialIdle_isr, NULL, 0);
+  irq_enable(SERIALIN_IDLE_TIMER_IRQ);
+
+  // Enable interupts on end of transmission and the receive buffer handovers
   SERIAL_UARTE->INTENSET =
-      UARTE_INTENSET_ENDTX_Msk;  // | UARTE_INTENSET_RXDRDY_Msk | UARTE_INTENSET_ERROR_Msk;
+      UARTE_INTENSET_ENDTX_Msk | UARTE_INTENSET_RXSTARTED_Msk | UARTE_INTENSET_ENDRX_Msk;
   // Enable UARTE1
   SERIAL_UARTE->ENABLE = UARTE_ENABLE_ENABLE_Enabled << UARTE_ENABLE_ENABLE_Pos;
 
-  IRQ_DIRECT_CONNECT(UART0_IRQn, 1, SerialRX_isr, 0);
-  // IRQ_CONNECT(UART0_IRQn, 0, SBUSRX_Interrupt, NULL, 0);
-  irq_enable(UART0_IRQn);
-
-  // Enable UART Interrupt and UART
-  NRF_UART0->INTENSET = UART_INTENSET_RXDRDY_Msk;
-  NRF_UART0->ENABLE = UART_ENABLE_ENABLE_Enabled << UART_ENABLE_ENABLE_Pos;
-  NRF_UART0->TASKS_STARTRX = 1;
-
   // Start Receiving
-  // SBUS_UARTE->ERRORSRC = 0x0F; // Clear any errors
-  // SBUS_UARTE->TASKS_STARTRX = 1;
+  SERIAL_UARTE->ERRORSRC = 0x0F;  // Clear any errors
+  SERIAL_UARTE->TASKS_STARTRX = 1;
 
-  // ring_buf_init(&sbinringbuf, sizeof(sbring_buffer), sbring_buffer);
   serialopened = true;
   return 0;
 }
 
-// Disable PPI's
-/*NRF_PPI->CHENCLR = SBUSIN1_PPICH_MSK | SBUSIN2_PPICH_MSK;
-// Stop UARTE receiver
-SBUS_UARTE->TASKS_STOPRX = 1;
-
-// If SBUS inverted (NORMAL UART), Disable GPIOTE's toggle output on TempOut pin D5(1.13)
-// Connect UARTE RX directly to the RXpin (1.10)
-if(sbusininv) {
-    // Disable the GPIOTE
-    NRF_GPIOTE->CONFIG[SBUSIN2_GPIOTE] = 0;
-    // Set the UARTE to use the RX Pin directly
-    NRF_UART0->PSEL.RXD = (AUXSERIALIN_PIN << UARTE_PSEL_RXD_PIN_Pos) | (AUXSERIALIN_PORT <<
-UARTE_PSEL_RXD_PORT_Pos);
-    // Set the pin D5 + D6 back to floating inputs
-    nrf_gpio_cfg_input(SBUSIN_TPORT_OUT * 32 + SBUSIN_TPIN_OUT,NRF_GPIO_PIN_NOPULL);
-    nrf_gpio_cfg_input(SBUSIN_TPORT_IN * 32 + SBUSIN_TPIN_IN, NRF_GPIO_PIN_NOPULL);
-
-// If Inverted use the GPIOTE to output the inverted RX data on D5(1.13), connect the UARTERX to
-D6(1.14) -- *** USER MUST SOLDER TOGETHER } else {
-    // Enable the GPIOTE, Will force set to an output
-    NRF_GPIOTE->CONFIG[SBUSIN2_GPIOTE] = (GPIOTE_CONFIG_MODE_Task << GPIOTE_CONFIG_MODE_Pos) |
-        (SBUSIN_TPIN_OUT <<  GPIOTE_CONFIG_PSEL_Pos) |
-        (SBUSIN_TPORT_OUT << GPIOTE_CONFIG_PORT_Pos);
-
-    // D6 Is the Input, set as an input. -
-    nrf_gpio_cfg_input(SBUSIN_TPORT_IN * 32 + SBUSIN_TPIN_IN, NRF_GPIO_PIN_NOPULL);
-
-    // Set the SBUSRX Pin to D6(1.14)
-    NRF_UART0->PSEL.RXD = (SBUSIN_TPIN_IN << UARTE_PSEL_RXD_PIN_Pos) | (SBUSIN_TPORT_IN <<
-UARTE_PSEL_RXD_PORT_Pos);
-
-    // Enable the PPI's
-    NRF_PPI->CH[SBUSIN1_PPICH].EEP = (uint32_t)&NRF_GPIOTE->EVENTS_IN[SBUSIN0_GPIOTE];
-    NRF_PPI->CH[SBUSIN2_PPICH].EEP = (uint32_t)&NRF_GPIOTE->EVENTS_IN[SBUSIN1_GPIOTE];
-    NRF_PPI->CHENSET = SBUSIN1_PPICH_MSK | SBUSIN2_PPICH_MSK;
-}
-
-// Start Receiver
-SBUS_UARTE->ERRORSRC = 0x0F; // Clear any errors
-SBUS_UARTE->TASKS_STARTRX = 1;
-*/
-
 void AuxSerial_Close()
 {
   // Stop Interrupts
-  irq_disable(UART0_IRQn);
   irq_disable(SERIAL_UARTE_IRQ);
+  irq_disable(SERIALIN_IDLE_TIMER_IRQ);
 
   // Disable PPI's
-  NRF_PPI->CHENCLR = SERIALIN1_PPICH_MSK | SERIALIN2_PPICH_MSK | SERIALOUT_PPICH_MSK;
-
-  // Disable UART
-  NRF_UART0->ENABLE = 0;
-  NRF_UART0->TASKS_STOPRX = 1;
-  NRF_UART0->TASKS_STOPTX = 1;
-  NRF_UART0->CONFIG = 0;
-  NRF_UART0->PSEL.TXD = UART_PSEL_TXD_CONNECT_Disconnected << UART_PSEL_TXD_CONNECT_Pos;
-  NRF_UART0->PSEL.RXD = UART_PSEL_RXD_CONNECT_Disconnected << UART_PSEL_RXD_CONNECT_Pos;
-  NRF_UART0->PSEL.CTS = UART_PSEL_CTS_CONNECT_Disconnected << UART_PSEL_CTS_CONNECT_Pos;
-  NRF_UART0->PSEL.RTS = UART_PSEL_RTS_CONNECT_Disconnected << UART_PSEL_RTS_CONNECT_Pos;
-  NRF_UART0->INTENCLR = 0xFFFFFFFF;
-  NRF_UART0->ERRORSRC = 0;
-
-  // Disable UARTE
-  SERIAL_UARTE->ENABLE = 0;
+  NRF_PPI->CHENCLR = SERIALIN1_PPICH_MSK | SERIALIN2_PPICH_MSK | SERIALOUT_PPICH_MSK |
+                     SERIALIN_RX_PPICH_MSK;
+
+  // Stop the receive timers
+  SERIALIN_IDLE_TIMER->TASKS_STOP = 1;
+  SERIALIN_IDLE_TIMER->INTENCLR = 0xFFFFFFFF;
+  SERIALIN_IDLE_TIMER->EVENTS_COMPARE[0] = 0;
+  SERIALIN_COUNT_TIMER->TASKS_STOP = 1;
+
+  // Disable UARTE. The EasyDMA transfers have to finish first or they can still be writing
+  //  serialDMARx when the next open arms it again. RXTO follows STOPRX within a few bytes
+  SERIAL_UARTE->SHORTS = 0;
+  SERIAL_UARTE->EVENTS_RXTO = 0;
+  SERIAL_UARTE->EVENTS_TXSTOPPED = 0;
   SERIAL_UARTE->TASKS_STOPRX = 1;
   SERIAL_UARTE->TASKS_STOPTX = 1;
+  for (int i = 0; i < AUXSERIAL_STOP_TIMEOUT / 10; i++) {
+    if ((!serialopened || SERIAL_UARTE->EVENTS_RXTO) &&
+        (!isTransmitting || SERIAL_UARTE->EVENTS_TXSTOPPED))
+      break;
+    k_busy_wait(10);
+  }
+  SERIAL_UARTE->EVENTS_RXTO = 0;
+  SERIAL_UARTE->EVENTS_TXSTOPPED = 0;
+  SERIAL_UARTE->ENABLE = 0;
   SERIAL_UARTE->INTENCLR = 0xFFFFFFFF;
   SERIAL_UARTE->PSEL.CTS = UARTE_PSEL_CTS_CONNECT_Disconnected
                            << UARTE_PSEL_CTS_CONNECT_Disconnected;
@@ -369,6 +383,7 @@ void AuxSerial_Close()
                            << UARTE_PSEL_RXD_CONNECT_Disconnected;
   SERIAL_UARTE->EVENTS_ENDTX = 0;
   SERIAL_UARTE->EVENTS_ENDRX = 0;
+  SERIAL_UARTE->EVENTS_RXSTARTED = 0;
   SERIAL_UARTE->ERRORSRC = 0;
 
   // Disable GPIOTE
@@ -378,6 +393,13 @@ void AuxSerial_Close()
   NRF_GPIOTE->CONFIG[SERIALOUT1_GPIOTE] = 0;
   NRF_GPIOTE->CONFIG[SERIALOUT1_GPIOTE] = 0;
 
+  // A transfer stopped part way won't signal ENDTX, drop it so the next write starts again
+  if (isTransmitting) {
+    serialTxBuf.consume(txInFlight);
+    txInFlight = 0;
+    isTransmitting = false;
+  }
+
   serialopened = false;
 }
 
@@ -396,6 +418,9 @@ uint32_t AuxSerial_Read(uint8_t *buffer, uint32_t bufsize)
 
 bool AuxSerial_Available() { return serialRxBuf.getOccupied() > 0; }
 
+// Waits for the line to go idle after receiving, true if it did before the timeout
+bool AuxSerial_WaitRx(k_timeout_t timeout) { return k_sem_take(&serialRxSem, timeout) == 0; }
+
 // Is a AUXUART port defined in the device tree?
 #elif defined(DT_N_ALIAS_auxserial)
 #define UART_DEVICE_NODE DT_ALIAS(auxserial)
@@ -405,6 +430,7 @@ bool AuxSerial_Available() { return serialRxBuf.getOccupied() > 0; }
 
 static const struct device *const uart_dev = DEVICE_DT_GET(UART_DEVICE_NODE);
 RING_BUF_DECLARE(auxrx_ring_buf, 512);
+K_SEM_DEFINE(auxrx_sem, 0, 1);
 
 /*
  * Read characters from UART until line end is detected. Afterwards push the
@@ -426,6 +452,7 @@ void auxserial_cb(const struct device *dev, void *user_data)
 	while (uart_fifo_read(uart_dev, &c, 1) == 1) {
     ring_buf_put(&auxrx_ring_buf, &c, 1);
 	}
+  k_sem_give(&auxrx_sem);
 }
 
 int AuxSerial_Open(uint32_t baudrate, uint16_t settings, uint8_t inversions)
@@ -483,6 +510,12 @@ uint32_t AuxSerial_Read(uint8_t* buffer, uint32_t bufsize)
   return ring_buf_get(&auxrx_ring_buf, buffer, readlen);
 }
 
+// No idle detection here, signals whenever the FIFO has been emptied
+bool AuxSerial_WaitRx(k_timeout_t timeout)
+{
+  return k_sem_take(&auxrx_sem, timeout) == 0;
+}
+
 #else
 
 int AuxSerial_Open(uint32_t baudrate, uint16_t settings, uint8_t inversions) {return 0;}
@@ -490,6 +523,7 @@ bool AuxSerial_Available() {return 0;}
 void AuxSerial_Close() {}
 uint32_t AuxSerial_Write(const uint8_t* buffer, uint32_t len) {return 0;}
 uint32_t AuxSerial_Read(uint8_t* buffer, uint32_t bufsize) {return 0;}
+bool AuxSerial_WaitRx(k_timeout_t timeout) {k_sleep(timeout); return false;}
 #warning "No Aux Serial Support"
 
 #endif
@@ -95,7 +95,10 @@ public:
   inline const uint16_t& getRll_Min() {return rll_min;}
   bool setRll_Min(uint16_t val=DEF_MIN_PWM) {
     if(val >= MIN_PWM && val <= MAX_PWM) {
-      rll_min = val;
+      if(rll_min != val) {
+        rll_min = val;
+        settinggen[0] = ++generation;
+      }
       return true;
     }
     return false;
@@ -105,7 +108,10 @@ public:
   inline const uint16_t& getRll_Max() {return rll_max;}
   bool setRll_Max(uint16_t val=DEF_MAX_PWM) {
     if(val >= MIN_PWM && val <= MAX_PWM) {
-      rll_max = val;
+      if(rll_max != val) {
+        rll_max = val;
+        settinggen[1] = ++generation;
+      }
       return true;
     }
     return false;
@@ -115,7 +121,10 @@ public:
   inline const uint16_t& getRll_Cnt() {return rll_cnt;}
   bool setRll_Cnt(uint16_t val=PPM_CENTER) {
     if(val >= MIN_PWM && val <= MAX_PWM) {
-      rll_cnt = val;
+      if(rll_cnt != val) {
+        rll_cnt = val;
+        settinggen[2] = ++generation;
+      }
       return true;
     }
     return false;
@@ -125,7 +134,10 @@ public:
   inline const float& getRll_Gain() {return rll_gain;}
   bool setRll_Gain(float val=5) {
     if(val >= MIN_GAIN && val <= MAX_GAIN) {
-      rll_gain = val;
+      if(rll_gain != val) {
+        rll_gain = val;
+        settinggen[3] = ++generation;
+      }
       return true;
     }
     return false;
@@ -135,7 +147,10 @@ public:
   inline const uint16_t& getTlt_Min() {return tlt_min;}
   bool setTlt_Min(uint16_t val=DEF_MIN_PWM) {
     if(val >= MIN_PWM && val <= MAX_PWM) {
-      tlt_min = val;
+      if(tlt_min != val) {
+        tlt_min = val;
+        settinggen[4] = ++generation;
+      }
       return true;
     }
     return false;
@@ -145,7 +160,10 @@ public:
   inline const uint16_t& getTlt_Max() {return tlt_max;}
   bool setTlt_Max(uint16_t val=DEF_MAX_PWM) {
     if(val >= MIN_PWM && val <= MAX_PWM) {
-      tlt_max = val;
+      if(tlt_max != val) {
+        tlt_max = val;
+        settinggen[5] = ++generation;
+      }
       return true;
     }
     return false;
@@ -155,7 +173,10 @@ public:
   inline const uint16_t& getTlt_Cnt() {return tlt_cnt;}
   bool setTlt_Cnt(uint16_t val=PPM_CENTER) {
     if(val >= MIN_PWM && val <= MAX_PWM) {
-      tlt_cnt = val;
+      if(tlt_cnt != val) {
+        tlt_cnt = val;
+        settinggen[6] = ++generation;
+      }
       return true;
     }
     return false;
@@ -165,7 +186,10 @@ public:
   inline const float& getTlt_Gain() {return tlt_gain;}
   bool setTlt_Gain(float val=5) {
     if(val >= MIN_GAIN && val <= MAX_GAIN) {
-      tlt_gain = val;
+      if(tlt_gain != val) {
+        tlt_gain = val;
+        settinggen[7] = ++generation;
+      }
       return true;
     }
     return false;
@@ -175,7 +199,10 @@ public:
   inline const uint16_t& getPan_Min() {return pan_min;}
   bool setPan_Min(uint16_t val=DEF_MIN_PWM) {
     if(val >= MIN_PWM && val <= MAX_PWM) {
-      pan_min = val;
+      if(pan_min != val) {
+        pan_min = val;
+        settinggen[8] = ++generation;
+      }
       return true;
     }
     return false;
@@ -185,7 +212,10 @@ public:
   inline const uint16_t& getPan_Max() {return pan_max;}
   bool setPan_Max(uint16_t val=DEF_MAX_PWM) {
     if(val >= MIN_PWM && val <= MAX_PWM) {
-      pan_max = val;
+      if(pan_max != val) {
+        pan_max = val;
+        settinggen[9] = ++generation;
+      }
       return true;
     }
     return false;
@@ -195,7 +225,10 @@ public:
   inline const uint16_t& getPan_Cnt() {return pan_cnt;}
   bool setPan_Cnt(uint16_t val=PPM_CENTER) {
     if(val >= MIN_PWM && val <= MAX_PWM) {
-      pan_cnt = val;
+      if(pan_cnt != val) {
+        pan_cnt = val;
+        settinggen[10] = ++generation;
+      }
       return true;
     }
     return false;
@@ -205,7 +238,10 @@ public:
   inline const float& getPan_Gain() {return pan_gain;}
   bool setPan_Gain(float val=5) {
     if(val >= MIN_GAIN && val <= MAX_GAIN) {
-      pan_gain = val;
+      if(pan_gain != val) {
+        pan_gain = val;
+        settinggen[11] = ++generation;
+      }
       return true;
     }
     return false;
@@ -215,7 +251,10 @@ public:
   inline const int8_t& getTltCh() {return tltch;}
   bool setTltCh(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      tltch = val;
+      if(tltch != val) {
+        tltch = val;
+        settinggen[12] = ++generation;
+      }
       return true;
     }
     return false;
@@ -225,7 +264,10 @@ public:
   inline const int8_t& getRllCh() {return rllch;}
   bool setRllCh(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      rllch = val;
+      if(rllch != val) {
+        rllch = val;
+        settinggen[13] = ++generation;
+      }
       return true;
     }
     return false;
@@ -235,7 +277,10 @@ public:
   inline const int8_t& getPanCh() {return panch;}
   bool setPanCh(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      panch = val;
+      if(panch != val) {
+        panch = val;
+        settinggen[14] = ++generation;
+      }
       return true;
     }
     return false;
@@ -245,7 +290,10 @@ public:
   inline const int8_t& getAlertCh() {return alertch;}
   bool setAlertCh(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      alertch = val;
+      if(alertch != val) {
+        alertch = val;
+        settinggen[15] = ++generation;
+      }
       return true;
     }
     return false;
@@ -255,7 +303,10 @@ public:
   inline const int8_t& getPwm0() {return pwm0;}
   bool setPwm0(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      pwm0 = val;
+      if(pwm0 != val) {
+        pwm0 = val;
+        settinggen[16] = ++generation;
+      }
       return true;
     }
     return false;
@@ -265,7 +316,10 @@ public:
   inline const int8_t& getPwm1() {return pwm1;}
   bool setPwm1(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      pwm1 = val;
+      if(pwm1 != val) {
+        pwm1 = val;
+        settinggen[17] = ++generation;
+      }
       return true;
     }
     return false;
@@ -275,7 +329,10 @@ public:
   inline const int8_t& getPwm2() {return pwm2;}
   bool setPwm2(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      pwm2 = val;
+      if(pwm2 != val) {
+        pwm2 = val;
+        settinggen[18] = ++generation;
+      }
       return true;
     }
     return false;
@@ -285,7 +342,23 @@ public:
   inline const int8_t& getPwm3() {return pwm3;}
   bool setPwm3(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      pwm3 = val;
+      if(pwm3 != val) {
+        pwm3 = val;
+        settinggen[19] = ++generation;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  // PWM Refresh Rate (Hz)
+  inline const uint16_t& getPwmRate() {return pwmrate;}
+  bool setPwmRate(uint16_t val=50) {
+    if(val >= 31 && val <= 400) {
+      if(pwmrate != val) {
+        pwmrate = val;
+        settinggen[20] = ++generation;
+      }
       return true;
     }
     return false;
@@ -295,7 +368,10 @@ public:
   inline const int8_t& getAn0Ch() {return an0ch;}
   bool setAn0Ch(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      an0ch = val;
+      if(an0ch != val) {
+        an0ch = val;
+        settinggen[21] = ++generation;
+      }
       return true;
     }
     return false;
@@ -305,7 +381,10 @@ public:
   inline const int8_t& getAn1Ch() {return an1ch;}
   bool setAn1Ch(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      an1ch = val;
+      if(an1ch != val) {
+        an1ch = val;
+        settinggen[22] = ++generation;
+      }
       return true;
     }
     return false;
@@ -315,7 +394,10 @@ public:
   inline const int8_t& getAn2Ch() {return an2ch;}
   bool setAn2Ch(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      an2ch = val;
+      if(an2ch != val) {
+        an2ch = val;
+        settinggen[23] = ++generation;
+      }
       return true;
     }
     return false;
@@ -325,7 +407,10 @@ public:
   inline const int8_t& getAn3Ch() {return an3ch;}
   bool setAn3Ch(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      an3ch = val;
+      if(an3ch != val) {
+        an3ch = val;
+        settinggen[24] = ++generation;
+      }
       return true;
     }
     return false;
@@ -335,7 +420,10 @@ public:
   inline const int8_t& getAux0Ch() {return aux0ch;}
   bool setAux0Ch(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      aux0ch = val;
+      if(aux0ch != val) {
+        aux0ch = val;
+        settinggen[25] = ++generation;
+      }
       return true;
     }
     return false;
@@ -345,7 +433,10 @@ public:
   inline const int8_t& getAux1Ch() {return aux1ch;}
   bool setAux1Ch(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      aux1ch = val;
+      if(aux1ch != val) {
+        aux1ch = val;
+        settinggen[26] = ++generation;
+      }
       return true;
     }
     return false;
@@ -355,7 +446,10 @@ public:
   inline const int8_t& getAux2Ch() {return aux2ch;}
   bool setAux2Ch(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      aux2ch = val;
+      if(aux2ch != val) {
+        aux2ch = val;
+        settinggen[27] = ++generation;
+      }
       return true;
     }
     return false;
@@ -365,7 +459,10 @@ public:
   inline const int8_t& getRstPpm() {return rstppm;}
   bool setRstPpm(int8_t val=-1) {
     if(val >= -1 && val <= MAX_CHANNELS) {
-      rstppm = val;
+      if(rstppm != val) {
+        rstppm = val;
+        settinggen[28] = ++generation;
+      }
       return true;
     }
     return false;
@@ -375,7 +472,10 @@ public:
   inline const uint8_t& getAux0Func() {return aux0func;}
   bool setAux0Func(uint8_t val=0) {
     if(val >= 0 && val <= AUX_FUNCTIONS) {
-      aux0func = val;
+      if(aux0func != val) {
+        aux0func = val;
+        settinggen[29] = ++generation;
+      }
       return true;
     }
     return false;
@@ -385,7 +485,10 @@ public:
   inline const uint8_t& getAux1Func() {return aux1func;}
   bool setAux1Func(uint8_t val=0) {
     if(val >= 0 && val <= AUX_FUNCTIONS) {
-      aux1func = val;
+      if(aux1func != val) {
+        aux1func = val;
+        settinggen[30] = ++generation;
+      }
       return true;
     }
     return false;
@@ -395,7 +498,10 @@ public:
   inline const uint8_t& getAux2Func() {return aux2func;}
   bool setAux2Func(uint8_t val=0) {
     if(val >= 0 && val <= AUX_FUNCTIONS) {
-      aux2func = val;
+      if(aux2func != val) {
+        aux2func = val;
+        settinggen[31] = ++generation;
+      }
       return true;
     }
     return false;
@@ -405,7 +511,10 @@ public:
   inline const float& getAn0Gain() {return an0gain;}
   bool setAn0Gain(float val=310) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      an0gain = val;
+      if(an0gain != val) {
+        an0gain = val;
+        settinggen[32] = ++generation;
+      }
       return true;
     }
     return false;
@@ -415,7 +524,10 @@ public:
   inline const float& getAn1Gain() {return an1gain;}
   bool setAn1Gain(float val=310) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      an1gain = val;
+      if(an1gain != val) {
+        an1gain = val;
+        settinggen[33] = ++generation;
+      }
       return true;
     }
     return false;
@@ -425,7 +537,10 @@ public:
   inline const float& getAn2Gain() {return an2gain;}
   bool setAn2Gain(float val=310) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      an2gain = val;
+      if(an2gain != val) {
+        an2gain = val;
+        settinggen[34] = ++generation;
+      }
       return true;
     }
     return false;
@@ -435,7 +550,10 @@ public:
   inline const float& getAn3Gain() {return an3gain;}
   bool setAn3Gain(float val=310) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      an3gain = val;
+      if(an3gain != val) {
+        an3gain = val;
+        settinggen[35] = ++generation;
+      }
       return true;
     }
     return false;
@@ -445,7 +563,10 @@ public:
   inline const float& getAn0Off() {return an0off;}
   bool setAn0Off(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      an0off = val;
+      if(an0off != val) {
+        an0off = val;
+        settinggen[36] = ++generation;
+      }
       return true;
     }
     return false;
@@ -455,7 +576,10 @@ public:
   inline const float& getAn1Off() {return an1off;}
   bool setAn1Off(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      an1off = val;
+      if(an1off != val) {
+        an1off = val;
+        settinggen[37] = ++generation;
+      }
       return true;
     }
     return false;
@@ -465,7 +589,10 @@ public:
   inline const float& getAn2Off() {return an2off;}
   bool setAn2Off(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      an2off = val;
+      if(an2off != val) {
+        an2off = val;
+        settinggen[38] = ++generation;
+      }
       return true;
     }
     return false;
@@ -475,7 +602,10 @@ public:
   inline const float& getAn3Off() {return an3off;}
   bool setAn3Off(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      an3off = val;
+      if(an3off != val) {
+        an3off = val;
+        settinggen[39] = ++generation;
+      }
       return true;
     }
     return false;
@@ -485,7 +615,10 @@ public:
   inline const uint8_t& getServoReverse() {return servoreverse;}
   bool setServoReverse(uint8_t val=0) {
     if(val >= 0 && val <= 7) {
-      servoreverse = val;
+      if(servoreverse != val) {
+        servoreverse = val;
+        settinggen[40] = ++generation;
+      }
       return true;
     }
     return false;
@@ -495,7 +628,10 @@ public:
   inline const float& getMagXOff() {return magxoff;}
   bool setMagXOff(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      magxoff = val;
+      if(magxoff != val) {
+        magxoff = val;
+        settinggen[41] = ++generation;
+      }
       return true;
     }
     return false;
@@ -505,7 +641,10 @@ public:
   inline const float& getMagYOff() {return magyoff;}
   bool setMagYOff(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      magyoff = val;
+      if(magyoff != val) {
+        magyoff = val;
+        settinggen[42] = ++generation;
+      }
       return true;
     }
     return false;
@@ -515,7 +654,10 @@ public:
   inline const float& getMagZOff() {return magzoff;}
   bool setMagZOff(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      magzoff = val;
+      if(magzoff != val) {
+        magzoff = val;
+        settinggen[43] = ++generation;
+      }
       return true;
     }
     return false;
@@ -525,7 +667,10 @@ public:
   inline const float& getAccXOff() {return accxoff;}
   bool setAccXOff(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      accxoff = val;
+      if(accxoff != val) {
+        accxoff = val;
+        settinggen[44] = ++generation;
+      }
       return true;
     }
     return false;
@@ -535,7 +680,10 @@ public:
   inline const float& getAccYOff() {return accyoff;}
   bool setAccYOff(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      accyoff = val;
+      if(accyoff != val) {
+        accyoff = val;
+        settinggen[45] = ++generation;
+      }
       return true;
     }
     return false;
@@ -545,7 +693,10 @@ public:
   inline const float& getAccZOff() {return acczoff;}
   bool setAccZOff(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      acczoff = val;
+      if(acczoff != val) {
+        acczoff = val;
+        settinggen[46] = ++generation;
+      }
       return true;
     }
     return false;
@@ -555,7 +706,10 @@ public:
   inline const float& getGyrXOff() {return gyrxoff;}
   bool setGyrXOff(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      gyrxoff = val;
+      if(gyrxoff != val) {
+        gyrxoff = val;
+        settinggen[47] = ++generation;
+      }
       return true;
     }
     return false;
@@ -565,7 +719,10 @@ public:
   inline const float& getGyrYOff() {return gyryoff;}
   bool setGyrYOff(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      gyryoff = val;
+      if(gyryoff != val) {
+        gyryoff = val;
+        settinggen[48] = ++generation;
+      }
       return true;
     }
     return false;
@@ -575,7 +732,10 @@ public:
   inline const float& getGyrZOff() {return gyrzoff;}
   bool setGyrZOff(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      gyrzoff = val;
+      if(gyrzoff != val) {
+        gyrzoff = val;
+        settinggen[49] = ++generation;
+      }
       return true;
     }
     return false;
@@ -585,7 +745,10 @@ public:
   inline const float& getso00() {return so00;}
   bool setso00(float val=1) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      so00 = val;
+      if(so00 != val) {
+        so00 = val;
+        settinggen[50] = ++generation;
+      }
       return true;
     }
     return false;
@@ -595,7 +758,10 @@ public:
   inline const float& getso01() {return so01;}
   bool setso01(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      so01 = val;
+      if(so01 != val) {
+        so01 = val;
+        settinggen[51] = ++generation;
+      }
       return true;
     }
     return false;
@@ -605,7 +771,10 @@ public:
   inline const float& getso02() {return so02;}
   bool setso02(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      so02 = val;
+      if(so02 != val) {
+        so02 = val;
+        settinggen[52] = ++generation;
+      }
       return true;
     }
     return false;
@@ -615,7 +784,10 @@ public:
   inline const float& getso10() {return so10;}
   bool setso10(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      so10 = val;
+      if(so10 != val) {
+        so10 = val;
+        settinggen[53] = ++generation;
+      }
       return true;
     }
     return false;
@@ -625,7 +797,10 @@ public:
   inline const float& getso11() {return so11;}
   bool setso11(float val=1) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      so11 = val;
+      if(so11 != val) {
+        so11 = val;
+        settinggen[54] = ++generation;
+      }
       return true;
     }
     return false;
@@ -635,7 +810,10 @@ public:
   inline const float& getso12() {return so12;}
   bool setso12(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      so12 = val;
+      if(so12 != val) {
+        so12 = val;
+        settinggen[55] = ++generation;
+      }
       return true;
     }
     return false;
@@ -645,7 +823,10 @@ public:
   inline const float& getso20() {return so20;}
   bool setso20(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      so20 = val;
+      if(so20 != val) {
+        so20 = val;
+        settinggen[56] = ++generation;
+      }
       return true;
     }
     return false;
@@ -655,7 +836,10 @@ public:
   inline const float& getso21() {return so21;}
   bool setso21(float val=0) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      so21 = val;
+      if(so21 != val) {
+        so21 = val;
+        settinggen[57] = ++generation;
+      }
       return true;
     }
     return false;
@@ -665,7 +849,10 @@ public:
   inline const float& getso22() {return so22;}
   bool setso22(float val=1) {
     if(val >= FLOAT_MIN && val <= FLOAT_MAX) {
-      so22 = val;
+      if(so22 != val) {
+        so22 = val;
+        settinggen[58] = ++generation;
+      }
       return true;
     }
     return false;
@@ -673,13 +860,21 @@ public:
 
   // Disable Magnetometer
   inline const bool& getDisMag() {return dismag;}
-  void setDisMag(bool val=1) { dismag = val; }
+  void setDisMag(bool val=1) {
+    if(dismag != val) {
+      dismag = val;
+      settinggen[59] = ++generation;
+    }
+  }
 
   // Board Rotation X
   inline const float& getRotX() {return rotx;}
   bool setRotX(float val=0) {
     if(val >= -360 && val <= 360) {
-      rotx = val;
+      if(rotx != val) {
+        rotx = val;
+        settinggen[60] = ++generation;
+      }
       return true;
     }
     return false;
@@ -689,7 +884,10 @@ public:
   inline const float& getRotY() {return roty;}
   bool setRotY(float val=0) {
     if(val >= -360 && val <= 360) {
-      roty = val;
+      if(roty != val) {
+        roty = val;
+        settinggen[61] = ++generation;
+      }
       return true;
     }
     return false;
@@ -699,27 +897,36 @@ public:
   inline const float& getRotZ() {return rotz;}
   bool setRotZ(float val=0) {
     if(val >= -360 && val <= 360) {
-      rotz = val;
+      if(rotz != val) {
+        rotz = val;
+        settinggen[62] = ++generation;
+      }
       return true;
     }
     return false;
   }
 
-  // Uart Mode (0- Off, 1-SBUS, 2-CRSFIN, 3-CRSFOUT)
+  // Uart Mode (0-Off, 1-SBUS, 2-CRSFIN, 3-CRSFOUT)
   inline const uint8_t& getUartMode() {return uartmode;}
   bool setUartMode(uint8_t val=0) {
     if(val >= 0 && val <= 3) {
-      uartmode = val;
+      if(uartmode != val) {
+        uartmode = val;
+        settinggen[63] = ++generation;
+      }
       return true;
     }
     return false;
   }
 
   // CRSF Transmit Frequncy
-  inline const uint8_t& getCrsfTxRate() {return crsftxrate;}
-  bool setCrsfTxRate(uint8_t val=140) {
-    if(val >= 30 && val <= 140) {
-      crsftxrate = val;
+  inline const uint16_t& getCrsfTxRate() {return crsftxrate;}
+  bool setCrsfTxRate(uint16_t val=140) {
+    if(val >= 30 && val <= 1000) {
+      if(crsftxrate != val) {
+        crsftxrate = val;
+        settinggen[64] = ++generation;
+      }
       return true;
     }
     return false;
@@ -729,7 +936,10 @@ public:
   inline const uint8_t& getSbusTxRate() {return sbustxrate;}
   bool setSbusTxRate(uint8_t val=80) {
     if(val >= 30 && val <= 140) {
-      sbustxrate = val;
+      if(sbustxrate != val) {
+        sbustxrate = val;
+        settinggen[65] = ++generation;
+      }
       return true;
     }
     return false;
@@ -737,25 +947,61 @@ public:
 
   // SBUS Receieve Inverted
   inline const bool& getSbInInv() {return sbininv;}
-  void setSbInInv(bool val=true) { sbininv = val; }
+  void setSbInInv(bool val=true) {
+    if(sbininv != val) {
+      sbininv = val;
+      settinggen[66] = ++generation;
+    }
+  }
 
   // SBUS Transmit Inverted
   inline const bool& getSbOutInv() {return sboutinv;}
-  void setSbOutInv(bool val=true) { sboutinv = val; }
+  void setSbOutInv(bool val=true) {
+    if(sboutinv != val) {
+      sboutinv = val;
+      settinggen[67] = ++generation;
+    }
+  }
 
   // Invert CRSF output
   inline const bool& getCrsfTxInv() {return crsftxinv;}
-  void setCrsfTxInv(bool val=false) { crsftxinv = val; }
+  void setCrsfTxInv(bool val=false) {
+    if(crsftxinv != val) {
+      crsftxinv = val;
+      settinggen[68] = ++generation;
+    }
+  }
+
+  // CRSF Output Baud Rate (0=400000 1=921600 2=1000000)
+  inline const uint8_t& getCrsfTxBaud() {return crsftxbaud;}
+  bool setCrsfTxBaud(uint8_t val=0) {
+    if(val >= 0 && val <= 2) {
+      if(crsftxbaud != val) {
+        crsftxbaud = val;
+        settinggen[69] = ++generation;
+      }
+      return true;
+    }
+    return false;
+  }
 
   // Set channel 5 to 2000us
   inline const bool& getCh5Arm() {return ch5arm;}
-  void setCh5Arm(bool val=false) { ch5arm = val; }
+  void setCh5Arm(bool val=false) {
+    if(ch5arm != val) {
+      ch5arm = val;
+      settinggen[70] = ++generation;
+    }
+  }
 
   // Bluetooth Mode (-1=Uninit, 0-Disable, 1-Head, 2-Receive, 3-Scanner, 4-Gamepad)
   inline const int8_t& getBtMode() {return btmode;}
   bool setBtMode(int8_t val=0) {
     if(val >= 0 && val <= 4) {
-      btmode = val;
+      if(btmode != val) {
+        btmode = val;
+        settinggen[71] = ++generation;
+      }
       return true;
     }
     return false;
@@ -763,25 +1009,48 @@ public:
 
   // Reset on Proximity Sense
   inline const bool& getRstOnWave() {return rstonwave;}
-  void setRstOnWave(bool val=false) { rstonwave = val; }
+  void setRstOnWave(bool val=false) {
+    if(rstonwave != val) {
+      rstonwave = val;
+      settinggen[72] = ++generation;
+    }
+  }
 
   // Long Press on the Button to Enable/Disable Tilt Roll and Pan
   inline const bool& getButLngPs() {return butlngps;}
-  void setButLngPs(bool val=false) { butlngps = val; }
+  void setButLngPs(bool val=false) {
+    if(butlngps != val) {
+      butlngps = val;
+      settinggen[73] = ++generation;
+    }
+  }
 
   // Reset Center on a Head Tilt
   inline const bool& getRstOnTlt() {return rstontlt;}
-  void setRstOnTlt(bool val=false) { rstontlt = val; }
+  void setRstOnTlt(bool val=false) {
+    if(rstontlt != val) {
+      rstontlt = val;
+      settinggen[74] = ++generation;
+    }
+  }
 
   // Reset on a double tap
   inline const bool& getRstOnDbltTap() {return rstondblttap;}
-  void setRstOnDbltTap(bool val=false) { rstondblttap = val; }
+  void setRstOnDbltTap(bool val=false) {
+    if(rstondblttap != val) {
+      rstondblttap = val;
+      settinggen[75] = ++generation;
+    }
+  }
 
   // Double Tap Threshold
   inline const float& getRstOnDblTapThres() {return rstondbltapthres;}
   bool setRstOnDblTapThres(float val=80) {
     if(val >= 50 && val <= 200) {
-      rstondbltapthres = val;
+      if(rstondbltapthres != val) {
+        rstondbltapthres = val;
+        settinggen[76] = ++generation;
+      }
       return true;
     }
     return false;
@@ -791,7 +1060,10 @@ public:
   inline const float& getRstOnDblTapMin() {return rstondbltapmin;}
   bool setRstOnDblTapMin(float val=100) {
     if(val >= 50 && val <= 400) {
-      rstondbltapmin = val;
+      if(rstondbltapmin != val) {
+        rstondbltapmin = val;
+        settinggen[77] = ++generation;
+      }
       return true;
     }
     return false;
@@ -801,7 +1073,10 @@ public:
   inline const float& getRstOnDblTapMax() {return rstondbltapmax;}
   bool setRstOnDblTapMax(float val=400) {
     if(val >= 20 && val <= 1000) {
-      rstondbltapmax = val;
+      if(rstondbltapmax != val) {
+        rstondbltapmax = val;
+        settinggen[78] = ++generation;
+      }
       return true;
     }
     return false;
@@ -809,17 +1084,30 @@ public:
 
   // Invert PPM Output
   inline const bool& getPpmOutInvert() {return ppmoutinvert;}
-  void setPpmOutInvert(bool val=false) { ppmoutinvert = val; }
+  void setPpmOutInvert(bool val=false) {
+    if(ppmoutinvert != val) {
+      ppmoutinvert = val;
+      settinggen[79] = ++generation;
+    }
+  }
 
   // Invert PPM Output
   inline const bool& getPpmInInvert() {return ppmininvert;}
-  void setPpmInInvert(bool val=false) { ppmininvert = val; }
+  void setPpmInInvert(bool val=false) {
+    if(ppmininvert != val) {
+      ppmininvert = val;
+      settinggen[80] = ++generation;
+    }
+  }
 
   // PPM Frame Length (us)
   inline const uint16_t& getPpmFrame() {return ppmframe;}
   bool setPpmFrame(uint16_t val=22500) {
     if(val >= PPM_MIN_FRAME && val <= PPM_MAX_FRAME) {
-      ppmframe = val;
+      if(ppmframe != val) {
+        ppmframe = val;
+        settinggen[81] = ++generation;
+      }
       return true;
     }
     return false;
@@ -829,7 +1117,10 @@ public:
   inline const uint16_t& getPpmSync() {return ppmsync;}
   bool setPpmSync(uint16_t val=350) {
     if(val >= 100 && val <= 800) {
-      ppmsync = val;
+      if(ppmsync != val) {
+        ppmsync = val;
+        settinggen[82] = ++generation;
+      }
       return true;
     }
     return false;
@@ -839,7 +1130,23 @@ public:
   inline const uint8_t& getPpmChCnt() {return ppmchcnt;}
   bool setPpmChCnt(uint8_t val=8) {
     if(val >= 1 && val <= 16) {
-      ppmchcnt = val;
+      if(ppmchcnt != val) {
+        ppmchcnt = val;
+        settinggen[83] = ++generation;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  // GUI Data Bandwidth (bytes/s)
+  inline const uint16_t& getDataBudget() {return databudget;}
+  bool setDataBudget(uint16_t val=12000) {
+    if(val >= 1000 && val <= 60000) {
+      if(databudget != val) {
+        databudget = val;
+        settinggen[84] = ++generation;
+      }
       return true;
     }
     return false;
@@ -848,6 +1155,8 @@ public:
   // Bluetooth Remote address to Pair With
   void getBtPairedAddress(char* dest) {strcpy(dest, btpairedaddress);}
   void setBtPairedAddress(const char *val) {
+    if(strncmp(btpairedaddress, val, 17) != 0)
+      settinggen[85] = ++generation;
     strncpy(btpairedaddress, val, 17+1);
     btpairedaddress[17] = '\0';
   }
@@ -945,6 +1254,15 @@ public:
   // Gyro Has Been Calibrated
   void setDataGyroCal(bool val) { gyrocal = val; }
 
+  // Uart Output Frame Rate (Hz)
+  void setDataUartTxRate(uint16_t val) { uarttxrate = val; }
+
+  // Uart Output Frame Jitter (us)
+  void setDataUartTxJit(uint16_t val) { uarttxjit = val; }
+
+  // Uart Output Channel Age (us)
+  void setDataUartTxAge(uint16_t val) { uarttxage = val; }
+
   // Channel Outputs
   void setDataChOut(const uint16_t val[16]) {
     memcpy(chout, val, sizeof(uint16_t) * 16);
@@ -982,90 +1300,94 @@ public:
     btrmt[18] = '\0';
   }
 
-  void setJSONSettings(JsonDocument &json) {
-    json["rll_min"] = rll_min;
-    json["rll_max"] = rll_max;
-    json["rll_cnt"] = rll_cnt;
-    json["rll_gain"] = rll_gain;
-    json["tlt_min"] = tlt_min;
-    json["tlt_max"] = tlt_max;
-    json["tlt_cnt"] = tlt_cnt;
-    json["tlt_gain"] = tlt_gain;
-    json["pan_min"] = pan_min;
-    json["pan_max"] = pan_max;
-    json["pan_cnt"] = pan_cnt;
-    json["pan_gain"] = pan_gain;
-    json["tltch"] = tltch;
-    json["rllch"] = rllch;
-    json["panch"] = panch;
-    json["alertch"] = alertch;
-    json["pwm0"] = pwm0;
-    json["pwm1"] = pwm1;
-    json["pwm2"] = pwm2;
-    json["pwm3"] = pwm3;
-    json["an0ch"] = an0ch;
-    json["an1ch"] = an1ch;
-    json["an2ch"] = an2ch;
-    json["an3ch"] = an3ch;
-    json["aux0ch"] = aux0ch;
-    json["aux1ch"] = aux1ch;
-    json["aux2ch"] = aux2ch;
-    json["rstppm"] = rstppm;
-    json["aux0func"] = aux0func;
-    json["aux1func"] = aux1func;
-    json["aux2func"] = aux2func;
-    json["an0gain"] = an0gain;
-    json["an1gain"] = an1gain;
-    json["an2gain"] = an2gain;
-    json["an3gain"] = an3gain;
-    json["an0off"] = an0off;
-    json["an1off"] = an1off;
-    json["an2off"] = an2off;
-    json["an3off"] = an3off;
-    json["servoreverse"] = servoreverse;
-    json["magxoff"] = magxoff;
-    json["magyoff"] = magyoff;
-    json["magzoff"] = magzoff;
-    json["accxoff"] = accxoff;
-    json["accyoff"] = accyoff;
-    json["acczoff"] = acczoff;
-    json["gyrxoff"] = gyrxoff;
-    json["gyryoff"] = gyryoff;
-    json["gyrzoff"] = gyrzoff;
-    json["so00"] = so00;
-    json["so01"] = so01;
-    json["so02"] = so02;
-    json["so10"] = so10;
-    json["so11"] = so11;
-    json["so12"] = so12;
-    json["so20"] = so20;
-    json["so21"] = so21;
-    json["so22"] = so22;
-    json["dismag"] = dismag;
-    json["rotx"] = rotx;
-    json["roty"] = roty;
-    json["rotz"] = rotz;
-    json["uartmode"] = uartmode;
-    json["crsftxrate"] = crsftxrate;
-    json["sbustxrate"] = sbustxrate;
-    json["sbininv"] = sbininv;
-    json["sboutinv"] = sboutinv;
-    json["crsftxinv"] = crsftxinv;
-    json["ch5arm"] = ch5arm;
-    json["btmode"] = btmode;
-    json["rstonwave"] = rstonwave;
-    json["butlngps"] = butlngps;
-    json["rstontlt"] = rstontlt;
-    json["rstondblttap"] = rstondblttap;
-    json["rstondbltapthres"] = rstondbltapthres;
-    json["rstondbltapmin"] = rstondbltapmin;
-    json["rstondbltapmax"] = rstondbltapmax;
-    json["ppmoutinvert"] = ppmoutinvert;
-    json["ppmininvert"] = ppmininvert;
-    json["ppmframe"] = ppmframe;
-    json["ppmsync"] = ppmsync;
-    json["ppmchcnt"] = ppmchcnt;
-    json["btpairedaddress"] = btpairedaddress;
+  // Writes settings changed in generation since or later, 0 = all settings
+  void setJSONSettings(JsonDocument &json, uint32_t since = 0) {
+    if (settinggen[0] >= since) json["rll_min"] = rll_min;
+    if (settinggen[1] >= since) json["rll_max"] = rll_max;
+    if (settinggen[2] >= since) json["rll_cnt"] = rll_cnt;
+    if (settinggen[3] >= since) json["rll_gain"] = rll_gain;
+    if (settinggen[4] >= since) json["tlt_min"] = tlt_min;
+    if (settinggen[5] >= since) json["tlt_max"] = tlt_max;
+    if (settinggen[6] >= since) json["tlt_cnt"] = tlt_cnt;
+    if (settinggen[7] >= since) json["tlt_gain"] = tlt_gain;
+    if (settinggen[8] >= since) json["pan_min"] = pan_min;
+    if (settinggen[9] >= since) json["pan_max"] = pan_max;
+    if (settinggen[10] >= since) json["pan_cnt"] = pan_cnt;
+    if (settinggen[11] >= since) json["pan_gain"] = pan_gain;
+    if (settinggen[12] >= since) json["tltch"] = tltch;
+    if (settinggen[13] >= since) json["rllch"] = rllch;
+    if (settinggen[14] >= since) json["panch"] = panch;
+    if (settinggen[15] >= since) json["alertch"] = alertch;
+    if (settinggen[16] >= since) json["pwm0"] = pwm0;
+    if (settinggen[17] >= since) json["pwm1"] = pwm1;
+    if (settinggen[18] >= since) json["pwm2"] = pwm2;
+    if (settinggen[19] >= since) json["pwm3"] = pwm3;
+    if (settinggen[20] >= since) json["pwmrate"] = pwmrate;
+    if (settinggen[21] >= since) json["an0ch"] = an0ch;
+    if (settinggen[22] >= since) json["an1ch"] = an1ch;
+    if (settinggen[23] >= since) json["an2ch"] = an2ch;
+    if (settinggen[24] >= since) json["an3ch"] = an3ch;
+    if (settinggen[25] >= since) json["aux0ch"] = aux0ch;
+    if (settinggen[26] >= since) json["aux1ch"] = aux1ch;
+    if (settinggen[27] >= since) json["aux2ch"] = aux2ch;
+    if (settinggen[28] >= since) json["rstppm"] = rstppm;
+    if (settinggen[29] >= since) json["aux0func"] = aux0func;
+    if (settinggen[30] >= since) json["aux1func"] = aux1func;
+    if (settinggen[31] >= since) json["aux2func"] = aux2func;
+    if (settinggen[32] >= since) json["an0gain"] = an0gain;
+    if (settinggen[33] >= since) json["an1gain"] = an1gain;
+    if (settinggen[34] >= since) json["an2gain"] = an2gain;
+    if (settinggen[35] >= since) json["an3gain"] = an3gain;
+    if (settinggen[36] >= since) json["an0off"] = an0off;
+    if (settinggen[37] >= since) json["an1off"] = an1off;
+    if (settinggen[38] >= since) json["an2off"] = an2off;
+    if (settinggen[39] >= since) json["an3off"] = an3off;
+    if (settinggen[40] >= since) json["servoreverse"] = servoreverse;
+    if (settinggen[41] >= since) json["magxoff"] = magxoff;
+    if (settinggen[42] >= since) json["magyoff"] = magyoff;
+    if (settinggen[43] >= since) json["magzoff"] = magzoff;
+    if (settinggen[44] >= since) json["accxoff"] = accxoff;
+    if (settinggen[45] >= since) json["accyoff"] = accyoff;
+    if (settinggen[46] >= since) json["acczoff"] = acczoff;
+    if (settinggen[47] >= since) json["gyrxoff"] = gyrxoff;
+    if (settinggen[48] >= since) json["gyryoff"] = gyryoff;
+    if (settinggen[49] >= since) json["gyrzoff"] = gyrzoff;
+    if (settinggen[50] >= since) json["so00"] = so00;
+    if (settinggen[51] >= since) json["so01"] = so01;
+    if (settinggen[52] >= since) json["so02"] = so02;
+    if (settinggen[53] >= since) json["so10"] = so10;
+    if (settinggen[54] >= since) json["so11"] = so11;
+    if (settinggen[55] >= since) json["so12"] = so12;
+    if (settinggen[56] >= since) json["so20"] = so20;
+    if (settinggen[57] >= since) json["so21"] = so21;
+    if (settinggen[58] >= since) json["so22"] = so22;
+    if (settinggen[59] >= since) json["dismag"] = dismag;
+    if (settinggen[60] >= since) json["rotx"] = rotx;
+    if (settinggen[61] >= since) json["roty"] = roty;
+    if (settinggen[62] >= since) json["rotz"] = rotz;
+    if (settinggen[63] >= since) json["uartmode"] = uartmode;
+    if (settinggen[64] >= since) json["crsftxrate"] = crsftxrate;
+    if (settinggen[65] >= since) json["sbustxrate"] = sbustxrate;
+    if (settinggen[66] >= since) json["sbininv"] = sbininv;
+    if (settinggen[67] >= since) json["sboutinv"] = sboutinv;
+    if (settinggen[68] >= since) json["crsftxinv"] = crsftxinv;
+    if (settinggen[69] >= since) json["crsftxbaud"] = crsftxbaud;
+    if (settinggen[70] >= since) json["ch5arm"] = ch5arm;
+    if (settinggen[71] >= since) json["btmode"] = btmode;
+    if (settinggen[72] >= since) json["rstonwave"] = rstonwave;
+    if (settinggen[73] >= since) json["butlngps"] = butlngps;
+    if (settinggen[74] >= since) json["rstontlt"] = rstontlt;
+    if (settinggen[75] >= since) json["rstondblttap"] = rstondblttap;
+    if (settinggen[76] >= since) json["rstondbltapthres"] = rstondbltapthres;
+    if (settinggen[77] >= since) json["rstondbltapmin"] = rstondbltapmin;
+    if (settinggen[78] >= since) json["rstondbltapmax"] = rstondbltapmax;
+    if (settinggen[79] >= since) json["ppmoutinvert"] = ppmoutinvert;
+    if (settinggen[80] >= since) json["ppmininvert"] = ppmininvert;
+    if (settinggen[81] >= since) json["ppmframe"] = ppmframe;
+    if (settinggen[82] >= since) json["ppmsync"] = ppmsync;
+    if (settinggen[83] >= since) json["ppmchcnt"] = ppmchcnt;
+    if (settinggen[84] >= since) json["databudget"] = databudget;
+    if (settinggen[85] >= since) json["btpairedaddress"] = btpairedaddress;
   }
 
   void loadJSONSettings(JsonDocument &json) {
@@ -1091,6 +1413,7 @@ public:
     v = json["pwm1"]; if(!v.isNull()) {setPwm1(v);}
     v = json["pwm2"]; if(!v.isNull()) {setPwm2(v);}
     v = json["pwm3"]; if(!v.isNull()) {setPwm3(v);}
+    v = json["pwmrate"]; if(!v.isNull()) {setPwmRate(v);}
     v = json["an0ch"]; if(!v.isNull()) {setAn0Ch(v);}
     v = json["an1ch"]; if(!v.isNull()) {setAn1Ch(v);}
     v = json["an2ch"]; if(!v.isNull()) {setAn2Ch(v);}
@@ -1139,6 +1462,7 @@ public:
     v = json["sbininv"]; if(!v.isNull()) {setSbInInv(v);}
     v = json["sboutinv"]; if(!v.isNull()) {setSbOutInv(v);}
     v = json["crsftxinv"]; if(!v.isNull()) {setCrsfTxInv(v);}
+    v = json["crsftxbaud"]; if(!v.isNull()) {setCrsfTxBaud(v);}
     v = json["ch5arm"]; if(!v.isNull()) {setCh5Arm(v);}
     v = json["btmode"]; if(!v.isNull()) {setBtMode(v);}
     v = json["rstonwave"]; if(!v.isNull()) {setRstOnWave(v);}
@@ -1153,11 +1477,410 @@ public:
     v = json["ppmframe"]; if(!v.isNull()) {setPpmFrame(v);}
     v = json["ppmsync"]; if(!v.isNull()) {setPpmSync(v);}
     v = json["ppmchcnt"]; if(!v.isNull()) {setPpmChCnt(v);}
+    v = json["databudget"]; if(!v.isNull()) {setDataBudget(v);}
     v = json["btpairedaddress"]; if(!v.isNull()) {setBtPairedAddress(v);}
     if(chresetfusion)
       resetFusion();
   }
 
+  // Types of the settings image fields, stored in flash so only add to the end
+  enum SettingType : uint8_t {
+    SETTING_BOOL,
+    SETTING_CHAR,
+    SETTING_U8,
+    SETTING_S8,
+    SETTING_U16,
+    SETTING_S16,
+    SETTING_U32,
+    SETTING_S32,
+    SETTING_FLOAT,
+    SETTING_DOUBLE,
+  };
+
+  // Hash of the settings image layout, an image with another schema has to be migrated
+  static constexpr uint32_t SETTINGS_SCHEMA = 0x8f67357du;
+
+  struct __attribute__((packed)) SettingsImage {
+    uint16_t rll_min;
+    uint16_t rll_max;
+    uint16_t rll_cnt;
+    float rll_gain;
+    uint16_t tlt_min;
+    uint16_t tlt_max;
+    uint16_t tlt_cnt;
+    float tlt_gain;
+    uint16_t pan_min;
+    uint16_t pan_max;
+    uint16_t pan_cnt;
+    float pan_gain;
+    int8_t tltch;
+    int8_t rllch;
+    int8_t panch;
+    int8_t alertch;
+    int8_t pwm0;
+    int8_t pwm1;
+    int8_t pwm2;
+    int8_t pwm3;
+    uint16_t pwmrate;
+    int8_t an0ch;
+    int8_t an1ch;
+    int8_t an2ch;
+    int8_t an3ch;
+    int8_t aux0ch;
+    int8_t aux1ch;
+    int8_t aux2ch;
+    int8_t rstppm;
+    uint8_t aux0func;
+    uint8_t aux1func;
+    uint8_t aux2func;
+    float an0gain;
+    float an1gain;
+    float an2gain;
+    float an3gain;
+    float an0off;
+    float an1off;
+    float an2off;
+    float an3off;
+    uint8_t servoreverse;
+    float magxoff;
+    float magyoff;
+    float magzoff;
+    float accxoff;
+    float accyoff;
+    float acczoff;
+    float gyrxoff;
+    float gyryoff;
+    float gyrzoff;
+    float so00;
+    float so01;
+    float so02;
+    float so10;
+    float so11;
+    float so12;
+    float so20;
+    float so21;
+    float so22;
+    bool dismag;
+    float rotx;
+    float roty;
+    float rotz;
+    uint8_t uartmode;
+    uint16_t crsftxrate;
+    uint8_t sbustxrate;
+    bool sbininv;
+    bool sboutinv;
+    bool crsftxinv;
+    uint8_t crsftxbaud;
+    bool ch5arm;
+    int8_t btmode;
+    bool rstonwave;
+    bool butlngps;
+    bool rstontlt;
+    bool rstondblttap;
+    float rstondbltapthres;
+    float rstondbltapmin;
+    float rstondbltapmax;
+    bool ppmoutinvert;
+    bool ppmininvert;
+    uint16_t ppmframe;
+    uint16_t ppmsync;
+    uint8_t ppmchcnt;
+    uint16_t databudget;
+    char btpairedaddress[18];
+  };
+
+  // Where each setting is in the image, found by name when migrating
+  struct __attribute__((packed)) SettingsField {
+    uint32_t name; // nameHash of the setting name, FNV-1a offset basis seed
+    uint16_t offset;
+    uint8_t type;
+    uint8_t size;
+  };
+
+  static constexpr int SETTINGS_FIELD_COUNT = 86;
+
+  static const SettingsField *settingsFields()
+  {
+    static const SettingsField fields[SETTINGS_FIELD_COUNT] = {
+      {0x1bf108au, 0, 4, 2}, // rll_min
+      {0xbd2a800u, 2, 4, 2}, // rll_max
+      {0x601af6adu, 4, 4, 2}, // rll_cnt
+      {0xa4bbf1b1u, 6, 8, 4}, // rll_gain
+      {0x56d4ec90u, 10, 4, 2}, // tlt_min
+      {0x4cc1551au, 12, 4, 2}, // tlt_max
+      {0x43489cd7u, 14, 4, 2}, // tlt_cnt
+      {0xfbf62b9fu, 16, 8, 4}, // tlt_gain
+      {0x521d7263u, 20, 4, 2}, // pan_min
+      {0x4830ea5du, 22, 4, 2}, // pan_max
+      {0xc412212cu, 24, 4, 2}, // pan_cnt
+      {0x87e882b2u, 26, 8, 4}, // pan_gain
+      {0x74a43e70u, 30, 3, 1}, // tltch
+      {0x8266b9beu, 31, 3, 1}, // rllch
+      {0xed0d892fu, 32, 3, 1}, // panch
+      {0x9c8c1772u, 33, 3, 1}, // alertch
+      {0x86140d9du, 34, 3, 1}, // pwm0
+      {0x85140c0au, 35, 3, 1}, // pwm1
+      {0x84140a77u, 36, 3, 1}, // pwm2
+      {0x831408e4u, 37, 3, 1}, // pwm3
+      {0x735da345u, 38, 4, 2}, // pwmrate
+      {0xecf308a1u, 40, 3, 1}, // an0ch
+      {0x37de4bfeu, 41, 3, 1}, // an1ch
+      {0xf86ca6ffu, 42, 3, 1}, // an2ch
+      {0x62a53144u, 43, 3, 1}, // an3ch
+      {0x444fbf30u, 44, 3, 1}, // aux0ch
+      {0xba17028bu, 45, 3, 1}, // aux1ch
+      {0x2988f31au, 46, 3, 1}, // aux2ch
+      {0x11276abdu, 47, 3, 1}, // rstppm
+      {0x6cf85141u, 48, 2, 1}, // aux0func
+      {0xa34a9cdeu, 49, 2, 1}, // aux1func
+      {0x2c74a42bu, 50, 2, 1}, // aux2func
+      {0x25256fa5u, 51, 8, 4}, // an0gain
+      {0xe4b2fd2eu, 55, 8, 4}, // an1gain
+      {0x790d91fu, 59, 8, 4}, // an2gain
+      {0x2b18188u, 63, 8, 4}, // an3gain
+      {0xe2684d3fu, 67, 8, 4}, // an0off
+      {0x3d2d285au, 71, 8, 4}, // an1off
+      {0x90be5de1u, 75, 8, 4}, // an2off
+      {0x7098037cu, 79, 8, 4}, // an3off
+      {0x18c902fcu, 83, 2, 1}, // servoreverse
+      {0x37e86f09u, 84, 8, 4}, // magxoff
+      {0x52ab5264u, 88, 8, 4}, // magyoff
+      {0x4db9e387u, 92, 8, 4}, // magzoff
+      {0xcbeb8d63u, 96, 8, 4}, // accxoff
+      {0xe6ae70beu, 100, 8, 4}, // accyoff
+      {0x8ac81005u, 104, 8, 4}, // acczoff
+      {0x98f8d61cu, 108, 8, 4}, // gyrxoff
+      {0xb6a33481u, 112, 8, 4}, // gyryoff
+      {0x4c3fb2fau, 116, 8, 4}, // gyrzoff
+      {0x3392c0cfu, 120, 8, 4}, // so00
+      {0x3292bf3cu, 124, 8, 4}, // so01
+      {0x3592c3f5u, 128, 8, 4}, // so02
+      {0x2d9078c6u, 132, 8, 4}, // so10
+      {0x2e907a59u, 136, 8, 4}, // so11
+      {0x2b9075a0u, 140, 8, 4}, // so12
+      {0xc78d999du, 144, 8, 4}, // so20
+      {0xc68d980au, 148, 8, 4}, // so21
+      {0xc58d9677u, 152, 8, 4}, // so22
+      {0x70d7a09eu, 156, 0, 1}, // dismag
+      {0x2b3b86c2u, 157, 8, 4}, // rotx
+      {0x2c3b8855u, 161, 8, 4}, // roty
+      {0x293b839cu, 165, 8, 4}, // rotz
+      {0x9b72bce2u, 169, 2, 1}, // uartmode
+      {0x337b207bu, 170, 4, 2}, // crsftxrate
+      {0xe9faceeau, 172, 2, 1}, // sbustxrate
+      {0x53f919f6u, 173, 0, 1}, // sbininv
+      {0xb7b0e957u, 174, 0, 1}, // sboutinv
+      {0xb7f19634u, 175, 0, 1}, // crsftxinv
+      {0x6e76861u, 176, 2, 1}, // crsftxbaud
+      {0x17f41ac1u, 177, 0, 1}, // ch5arm
+      {0xa4813a4cu, 178, 3, 1}, // btmode
+      {0x3d1f71fau, 179, 0, 1}, // rstonwave
+      {0x814ed22u, 180, 0, 1}, // butlngps
+      {0xc9ffbf25u, 181, 0, 1}, // rstontlt
+      {0x1a76c922u, 182, 0, 1}, // rstondblttap
+      {0x183ed8d6u, 183, 8, 4}, // rstondbltapthres
+      {0xa344f668u, 187, 8, 4}, // rstondbltapmin
+      {0x99586e62u, 191, 8, 4}, // rstondbltapmax
+      {0xc189fd28u, 195, 0, 1}, // ppmoutinvert
+      {0xd5bc356fu, 196, 0, 1}, // ppmininvert
+      {0x625279cdu, 197, 4, 2}, // ppmframe
+      {0x327daa5bu, 199, 4, 2}, // ppmsync
+      {0x8ba3c01au, 201, 2, 1}, // ppmchcnt
+      {0xc234368u, 202, 4, 2}, // databudget
+      {0x97c46ecau, 204, 1, 18}, // btpairedaddress
+    };
+    return fields;
+  }
+  static_assert(sizeof(SettingsImage) == 222, "Settings image layout mismatch");
+
+  // Copies the current settings into img
+  void getSettingsImage(SettingsImage &img) {
+    img.rll_min = rll_min;
+    img.rll_max = rll_max;
+    img.rll_cnt = rll_cnt;
+    img.rll_gain = rll_gain;
+    img.tlt_min = tlt_min;
+    img.tlt_max = tlt_max;
+    img.tlt_cnt = tlt_cnt;
+    img.tlt_gain = tlt_gain;
+    img.pan_min = pan_min;
+    img.pan_max = pan_max;
+    img.pan_cnt = pan_cnt;
+    img.pan_gain = pan_gain;
+    img.tltch = tltch;
+    img.rllch = rllch;
+    img.panch = panch;
+    img.alertch = alertch;
+    img.pwm0 = pwm0;
+    img.pwm1 = pwm1;
+    img.pwm2 = pwm2;
+    img.pwm3 = pwm3;
+    img.pwmrate = pwmrate;
+    img.an0ch = an0ch;
+    img.an1ch = an1ch;
+    img.an2ch = an2ch;
+    img.an3ch = an3ch;
+    img.aux0ch = aux0ch;
+    img.aux1ch = aux1ch;
+    img.aux2ch = aux2ch;
+    img.rstppm = rstppm;
+    img.aux0func = aux0func;
+    img.aux1func = aux1func;
+    img.aux2func = aux2func;
+    img.an0gain = an0gain;
+    img.an1gain = an1gain;
+    img.an2gain = an2gain;
+    img.an3gain = an3gain;
+    img.an0off = an0off;
+    img.an1off = an1off;
+    img.an2off = an2off;
+    img.an3off = an3off;
+    img.servoreverse = servoreverse;
+    img.magxoff = magxoff;
+    img.magyoff = magyoff;
+    img.magzoff = magzoff;
+    img.accxoff = accxoff;
+    img.accyoff = accyoff;
+    img.acczoff = acczoff;
+    img.gyrxoff = gyrxoff;
+    img.gyryoff = gyryoff;
+    img.gyrzoff = gyrzoff;
+    img.so00 = so00;
+    img.so01 = so01;
+    img.so02 = so02;
+    img.so10 = so10;
+    img.so11 = so11;
+    img.so12 = so12;
+    img.so20 = so20;
+    img.so21 = so21;
+    img.so22 = so22;
+    img.dismag = dismag;
+    img.rotx = rotx;
+    img.roty = roty;
+    img.rotz = rotz;
+    img.uartmode = uartmode;
+    img.crsftxrate = crsftxrate;
+    img.sbustxrate = sbustxrate;
+    img.sbininv = sbininv;
+    img.sboutinv = sboutinv;
+    img.crsftxinv = crsftxinv;
+    img.crsftxbaud = crsftxbaud;
+    img.ch5arm = ch5arm;
+    img.btmode = btmode;
+    img.rstonwave = rstonwave;
+    img.butlngps = butlngps;
+    img.rstontlt = rstontlt;
+    img.rstondblttap = rstondblttap;
+    img.rstondbltapthres = rstondbltapthres;
+    img.rstondbltapmin = rstondbltapmin;
+    img.rstondbltapmax = rstondbltapmax;
+    img.ppmoutinvert = ppmoutinvert;
+    img.ppmininvert = ppmininvert;
+    img.ppmframe = ppmframe;
+    img.ppmsync = ppmsync;
+    img.ppmchcnt = ppmchcnt;
+    img.databudget = databudget;
+    memcpy(img.btpairedaddress, btpairedaddress, sizeof(img.btpairedaddress));
+  }
+
+  // Loads the settings from img, values out of range are ignored
+  void loadSettingsImage(const SettingsImage &img) {
+    bool chresetfusion = false;
+    if(rll_min != img.rll_min) {setRll_Min(img.rll_min);}
+    if(rll_max != img.rll_max) {setRll_Max(img.rll_max);}
+    if(rll_cnt != img.rll_cnt) {setRll_Cnt(img.rll_cnt);}
+    if(rll_gain != img.rll_gain) {setRll_Gain(img.rll_gain);}
+    if(tlt_min != img.tlt_min) {setTlt_Min(img.tlt_min);}
+    if(tlt_max != img.tlt_max) {setTlt_Max(img.tlt_max);}
+    if(tlt_cnt != img.tlt_cnt) {setTlt_Cnt(img.tlt_cnt);}
+    if(tlt_gain != img.tlt_gain) {setTlt_Gain(img.tlt_gain);}
+    if(pan_min != img.pan_min) {setPan_Min(img.pan_min);}
+    if(pan_max != img.pan_max) {setPan_Max(img.pan_max);}
+    if(pan_cnt != img.pan_cnt) {setPan_Cnt(img.pan_cnt);}
+    if(pan_gain != img.pan_gain) {setPan_Gain(img.pan_gain);}
+    if(tltch != img.tltch) {setTltCh(img.tltch);}
+    if(rllch != img.rllch) {setRllCh(img.rllch);}
+    if(panch != img.panch) {setPanCh(img.panch);}
+    if(alertch != img.alertch) {setAlertCh(img.alertch);}
+    if(pwm0 != img.pwm0) {setPwm0(img.pwm0);}
+    if(pwm1 != img.pwm1) {setPwm1(img.pwm1);}
+    if(pwm2 != img.pwm2) {setPwm2(img.pwm2);}
+    if(pwm3 != img.pwm3) {setPwm3(img.pwm3);}
+    if(pwmrate != img.pwmrate) {setPwmRate(img.pwmrate);}
+    if(an0ch != img.an0ch) {setAn0Ch(img.an0ch);}
+    if(an1ch != img.an1ch) {setAn1Ch(img.an1ch);}
+    if(an2ch != img.an2ch) {setAn2Ch(img.an2ch);}
+    if(an3ch != img.an3ch) {setAn3Ch(img.an3ch);}
+    if(aux0ch != img.aux0ch) {setAux0Ch(img.aux0ch);}
+    if(aux1ch != img.aux1ch) {setAux1Ch(img.aux1ch);}
+    if(aux2ch != img.aux2ch) {setAux2Ch(img.aux2ch);}
+    if(rstppm != img.rstppm) {setRstPpm(img.rstppm);}
+    if(aux0func != img.aux0func) {setAux0Func(img.aux0func);}
+    if(aux1func != img.aux1func) {setAux1Func(img.aux1func);}
+    if(aux2func != img.aux2func) {setAux2Func(img.aux2func);}
+    if(an0gain != img.an0gain) {setAn0Gain(img.an0gain);}
+    if(an1gain != img.an1gain) {setAn1Gain(img.an1gain);}
+    if(an2gain != img.an2gain) {setAn2Gain(img.an2gain);}
+    if(an3gain != img.an3gain) {setAn3Gain(img.an3gain);}
+    if(an0off != img.an0off) {setAn0Off(img.an0off);}
+    if(an1off != img.an1off) {setAn1Off(img.an1off);}
+    if(an2off != img.an2off) {setAn2Off(img.an2off);}
+    if(an3off != img.an3off) {setAn3Off(img.an3off);}
+    if(servoreverse != img.servoreverse) {setServoReverse(img.servoreverse);}
+    if(magxoff != img.magxoff) {setMagXOff(img.magxoff); chresetfusion = true;}
+    if(magyoff != img.magyoff) {setMagYOff(img.magyoff); chresetfusion = true;}
+    if(magzoff != img.magzoff) {setMagZOff(img.magzoff); chresetfusion = true;}
+    if(accxoff != img.accxoff) {setAccXOff(img.accxoff); chresetfusion = true;}
+    if(accyoff != img.accyoff) {setAccYOff(img.accyoff); chresetfusion = true;}
+    if(acczoff != img.acczoff) {setAccZOff(img.acczoff); chresetfusion = true;}
+    if(gyrxoff != img.gyrxoff) {setGyrXOff(img.gyrxoff); chresetfusion = true;}
+    if(gyryoff != img.gyryoff) {setGyrYOff(img.gyryoff); chresetfusion = true;}
+    if(gyrzoff != img.gyrzoff) {setGyrZOff(img.gyrzoff); chresetfusion = true;}
+    if(so00 != img.so00) {setso00(img.so00); chresetfusion = true;}
+    if(so01 != img.so01) {setso01(img.so01); chresetfusion = true;}
+    if(so02 != img.so02) {setso02(img.so02); chresetfusion = true;}
+    if(so10 != img.so10) {setso10(img.so10); chresetfusion = true;}
+    if(so11 != img.so11) {setso11(img.so11); chresetfusion = true;}
+    if(so12 != img.so12) {setso12(img.so12); chresetfusion = true;}
+    if(so20 != img.so20) {setso20(img.so20); chresetfusion = true;}
+    if(so21 != img.so21) {setso21(img.so21); chresetfusion = true;}
+    if(so22 != img.so22) {setso22(img.so22); chresetfusion = true;}
+    if(dismag != img.dismag) {setDisMag(img.dismag);}
+    if(rotx != img.rotx) {setRotX(img.rotx); chresetfusion = true;}
+    if(roty != img.roty) {setRotY(img.roty); chresetfusion = true;}
+    if(rotz != img.rotz) {setRotZ(img.rotz); chresetfusion = true;}
+    if(uartmode != img.uartmode) {setUartMode(img.uartmode);}
+    if(crsftxrate != img.crsftxrate) {setCrsfTxRate(img.crsftxrate);}
+    if(sbustxrate != img.sbustxrate) {setSbusTxRate(img.sbustxrate);}
+    if(sbininv != img.sbininv) {setSbInInv(img.sbininv);}
+    if(sboutinv != img.sboutinv) {setSbOutInv(img.sboutinv);}
+    if(crsftxinv != img.crsftxinv) {setCrsfTxInv(img.crsftxinv);}
+    if(crsftxbaud != img.crsftxbaud) {setCrsfTxBaud(img.crsftxbaud);}
+    if(ch5arm != img.ch5arm) {setCh5Arm(img.ch5arm);}
+    if(btmode != img.btmode) {setBtMode(img.btmode);}
+    if(rstonwave != img.rstonwave) {setRstOnWave(img.rstonwave);}
+    if(butlngps != img.butlngps) {setButLngPs(img.butlngps);}
+    if(rstontlt != img.rstontlt) {setRstOnTlt(img.rstontlt);}
+    if(rstondblttap != img.rstondblttap) {setRstOnDbltTap(img.rstondblttap);}
+    if(rstondbltapthres != img.rstondbltapthres) {setRstOnDblTapThres(img.rstondbltapthres);}
+    if(rstondbltapmin != img.rstondbltapmin) {setRstOnDblTapMin(img.rstondbltapmin);}
+    if(rstondbltapmax != img.rstondbltapmax) {setRstOnDblTapMax(img.rstondbltapmax);}
+    if(ppmoutinvert != img.ppmoutinvert) {setPpmOutInvert(img.ppmoutinvert);}
+    if(ppmininvert != img.ppmininvert) {setPpmInInvert(img.ppmininvert);}
+    if(ppmframe != img.ppmframe) {setPpmFrame(img.ppmframe);}
+    if(ppmsync != img.ppmsync) {setPpmSync(img.ppmsync);}
+    if(ppmchcnt != img.ppmchcnt) {setPpmChCnt(img.ppmchcnt);}
+    if(databudget != img.databudget) {setDataBudget(img.databudget);}
+    {
+      char btpairedaddressbuf[sizeof(img.btpairedaddress)];
+      memcpy(btpairedaddressbuf, img.btpairedaddress, sizeof(btpairedaddressbuf));
+      btpairedaddressbuf[sizeof(btpairedaddressbuf) - 1] = '\0';
+      setBtPairedAddress(btpairedaddressbuf);
+    }
+    if(chresetfusion)
+      resetFusion();
+  }
+
   void setJSONDataList(JsonDocument &json)
   {
     JsonArray array = json.add<JsonArray>();
@@ -1192,6 +1915,9 @@ public:
     array.add("rolloff");
     array.add("panoff");
     array.add("gyrocal");
+    array.add("uarttxrate");
+    array.add("uarttxjit");
+    array.add("uarttxage");
     array.add("chout");
     array.add("btch");
     array.add("ppmch");
@@ -1201,286 +1927,352 @@ public:
     array.add("btrmt");
   }
 
-  // Sets if a data item should be included while in data to GUI
-  void setDataItemSend(const char *var, bool enabled)
+  static constexpr int DATA_ITEM_COUNT = 41;
+
+  // FNV-1a hash used by the generated name lookup tables
+  static uint32_t nameHash(const char *str, uint32_t seed)
   {
-    if (strcmp(var, "magx") == 0) {
-      enabled == true ? senddatavars |= 1 << 1 : senddatavars &= ~(1 << 1);
-      return;
-    }
-    else if (strcmp(var, "magy") == 0) {
-      enabled == true ? senddatavars |= 1 << 2 : senddatavars &= ~(1 << 2);
-      return;
-    }
-    else if (strcmp(var, "magz") == 0) {
-      enabled == true ? senddatavars |= 1 << 3 : senddatavars &= ~(1 << 3);
-      return;
-    }
-    else if (strcmp(var, "gyrox") == 0) {
-      enabled == true ? senddatavars |= 1 << 4 : senddatavars &= ~(1 << 4);
-      return;
-    }
-    else if (strcmp(var, "gyroy") == 0) {
-      enabled == true ? senddatavars |= 1 << 5 : senddatavars &= ~(1 << 5);
-      return;
-    }
-    else if (strcmp(var, "gyroz") == 0) {
-      enabled == true ? senddatavars |= 1 << 6 : senddatavars &= ~(1 << 6);
-      return;
-    }
-    else if (strcmp(var, "accx") == 0) {
-      enabled == true ? senddatavars |= 1 << 7 : senddatavars &= ~(1 << 7);
-      return;
-    }
-    else if (strcmp(var, "accy") == 0) {
-      enabled == true ? senddatavars |= 1 << 8 : senddatavars &= ~(1 << 8);
-      return;
-    }
-    else if (strcmp(var, "accz") == 0) {
-      enabled == true ? senddatavars |= 1 << 9 : senddatavars &= ~(1 << 9);
-      return;
-    }
-    else if (strcmp(var, "off_magx") == 0) {
-      enabled == true ? senddatavars |= 1 << 10 : senddatavars &= ~(1 << 10);
-      return;
-    }
-    else if (strcmp(var, "off_magy") == 0) {
-      enabled == true ? senddatavars |= 1 << 11 : senddatavars &= ~(1 << 11);
-      return;
-    }
-    else if (strcmp(var, "off_magz") == 0) {
-      enabled == true ? senddatavars |= 1 << 12 : senddatavars &= ~(1 << 12);
-      return;
+    uint32_t h = seed;
+    while (*str) {
+      h ^= (uint8_t)*str++;
+      h *= 16777619u;
     }
-    else if (strcmp(var, "off_gyrox") == 0) {
-      enabled == true ? senddatavars |= 1 << 13 : senddatavars &= ~(1 << 13);
-      return;
-    }
-    else if (strcmp(var, "off_gyroy") == 0) {
-      enabled == true ? senddatavars |= 1 << 14 : senddatavars &= ~(1 << 14);
-      return;
-    }
-    else if (strcmp(var, "off_gyroz") == 0) {
-      enabled == true ? senddatavars |= 1 << 15 : senddatavars &= ~(1 << 15);
-      return;
-    }
-    else if (strcmp(var, "off_accx") == 0) {
-      enabled == true ? senddatavars |= 1 << 16 : senddatavars &= ~(1 << 16);
-      return;
-    }
-    else if (strcmp(var, "off_accy") == 0) {
-      enabled == true ? senddatavars |= 1 << 17 : senddatavars &= ~(1 << 17);
-      return;
-    }
-    else if (strcmp(var, "off_accz") == 0) {
-      enabled == true ? senddatavars |= 1 << 18 : senddatavars &= ~(1 << 18);
-      return;
-    }
-    else if (strcmp(var, "tiltout") == 0) {
-      enabled == true ? senddatavars |= 1 << 19 : senddatavars &= ~(1 << 19);
-      return;
-    }
-    else if (strcmp(var, "rollout") == 0) {
-      enabled == true ? senddatavars |= 1 << 20 : senddatavars &= ~(1 << 20);
-      return;
-    }
-    else if (strcmp(var, "panout") == 0) {
-      enabled == true ? senddatavars |= 1 << 21 : senddatavars &= ~(1 << 21);
-      return;
-    }
-    else if (strcmp(var, "iscal") == 0) {
-      enabled == true ? senddatavars |= 1 << 22 : senddatavars &= ~(1 << 22);
-      return;
-    }
-    else if (strcmp(var, "btcon") == 0) {
-      enabled == true ? senddatavars |= 1 << 23 : senddatavars &= ~(1 << 23);
-      return;
-    }
-    else if (strcmp(var, "trpenabled") == 0) {
-      enabled == true ? senddatavars |= 1 << 24 : senddatavars &= ~(1 << 24);
-      return;
-    }
-    else if (strcmp(var, "tilt") == 0) {
-      enabled == true ? senddatavars |= 1 << 25 : senddatavars &= ~(1 << 25);
-      return;
-    }
-    else if (strcmp(var, "roll") == 0) {
-      enabled == true ? senddatavars |= 1 << 26 : senddatavars &= ~(1 << 26);
-      return;
-    }
-    else if (strcmp(var, "pan") == 0) {
-      enabled == true ? senddatavars |= 1 << 27 : senddatavars &= ~(1 << 27);
-      return;
-    }
-    else if (strcmp(var, "tiltoff") == 0) {
-      enabled == true ? senddatavars |= 1 << 28 : senddatavars &= ~(1 << 28);
-      return;
-    }
-    else if (strcmp(var, "rolloff") == 0) {
-      enabled == true ? senddatavars |= 1 << 29 : senddatavars &= ~(1 << 29);
-      return;
-    }
-    else if (strcmp(var, "panoff") == 0) {
-      enabled == true ? senddatavars |= 1 << 30 : senddatavars &= ~(1 << 30);
-      return;
-    }
-    else if (strcmp(var, "gyrocal") == 0) {
-      enabled == true ? senddatavars |= 1 << 31 : senddatavars &= ~(1 << 31);
-      return;
-    }
-    else if (strcmp(var, "chout") == 0) {
-      enabled == true ? senddataarray |= 1 << 1 : senddataarray &= ~(1 << 1);
-      return;
-    }
-    else if (strcmp(var, "btch") == 0) {
-      enabled == true ? senddataarray |= 1 << 2 : senddataarray &= ~(1 << 2);
-      return;
-    }
-    else if (strcmp(var, "ppmch") == 0) {
-      enabled == true ? senddataarray |= 1 << 3 : senddataarray &= ~(1 << 3);
-      return;
-    }
-    else if (strcmp(var, "uartch") == 0) {
-      enabled == true ? senddataarray |= 1 << 4 : senddataarray &= ~(1 << 4);
-      return;
-    }
-    else if (strcmp(var, "quat") == 0) {
-      enabled == true ? senddataarray |= 1 << 5 : senddataarray &= ~(1 << 5);
-      return;
-    }
-    else if (strcmp(var, "btaddr") == 0) {
-      enabled == true ? senddataarray |= 1 << 6 : senddataarray &= ~(1 << 6);
-      return;
+    return h;
+  }
+
+  static const char *dataItemName(int item)
+  {
+    static const char *const names[DATA_ITEM_COUNT] = {
+      "magx",
+      "magy",
+      "magz",
+      "gyrox",
+      "gyroy",
+      "gyroz",
+      "accx",
+      "accy",
+      "accz",
+      "off_magx",
+      "off_magy",
+      "off_magz",
+      "off_gyrox",
+      "off_gyroy",
+      "off_gyroz",
+      "off_accx",
+      "off_accy",
+      "off_accz",
+      "tiltout",
+      "rollout",
+      "panout",
+      "iscal",
+      "btcon",
+      "trpenabled",
+      "tilt",
+      "roll",
+      "pan",
+      "tiltoff",
+      "rolloff",
+      "panoff",
+      "gyrocal",
+      "uarttxrate",
+      "uarttxjit",
+      "uarttxage",
+      "chout",
+      "btch",
+      "ppmch",
+      "uartch",
+      "quat",
+      "btaddr",
+      "btrmt",
+    };
+    return names[item];
+  }
+
+  // Data item index of name, -1 if it isn't a data item
+  static int dataItemIndex(const char *var)
+  {
+    // Hash slot to data item index + 1, 0 = empty
+    static const uint8_t slots[256] = {
+      0, 0, 0, 0, 0, 0, 9, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 28, 0, 0,
+      41, 0, 0, 0, 18, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      38, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      15, 0, 21, 0, 0, 0, 0, 0, 10, 0, 16, 0, 0, 2, 0, 0,
+      0, 0, 0, 0, 0, 32, 34, 5, 0, 0, 0, 0, 0, 0, 0, 0,
+      39, 0, 0, 0, 0, 0, 13, 0, 0, 0, 0, 0, 0, 0, 12, 0,
+      0, 0, 0, 8, 0, 29, 40, 0, 0, 0, 0, 0, 0, 0, 27, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 36, 0, 3, 0, 0, 0, 0, 0, 0, 30, 19, 37, 0, 0,
+      0, 0, 33, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 25, 0, 1, 0, 0, 22, 0, 0,
+      24, 0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      31, 0, 0, 0, 20, 0, 0, 0, 0, 0, 0, 11, 0, 17, 0, 0,
+      7, 0, 0, 0, 0, 0, 0, 23, 35, 0, 6, 0, 0, 0, 0, 0,
+      26, 0, 0, 0, 0, 0, 0, 0, 0, 14, 0, 0, 0, 0, 0, 0,
+    };
+
+    uint8_t item = slots[nameHash(var, 0x811c9dcfu) & 255];
+    if (item == 0 || strcmp(var, dataItemName(item - 1)) != 0)
+      return -1;
+    return item - 1;
+  }
+
+  // Sets if a data item should be included while in data to GUI
+  // rate is in Hz, 0 uses the item's default rate
+  // Returns false and counts the name if it isn't a data item
+  bool setDataItemSend(const char *var, bool enabled, uint16_t rate = 0)
+  {
+    static const uint16_t defaultrate[DATA_ITEM_COUNT] = {
+      10, 10, 10, 10, 10, 10, 10, 10, 10, 5, 5, 5, 5, 5, 5, 5,
+      5, 5, 10, 10, 10, 1, 1, 1, 2, 2, 2, 10, 10, 10, 1, 1,
+      1, 1, 10, 10, 10, 10, 10, 1, 1,
+    };
+
+    int item = dataItemIndex(var);
+    if (item < 0) {
+      unknowndataitems++;
+      return false;
     }
-    else if (strcmp(var, "btrmt") == 0) {
-      enabled == true ? senddataarray |= 1 << 7 : senddataarray &= ~(1 << 7);
-      return;
+    if (!enabled) {
+      datarate[item] = 0;
+      return true;
     }
+    datarate[item] = rate == 0 ? defaultrate[item] : (rate > 1000 ? 1000 : rate);
+    datadue[item] = 0;
+    return true;
   }
 
-  void sendArray(JsonDocument &json,
-                 uint8_t bit,
-                 const uint32_t counter,
-                 int divisor,
+  // Number of unknown data item names requested
+  uint32_t getUnknownDataItems() { return unknowndataitems; }
+
+  bool sendArray(JsonDocument &json,
                  const char *name,
                  void *item,
                  void *lastitem,
-                 int size)
+                 int size,
+                 bool onchange)
   {
-    bool sendit = false;
     char b64array[200];
-    if (senddataarray & (1 << bit)) {
-      if (divisor < 0) {
-        if (memcmp(lastitem, item, size) != 0)
-          sendit = true;
-        else if (divisor != -1 && counter % abs(divisor) == 0)
-          sendit = true;
-      } else {
-        if (counter % divisor == 0)
-          sendit = true;
+    if (onchange && memcmp(lastitem, item, size) == 0)
+      return false;
+    encode_base64((unsigned char *)item, size, (unsigned char *)b64array);
+    json[name] = b64array;
+    memcpy(lastitem, item, size);
+    return true;
+  }
+
+  // Adds a single data item to json, returns false if it didn't need sending
+  // Base64 only done on arrays as it ends up on avg more bytes to
+  //   do everything
+  bool addDataItem(JsonDocument &json, int item)
+  {
+    switch (item) {
+      case 0:
+        json["magx"] = roundf(((float)magx * 1000)) / 1000;
+        return true;
+      case 1:
+        json["magy"] = roundf(((float)magy * 1000)) / 1000;
+        return true;
+      case 2:
+        json["magz"] = roundf(((float)magz * 1000)) / 1000;
+        return true;
+      case 3:
+        json["gyrox"] = roundf(((float)gyrox * 1000)) / 1000;
+        return true;
+      case 4:
+        json["gyroy"] = roundf(((float)gyroy * 1000)) / 1000;
+        return true;
+      case 5:
+        json["gyroz"] = roundf(((float)gyroz * 1000)) / 1000;
+        return true;
+      case 6:
+        json["accx"] = roundf(((float)accx * 1000)) / 1000;
+        return true;
+      case 7:
+        json["accy"] = roundf(((float)accy * 1000)) / 1000;
+        return true;
+      case 8:
+        json["accz"] = roundf(((float)accz * 1000)) / 1000;
+        return true;
+      case 9:
+        json["off_magx"] = roundf(((float)off_magx * 1000)) / 1000;
+        return true;
+      case 10:
+        json["off_magy"] = roundf(((float)off_magy * 1000)) / 1000;
+        return true;
+      case 11:
+        json["off_magz"] = roundf(((float)off_magz * 1000)) / 1000;
+        return true;
+      case 12:
+        json["off_gyrox"] = roundf(((float)off_gyrox * 1000)) / 1000;
+        return true;
+      case 13:
+        json["off_gyroy"] = roundf(((float)off_gyroy * 1000)) / 1000;
+        return true;
+      case 14:
+        json["off_gyroz"] = roundf(((float)off_gyroz * 1000)) / 1000;
+        return true;
+      case 15:
+        json["off_accx"] = roundf(((float)off_accx * 1000)) / 1000;
+        return true;
+      case 16:
+        json["off_accy"] = roundf(((float)off_accy * 1000)) / 1000;
+        return true;
+      case 17:
+        json["off_accz"] = roundf(((float)off_accz * 1000)) / 1000;
+        return true;
+      case 18:
+        json["tiltout"] = tiltout;
+        return true;
+      case 19:
+        json["rollout"] = rollout;
+        return true;
+      case 20:
+        json["panout"] = panout;
+        return true;
+      case 21:
+        json["iscal"] = iscal;
+        return true;
+      case 22:
+        json["btcon"] = btcon;
+        return true;
+      case 23:
+        json["trpenabled"] = trpenabled;
+        return true;
+      case 24:
+        json["tilt"] = roundf(((float)tilt * 1000)) / 1000;
+        return true;
+      case 25:
+        json["roll"] = roundf(((float)roll * 1000)) / 1000;
+        return true;
+      case 26:
+        json["pan"] = roundf(((float)pan * 1000)) / 1000;
+        return true;
+      case 27:
+        json["tiltoff"] = roundf(((float)tiltoff * 1000)) / 1000;
+        return true;
+      case 28:
+        json["rolloff"] = roundf(((float)rolloff * 1000)) / 1000;
+        return true;
+      case 29:
+        json["panoff"] = roundf(((float)panoff * 1000)) / 1000;
+        return true;
+      case 30:
+        json["gyrocal"] = gyrocal;
+        return true;
+      case 31:
+        json["uarttxrate"] = uarttxrate;
+        return true;
+      case 32:
+        json["uarttxjit"] = uarttxjit;
+        return true;
+      case 33:
+        json["uarttxage"] = uarttxage;
+        return true;
+      case 34:
+        return sendArray(json, "6choutu16", (void *)chout, (void *)lastchout,
+                         sizeof(uint16_t) * 16, false);
+      case 35:
+        return sendArray(json, "6btchu16", (void *)btch, (void *)lastbtch,
+                         sizeof(uint16_t) * 8, false);
+      case 36:
+        return sendArray(json, "6ppmchu16", (void *)ppmch, (void *)lastppmch,
+                         sizeof(uint16_t) * 16, false);
+      case 37:
+        return sendArray(json, "6uartchu16", (void *)uartch, (void *)lastuartch,
+                         sizeof(uint16_t) * 16, false);
+      case 38:
+        return sendArray(json, "6quatflt", (void *)quat, (void *)lastquat,
+                         sizeof(float) * 4, false);
+      case 39:
+        return sendArray(json, "6btaddrchr", (void *)btaddr, (void *)lastbtaddr,
+                         sizeof(char) * 18, false);
+      case 40:
+        return sendArray(json, "6btrmtchr", (void *)btrmt, (void *)lastbtrmt,
+                         sizeof(char) * 18, false);
+    }
+    return false;
+  }
+
+  // Sends the requested data items which are due at time now (ms)
+  // Items which don't fit in budget (bytes) wait for the next call, if an item
+  //   misses a whole period it is counted as dropped
+  void setJSONData(JsonDocument &json, uint32_t now, int budget)
+  {
+    static const uint8_t datasize[DATA_ITEM_COUNT] = {
+      17, 17, 17, 18, 18, 18, 17, 17, 17, 21, 21, 21, 22, 22, 22, 21,
+      21, 21, 16, 16, 15, 14, 14, 19, 17, 17, 16, 20, 20, 19, 16, 19,
+      18, 18, 59, 38, 59, 60, 38, 40, 39,
+    };
+
+    // Rotate the starting item so a full budget doesn't always starve the same ones
+    static int first = 0;
+
+    for (int n = 0; n < DATA_ITEM_COUNT; n++) {
+      int item = (first + n) % DATA_ITEM_COUNT;
+      if (datarate[item] == 0 || (int32_t)(now - datadue[item]) < 0) continue;
+
+      uint32_t period = 1000 / datarate[item];
+      if (budget < datasize[item]) {
+        if ((int32_t)(now - datadue[item]) >= (int32_t)period) {
+          datadrops[item]++;
+          datadue[item] += period;
+        }
+        continue;
       }
-      if (sendit) {
-        encode_base64((unsigned char *)item, size, (unsigned char *)b64array);
-        json[name] = b64array;
-        memcpy(lastitem, item, size);
+
+      if (addDataItem(json, item)) {
+        budget -= datasize[item];
+        datasent[item]++;
       }
+      datadue[item] += period;
+      if ((int32_t)(now - datadue[item]) >= 0) datadue[item] = now + period;
     }
+    first = (first + 1) % DATA_ITEM_COUNT;
   }
-  
-  void setJSONData(JsonDocument &json)
+
+  // Achieved rate (Hz) and drops of each requested item over elapsed (ms)
+  // Counts are reset after each call
+  void setJSONDataRates(JsonDocument &json, uint32_t elapsed)
   {
-    // Sends only requested data items
-    // Updates only as often as specified, 1 = every cycle
-    // Base64 only done on arrays as it ends up on avg more bytes to
-    //   do everything
-
-    static uint32_t counter = 0;
-
-    if (senddatavars & (1 << 1) && (counter % 1) == 0)
-      json["magx"] = roundf(((float)magx * 1000)) / 1000;
-    if (senddatavars & (1 << 2) && (counter % 1) == 0)
-      json["magy"] = roundf(((float)magy * 1000)) / 1000;
-    if (senddatavars & (1 << 3) && (counter % 1) == 0)
-      json["magz"] = roundf(((float)magz * 1000)) / 1000;
-    if (senddatavars & (1 << 4) && (counter % 1) == 0)
-      json["gyrox"] = roundf(((float)gyrox * 1000)) / 1000;
-    if (senddatavars & (1 << 5) && (counter % 1) == 0)
-      json["gyroy"] = roundf(((float)gyroy * 1000)) / 1000;
-    if (senddatavars & (1 << 6) && (counter % 1) == 0)
-      json["gyroz"] = roundf(((float)gyroz * 1000)) / 1000;
-    if (senddatavars & (1 << 7) && (counter % 1) == 0)
-      json["accx"] = roundf(((float)accx * 1000)) / 1000;
-    if (senddatavars & (1 << 8) && (counter % 1) == 0)
-      json["accy"] = roundf(((float)accy * 1000)) / 1000;
-    if (senddatavars & (1 << 9) && (counter % 1) == 0)
-      json["accz"] = roundf(((float)accz * 1000)) / 1000;
-    if (senddatavars & (1 << 10) && (counter % 2) == 0)
-      json["off_magx"] = roundf(((float)off_magx * 1000)) / 1000;
-    if (senddatavars & (1 << 11) && (counter % 2) == 0)
-      json["off_magy"] = roundf(((float)off_magy * 1000)) / 1000;
-    if (senddatavars & (1 << 12) && (counter % 2) == 0)
-      json["off_magz"] = roundf(((float)off_magz * 1000)) / 1000;
-    if (senddatavars & (1 << 13) && (counter % 2) == 0)
-      json["off_gyrox"] = roundf(((float)off_gyrox * 1000)) / 1000;
-    if (senddatavars & (1 << 14) && (counter % 2) == 0)
-      json["off_gyroy"] = roundf(((float)off_gyroy * 1000)) / 1000;
-    if (senddatavars & (1 << 15) && (counter % 2) == 0)
-      json["off_gyroz"] = roundf(((float)off_gyroz * 1000)) / 1000;
-    if (senddatavars & (1 << 16) && (counter % 2) == 0)
-      json["off_accx"] = roundf(((float)off_accx * 1000)) / 1000;
-    if (senddatavars & (1 << 17) && (counter % 2) == 0)
-      json["off_accy"] = roundf(((float)off_accy * 1000)) / 1000;
-    if (senddatavars & (1 << 18) && (counter % 2) == 0)
-      json["off_accz"] = roundf(((float)off_accz * 1000)) / 1000;
-    if (senddatavars & (1 << 19) && (counter % 1) == 0)
-      json["tiltout"] = tiltout;
-    if (senddatavars & (1 << 20) && (counter % 1) == 0)
-      json["rollout"] = rollout;
-    if (senddatavars & (1 << 21) && (counter % 1) == 0)
-      json["panout"] = panout;
-    if (senddatavars & (1 << 22) && (counter % 10) == 0)
-      json["iscal"] = iscal;
-    if (senddatavars & (1 << 23) && (counter % 10) == 0)
-      json["btcon"] = btcon;
-    if (senddatavars & (1 << 24) && (counter % 10) == 0)
-      json["trpenabled"] = trpenabled;
-    if (senddatavars & (1 << 25) && (counter % 5) == 0)
-      json["tilt"] = roundf(((float)tilt * 1000)) / 1000;
-    if (senddatavars & (1 << 26) && (counter % 5) == 0)
-      json["roll"] = roundf(((float)roll * 1000)) / 1000;
-    if (senddatavars & (1 << 27) && (counter % 5) == 0)
-      json["pan"] = roundf(((float)pan * 1000)) / 1000;
-    if (senddatavars & (1 << 28) && (counter % 1) == 0)
-      json["tiltoff"] = roundf(((float)tiltoff * 1000)) / 1000;
-    if (senddatavars & (1 << 29) && (counter % 1) == 0)
-      json["rolloff"] = roundf(((float)rolloff * 1000)) / 1000;
-    if (senddatavars & (1 << 30) && (counter % 1) == 0)
-      json["panoff"] = roundf(((float)panoff * 1000)) / 1000;
-    if (senddatavars & (1 << 31) && (counter % 10) == 0)
-      json["gyrocal"] = gyrocal;
-
-    sendArray(json,1,counter,1,"6choutu16",(void*)chout,(void*)lastchout, sizeof(uint16_t) * 16);
-    sendArray(json,2,counter,1,"6btchu16",(void*)btch,(void*)lastbtch, sizeof(uint16_t) * 8);
-    sendArray(json,3,counter,1,"6ppmchu16",(void*)ppmch,(void*)lastppmch, sizeof(uint16_t) * 16);
-    sendArray(json,4,counter,1,"6uartchu16",(void*)uartch,(void*)lastuartch, sizeof(uint16_t) * 16);
-    sendArray(json,5,counter,1,"6quatflt",(void*)quat,(void*)lastquat, sizeof(float) * 4);
-    sendArray(json,6,counter,10,"6btaddrchr",(void*)btaddr,(void*)lastbtaddr, sizeof(char) * 18);
-    sendArray(json,7,counter,10,"6btrmtchr",(void*)btrmt,(void*)lastbtrmt, sizeof(char) * 18);
-
-    // Used for reduced data divisor
-    counter++;
+    for (int item = 0; item < DATA_ITEM_COUNT; item++) {
+      if (datarate[item] != 0 && elapsed > 0) {
+        JsonArray rate = json[dataItemName(item)].to<JsonArray>();
+        rate.add(datarate[item]);
+        rate.add(roundf(datasent[item] * 10000.0f / elapsed) / 10);
+        rate.add(datadrops[item]);
+      }
+      datasent[item] = 0;
+      datadrops[item] = 0;
+    }
   }
 
+  // Settings generation, incremented on every setting change
+  uint32_t getGeneration() {return generation;}
+
+  // Identifies this boot, generations from another id can't be compared
+  uint32_t getGenerationId() {return generationid;}
+  void setGenerationId(uint32_t id) {generationid = id;}
+
   void stopAllData()
   {
-    senddatavars = 0;
-    senddataarray = 0;
+    memset(datarate, 0, sizeof(datarate));
   }
 
 protected:
-  // Bit map of data to send to GUI, max 64 items
-  uint64_t senddatavars;
-  uint64_t senddataarray;
+  // Requested rate of each data item (Hz), 0 = not sent
+  uint16_t datarate[DATA_ITEM_COUNT] = {};
+  uint32_t datadue[DATA_ITEM_COUNT] = {};
+  uint16_t datasent[DATA_ITEM_COUNT] = {};
+  uint16_t datadrops[DATA_ITEM_COUNT] = {};
+
+  // Count of unknown names passed to setDataItemSend
+  uint32_t unknowndataitems = 0;
+
+  // Generation each setting was last changed in, settings first then arrays
+  uint32_t generation = 0;
+  uint32_t generationid = 0;
+  uint32_t settinggen[86] = {};
 
   // Settings
   uint16_t rll_min = DEF_MIN_PWM; // Roll Minimum
@@ -1503,6 +2295,7 @@ protected:
   int8_t pwm1 = -1; // PWM 1 Channel
   int8_t pwm2 = -1; // PWM 2 Channel
   int8_t pwm3 = -1; // PWM 3 Channel
+  uint16_t pwmrate = 50; // PWM Refresh Rate (Hz)
   int8_t an0ch = -1; // Analog 0 Channel
   int8_t an1ch = -1; // Analog 1 Channel
   int8_t an2ch = -1; // Analog 2 Channel
@@ -1545,12 +2338,13 @@ protected:
   float rotx = 0; // Board Rotation X
   float roty = 0; // Board Rotation Y
   float rotz = 0; // Board Rotation Z
-  uint8_t uartmode = 0; // Uart Mode (0- Off, 1-SBUS, 2-CRSFIN, 3-CRSFOUT)
-  uint8_t crsftxrate = 140; // CRSF Transmit Frequncy
+  uint8_t uartmode = 0; // Uart Mode (0-Off, 1-SBUS, 2-CRSFIN, 3-CRSFOUT)
+  uint16_t crsftxrate = 140; // CRSF Transmit Frequncy
   uint8_t sbustxrate = 80; // SBUS Transmit Freqency
   bool sbininv = true; // SBUS Receieve Inverted
   bool sboutinv = true; // SBUS Transmit Inverted
   bool crsftxinv = false; // Invert CRSF output
+  uint8_t crsftxbaud = 0; // CRSF Output Baud Rate (0=400000 1=921600 2=1000000)
   bool ch5arm = false; // Set channel 5 to 2000us
   int8_t btmode = 0; // Bluetooth Mode (-1=Uninit, 0-Disable, 1-Head, 2-Receive, 3-Scanner, 4-Gamepad)
   bool rstonwave = false; // Reset on Proximity Sense
@@ -1565,9 +2359,10 @@ protected:
   uint16_t ppmframe = 22500; // PPM Frame Length (us)
   uint16_t ppmsync = 350; // PPM Sync Pulse Length (us)
   uint8_t ppmchcnt = 8; // PPM channels to output
+  uint16_t databudget = 12000; // GUI Data Bandwidth (bytes/s)
 
   // Setting Arrays
-  char btpairedaddress[19]; // Bluetooth Remote address to Pair With
+  char btpairedaddress[18]; // Bluetooth Remote address to Pair With
 
   // Real Time Data
   float magx = 0; // Raw Sensor Mag X(uT)
@@ -1601,6 +2396,9 @@ protected:
   float rolloff = 0; // Offset Roll in Degrees
   float panoff = 0; // Offset Pan in Degrees
   bool gyrocal = 0; // Gyro Has Been Calibrated
+  uint16_t uarttxrate = 0; // Uart Output Frame Rate (Hz)
+  uint16_t uarttxjit = 0; // Uart Output Frame Jitter (us)
+  uint16_t uarttxage = 0; // Uart Output Channel Age (us)
 
   // Real Time Data Arrays
   uint16_t chout[16]; // Channel Outputs
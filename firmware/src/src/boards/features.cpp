@@ -6,6 +6,8 @@
 void getBoardFeatures(JsonDocument &json)
 {
   JsonArray array = json["FEAT"].to<JsonArray>();
+  array.add("RAWSTREAM");  // Binary raw sensor stream for calibration
+  array.add("BOOTTIME");  // Boot timeline
   #if defined(HAS_LSM6DS3)
   array.add("IMU");
   #endif
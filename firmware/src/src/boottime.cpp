@@ -0,0 +1,83 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2021 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "boottime.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(boottime);
+
+// Boot timeline, the start and end of each init stage in us since power up
+//  Stages can run at the same time from different threads
+struct bootstage {
+  const char *name;
+  uint32_t start;
+  uint32_t end;
+};
+
+static struct bootstage stages[BOOT_MAX_STAGES];
+static int stagecount = 0;
+static uint32_t bootdone = 0;
+static struct k_spinlock stagelock;
+
+static uint32_t boot_us() { return (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks()); }
+
+// Records the start of a stage, returns the stage to pass to boot_stageEnd
+int boot_stageBegin(const char *name)
+{
+  int stage = -1;
+  k_spinlock_key_t key = k_spin_lock(&stagelock);
+  if (stagecount < BOOT_MAX_STAGES) {
+    stage = stagecount++;
+    stages[stage].name = name;
+    stages[stage].start = boot_us();
+    stages[stage].end = 0;
+  }
+  k_spin_unlock(&stagelock, key);
+  return stage;
+}
+
+void boot_stageEnd(int stage)
+{
+  if (stage < 0 || stage >= BOOT_MAX_STAGES) return;
+  stages[stage].end = boot_us();
+}
+
+// All init stages are finished, log the timeline
+void boot_complete()
+{
+  bootdone = boot_us();
+  for (int i = 0; i < stagecount; i++) {
+    LOG_INF("Boot %-10s %6ums - %6ums", stages[i].name, stages[i].start / 1000,
+            stages[i].end / 1000);
+  }
+  LOG_INF("Boot complete in %ums", bootdone / 1000);
+}
+
+// Timeline for the GUI, each stage is [name, start us, end us]
+void boot_setJSON(JsonDocument &json)
+{
+  JsonArray array = json["Stages"].to<JsonArray>();
+  for (int i = 0; i < stagecount; i++) {
+    JsonArray stage = array.add<JsonArray>();
+    stage.add(stages[i].name);
+    stage.add(stages[i].start);
+    stage.add(stages[i].end);
+  }
+  json["Done"] = bootdone;
+}
@@ -0,0 +1,117 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+/* N One Euro Filters at a fixed rate, same output as the C SF1eFilterDo() for each channel,
+ *  which is kept in firmware/test/reference to check against. Statically sized with the
+ *  state of every channel in its own array so a call runs one tight loop over all of them
+ *
+ * At a fixed rate the derivative alpha never changes and is worked out once in configure().
+ *  The signal alpha, 1 / (1 + tau / te), becomes k*c / (k*c + 1) with k = 2*pi*te cached,
+ *  leaving one division per channel
+ */
+
+template <int N>
+class SF1eFilterBank
+{
+  static_assert(N > 0 && N <= 32, "Channels must fit in the mask");
+
+ public:
+  static constexpr uint32_t ALL = N == 32 ? 0xFFFFFFFF : (1UL << N) - 1;
+
+  SF1eFilterBank() { reset(); }
+
+  void configure(float frequency, float minCutoff, float cutoffSlope, float derivativeCutoff)
+  {
+    _frequency = frequency;
+    _minCutoff = minCutoff;
+    _slope = cutoffSlope;
+    _k = 2.0f * 3.14159265359f / frequency;
+    _dAlpha = alpha(derivativeCutoff);
+    reset();
+  }
+
+  // Clears the channels in the mask, their next input becomes the starting value
+  void reset(uint32_t mask = ALL)
+  {
+    for (int i = 0; i < N; i++) {
+      if (!(mask & (1UL << i))) continue;
+      _xprev[i] = 0;
+      _hatx[i] = 0;
+      _hatdx[i] = 0;
+    }
+    _used &= ~mask;
+  }
+
+  // Filters x into y for the channels in the mask, the rest are untouched
+  void process(const float x[N], float y[N], uint32_t mask = ALL)
+  {
+    for (int i = 0; i < N; i++) {
+      if (!(mask & (1UL << i))) continue;
+      float xi = x[i];
+      if (!(_used & (1UL << i))) {
+        _xprev[i] = xi;
+        _hatx[i] = xi;
+        _hatdx[i] = 0;
+      }
+
+      // Derivative low pass at a fixed cutoff, then the signal at a speed dependent one
+      float dx = (xi - _xprev[i]) * _frequency;
+      float hatdx = _dAlpha * dx + (1.0f - _dAlpha) * _hatdx[i];
+      float kc = _k * (_minCutoff + _slope * fabsf(hatdx));
+      float a = kc / (kc + 1.0f);
+      float hatx = a * xi + (1.0f - a) * _hatx[i];
+
+      _xprev[i] = xi;
+      _hatdx[i] = hatdx;
+      _hatx[i] = hatx;
+      y[i] = hatx;
+    }
+    _used |= mask;
+  }
+
+  // Single channel
+  float process(int channel, float x)
+  {
+    float in[N];
+    float out[N];
+    in[channel] = x;
+    process(in, out, 1UL << channel);
+    return out[channel];
+  }
+
+ private:
+  float alpha(float cutoff) const
+  {
+    float kc = _k * cutoff;
+    return kc / (kc + 1.0f);
+  }
+
+  float _frequency = 1;
+  float _minCutoff = 1;
+  float _slope = 0;
+  float _k = 1;
+  float _dAlpha = 1;
+  uint32_t _used = 0;
+  float _xprev[N];
+  float _hatx[N];
+  float _hatdx[N];
+};
@@ -12,6 +12,7 @@
 #include "io.h"
 #include "joystick.h"
 #include "btjoystick.h"
+#include "boottime.h"
 
 #include "pmw.h"
 #include "sense.h"
@@ -29,29 +30,58 @@ K_SEM_DEFINE(saveToFlash_sem, 0, 1);
 // Wait for serial connection on the GUI port before starting.
 //#define WAITFOR_DTR
 
+// Sensor bring up waits on the sensor power reset and the I2C bus. It runs in its own
+//   thread beside the rest of the init
+K_THREAD_STACK_DEFINE(senseInitStack, SENSEINIT_STACK_SIZE);
+static struct k_thread senseInitThread;
+
+static void senseInit_Thread(void *, void *, void *)
+{
+  // Actual Calculations - sense.cpp
+  LOG_INF("Sense starting");
+  int stage = boot_stageBegin("Sense");
+  if(sense_Init()) {
+    LOG_ERR("Sense initialization failed");
+    setLEDFlag(LED_HARDFAULT);
+  }
+  boot_stageEnd(stage);
+}
+
 void start(void)
 {
   // Initalize IO
   LOG_INF("Starting IO");
+  int stage = boot_stageBegin("IO");
   io_init();
+  boot_stageEnd(stage);
 
   // Load settings from flash - trackersettings.cpp
   LOG_INF("Loading Settings");
+  stage = boot_stageBegin("Settings");
   trkset.loadFromEEPROM();
+  boot_stageEnd(stage);
+
+  // Everything else needs the settings, sensors can start now
+  k_thread_create(&senseInitThread, senseInitStack, K_THREAD_STACK_SIZEOF(senseInitStack),
+                  senseInit_Thread, NULL, NULL, NULL, SENSEINIT_THREAD_PRIO, K_FP_REGS, K_NO_WAIT);
 
   // Serial Setup, we have a CDC Device, enable USB
 #if defined(DT_N_INST_0_zephyr_cdc_acm_uart)
   LOG_INF("USB starting");
+  stage = boot_stageBegin("USB");
   int ret = usb_enable(NULL);
   if (ret != 0) {
     LOG_ERR("USB unable to start");
     setLEDFlag(LED_HARDFAULT);
   }
+  boot_stageEnd(stage);
 #endif
 
   // USB Joystick
   LOG_INF("Joystick starting");
+  stage = boot_stageBegin("Joystick");
   joystick_init();
+  boot_stageEnd(stage);
 
 // Pause code here until connected via serial
 #ifdef WAITFOR_DTR
@@ -70,24 +100,21 @@ void start(void)
 
   // Ininitialize GUI logging and GUI Serial
   LOG_INF("GUISerial starting");
+  stage = boot_stageBegin("GUISerial");
   if(serial_init()) {
     LOG_ERR("GUISerial initialization failed");
     setLEDFlag(LED_HARDFAULT);
   }
-
-  // Actual Calculations - sense.cpp
-  LOG_INF("Sense starting");
-  if(sense_Init()) {
-    LOG_ERR("Sense initialization failed");
-    setLEDFlag(LED_HARDFAULT);
-  }
+  boot_stageEnd(stage);
 
   // Start PPM Output
 #if defined(HAS_PPMOUT)
   LOG_INF("PPMOut starting");
+  stage = boot_stageBegin("PPMOut");
   if(PpmOut_init()) {
     LOG_WRN("PPMOut initialization failed");
   }
+  boot_stageEnd(stage);
 #else
   LOG_INF("PPMOut is not supported on this board");
 #endif
@@ -95,9 +122,11 @@ void start(void)
   // Start PPM Input
 #if defined(HAS_PPMIN)
   LOG_INF("PPMIn starting");
+  stage = boot_stageBegin("PPMIn");
   if(PpmIn_init()) {
     LOG_WRN("PPMIn initalization failed");
   }
+  boot_stageEnd(stage);
 #else
   LOG_INF("PPMIn is not supported on this board");
 #endif
@@ -105,7 +134,9 @@ void start(void)
   // Start External UART
 #if defined(HAS_AUXSERIAL)
   LOG_INF("AuxUART starting");
+  stage = boot_stageBegin("AuxUART");
   uart_init();
+  boot_stageEnd(stage);
 #else
   LOG_INF("AuxUART is not supported on this board");
 #endif
@@ -113,7 +144,9 @@ void start(void)
   // PWM Outputs - Fixed to A0-A3
 #if defined(HAS_PWMOUTPUTS)
   LOG_INF("PWM starting");
-  PWM_Init(PWM_FREQUENCY);
+  stage = boot_stageBegin("PWM");
+  PWM_Init(trkset.getPwmRate());
+  boot_stageEnd(stage);
 #else
   LOG_INF("PWM is not supported on this board");
 #endif
@@ -128,11 +161,16 @@ void start(void)
     trkset.setBtMode(BTPARAHEAD);
     setLEDFlag(LED_BTCONFIGURATOR);
   }
+  stage = boot_stageBegin("Bluetooth");
   bt_init();
+  boot_stageEnd(stage);
 #else
   LOG_INF("Bluetooth is not supported on this board");
 #endif
 
+  k_thread_join(&senseInitThread, K_FOREVER);
+  boot_complete();
+
   // Monitor if saving to EEPROM is required
   while (1) {
     if (!k_sem_take(&saveToFlash_sem, K_FOREVER)) {
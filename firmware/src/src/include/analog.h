@@ -8,8 +8,18 @@
 extern "C" {
 #endif
 
-float analogRead(int channel);
 #define BAD_ANALOG_READ -123
+#define ANALOG_CHANNELS 8
+
+// Voltages of the channels in a scan, all taken in one ADC sequence
+typedef struct {
+  float volts[ANALOG_CHANNELS];  // By channel number, BAD_ANALOG_READ if not scanned
+  uint32_t channels;             // Mask of the channels read
+  int64_t timestamp;             // (us) Uptime the scan finished
+} analog_snapshot_t;
+
+int analogScan(uint32_t channels, analog_snapshot_t *snap);
+float analogRead(int channel);
 
 #ifdef __cplusplus
 }
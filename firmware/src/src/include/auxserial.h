@@ -18,6 +18,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <zephyr/kernel.h>
 
 #define SERIAL_TX_SIZE 512
 #define SERIAL_RX_SIZE 512
@@ -60,4 +61,5 @@ int AuxSerial_Open(uint32_t baudrate, uint16_t settings, uint8_t inversions = 0)
 bool AuxSerial_Available();
 void AuxSerial_Close();
 uint32_t AuxSerial_Write(const uint8_t* buffer, uint32_t len);
-uint32_t AuxSerial_Read(uint8_t* buffer, uint32_t bufsize);
\ No newline at end of file
+uint32_t AuxSerial_Read(uint8_t* buffer, uint32_t bufsize);
+bool AuxSerial_WaitRx(k_timeout_t timeout);
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "arduinojsonwrp.h"
+
+#define BOOT_MAX_STAGES 16
+
+int boot_stageBegin(const char *name);
+void boot_stageEnd(int stage);
+void boot_complete();
+void boot_setJSON(JsonDocument &json);
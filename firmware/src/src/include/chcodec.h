@@ -0,0 +1,100 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/* 16 channels of 11 bits, packed LSB first into 22 bytes. The payload layout shared by
+ *  SBUS and CRSF RC_CHANNELS_PACKED
+ */
+
+namespace ChCodec {
+
+static constexpr int CHANNELS = 16;
+static constexpr int PACKED_LEN = 22;
+static constexpr uint16_t CHANNEL_MASK = 0x07FF;
+
+// Little endian load of the bytes needed for a channel, a word at once when it can't read
+// past the end of the packed data
+static inline uint32_t loadBits(const uint8_t *packed, int offset)
+{
+  uint32_t word;
+  if (offset + 4 <= PACKED_LEN) {
+    memcpy(&word, packed + offset, sizeof(word));
+  } else {
+    word = packed[offset];
+    for (int i = 1; offset + i < PACKED_LEN; i++) word |= (uint32_t)packed[offset + i] << (i * 8);
+  }
+  return word;
+}
+
+static inline void unpack(const uint8_t *packed, uint16_t ch[CHANNELS])
+{
+  for (int i = 0; i < CHANNELS; i++) {
+    int bit = i * 11;
+    ch[i] = (loadBits(packed, bit >> 3) >> (bit & 7)) & CHANNEL_MASK;
+  }
+}
+
+// Channels are gathered 32 bits at a time and stored a word at once
+static inline void pack(const uint16_t ch[CHANNELS], uint8_t *packed)
+{
+  uint64_t bits = 0;
+  int bitcount = 0;
+  int offset = 0;
+  for (int i = 0; i < CHANNELS; i++) {
+    bits |= (uint64_t)(ch[i] & CHANNEL_MASK) << bitcount;
+    bitcount += 11;
+    if (bitcount >= 32) {
+      uint32_t word = (uint32_t)bits;
+      memcpy(packed + offset, &word, sizeof(word));
+      offset += 4;
+      bits >>= 32;
+      bitcount -= 32;
+    }
+  }
+  // 176 bits, two bytes left
+  packed[offset++] = bits;
+  packed[offset] = bits >> 8;
+}
+
+/* Linear scaling between channel ranges with compile time constants
+ *   out = floor((in - IN_CENTER) * NUM / DEN) + OUT_CENTER, limited to LO..HI
+ */
+template <int32_t IN_CENTER, int32_t OUT_CENTER, int32_t NUM, int32_t DEN, int32_t LO,
+          int32_t HI>
+struct Scale {
+  static_assert(DEN > 0, "Denominator must be positive");
+  static constexpr uint16_t map(int32_t in)
+  {
+    int32_t n = (in - IN_CENTER) * NUM;
+    int32_t out = (n >= 0 ? n / DEN : -((DEN - 1 - n) / DEN)) + OUT_CENTER;
+    return out < LO ? LO : (out > HI ? HI : out);
+  }
+};
+
+// SBUS 992 center, 1.6 counts per us (TrackerSettings::SBUS_SCALE)
+using SbusToUs = Scale<992, 1500, 5, 8, 988, 2012>;
+using UsToSbus = Scale<1500, 992, 8, 5, 0, CHANNEL_MASK>;
+
+// CRSF 191-1792 is 1000-2000us in, 988-2012us is 172-1811 out
+using CrsfToUs = Scale<191, 1000, 1000, 1601, 0, UINT16_MAX>;
+using UsToCrsf = Scale<988, 172, 1639, 1024, 0, CHANNEL_MASK>;
+
+}  // namespace ChCodec
@@ -57,13 +57,14 @@
 // Thread Periods
 #define IO_PERIOD 25           // (ms) IO Period (button reading)
 #define BT_PERIOD 12500        // (us) Bluetooth update rate
-#define SERIAL_PERIOD 30       // (ms) Serial processing
-#define DATA_PERIOD 2          // Multiplier of Serial Period (Live Data Transmission Speed)
+#define SERIAL_PERIOD 10       // (ms) Serial processing, also the fastest live data rate
+#define DATA_RATE_PERIOD 1000  // (ms) How often achieved data item rates are sent to the GUI
+#define SERIAL_RX_WINDOW 4     // Frames the GUI sends before waiting for an ack (TX_WINDOW)
 #define SENSOR_PERIOD 6666     // (us) Sensor Reads 150Hz
 #define CALCULATE_PERIOD 7000  // (us) Channel Calculations
-#define UART_PERIOD 4000       // (us) Update rate of UART
-#define PWM_FREQUENCY 50       // (ms) PWM Period
-#define PAUSE_BEFORE_FLASH 30  // (ms) Time to pause all threads before Flash writing
+#define UART_PERIOD 4000       // (us) Longest wait for UART RX data
+#define SENSOR_RESET_TIME 200  // (ms) Sensor power is off at startup to hard reset it
+#define FLASH_CHUNK_PAUSE 1    // (ms) Sleep between flash erases/writes so outputs keep updating
 
 // Thread Stack Sizes
 #if defined(CONFIG_SOC_SERIES_NRF52X)
@@ -74,6 +75,7 @@
 #define CALCULATE_STACK_SIZE 1024
 #define UARTTX_STACK_SIZE 1024
 #define UARTRX_STACK_SIZE 512
+#define SENSEINIT_STACK_SIZE 2048
 #else
 #define IO_STACK_SIZE 512
 #define SERIAL_STACK_SIZE 4096
@@ -82,6 +84,7 @@
 #define CALCULATE_STACK_SIZE 2048
 #define UARTTX_STACK_SIZE 1024
 #define UARTRX_STACK_SIZE 512
+#define SENSEINIT_STACK_SIZE 2048
 #endif
 
 // Analog Filters 1 Euro Filter
@@ -115,12 +118,13 @@
 #define CALCULATE_THREAD_PRIO PRIORITY_HIGH + 2
 #define UARTRX_THREAD_PRIO PRIORITY_LOW - 2
 #define UARTTX_THREAD_PRIO PRIORITY_HIGH
+#define SENSEINIT_THREAD_PRIO PRIORITY_MED
 
 // Perepherial Channels Used, Make sure no dupilcates here
 // and can't be used by Zephyr
 // Cannot use GPIOTE interrupt as I override the interrupt handler in PPMIN
 
-#define PPMOUT_PPICH 0
+#define SERIALIN_RX_PPICH 0
 #define SERIALIN1_PPICH 1
 #define SERIALIN2_PPICH 2
 #define SERIALOUT_PPICH 3
@@ -140,19 +144,26 @@
 #define SERIALIN1_GPIOTE 1
 #define SERIALIN2_GPIOTE 2
 #define PPMIN_GPIOTE 6
-#define PPMOUT_GPIOTE 7
 
-#define SBUSIN_TIMER_CH 2
-#define PPMOUT_TIMER_CH 3
+#define SERIALIN_IDLE_TIMER_CH 2
+#define SERIALIN_COUNT_TIMER_CH 3
 #define PPMIN_TIMER_CH 4
 
 #define PPMIN_TMRCOMP_CH 0
-#define PPMOUT_TMRCOMP_CH 0
+
+// PWM, 0 is used for the PWM outputs
+#define PPMOUT_PWM_CH 1
 
 // Buffer Sizes for Serial/JSON
 #define JSON_BUF_SIZE 3000
 #define TX_RNGBUF_SIZE 2000
 #define RX_RNGBUF_SIZE 1500
+#define DATA_FRAME_OVERHEAD 24  // Bytes of a live data frame not counted in the data budget
+#define SETTINGS_BLOCK_SIZE 64   // Bytes of the settings image in each flash record
+#define SETTINGS_IMAGE_MAX 1024  // Largest saved settings image that can be migrated
+#define SETTINGS_FIELDS_MAX 256  // Most fields of a saved settings image that can be migrated
+#define RAW_STREAM_QUEUE 32     // Raw sensor samples held for the serial thread, ~200ms at 150Hz
+#define RAW_STREAM_FRAME 8      // Most raw sensor samples sent in one frame
 
 // Math Defines
 #define DEG_TO_RAD 0.017453295199f
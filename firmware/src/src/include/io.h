@@ -10,6 +10,7 @@ extern void pressButton();
 extern void longPressButton();
 extern void io_Thread();
 extern void io_init();
+extern void io_sensorPowerOn();
 
 extern volatile bool buttonpressed;
 
@@ -27,4 +27,6 @@
 #include <stdint.h>
 
 int PWM_Init(int updateRate);
+void PWM_SetRate(int updateRate);
+void setPWMValues(const uint16_t values[4], uint8_t mask);
 void setPWMValue(int ch, uint16_t value);
@@ -1,131 +1,140 @@
 /*
-  A simple ring buffer implementation as C++ template.
-
-  Copyright (c) 2011 Hannes Flicka
-  Licensed under the terms of the MIT license (given below).
-
-  Permission is hereby granted, free of charge, to any person obtaining a copy
-  of this software and associated documentation files (the "Software"), to deal
-  in the Software without restriction, including without limitation the rights
-  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-  copies of the Software, and to permit persons to whom the Software is
-  furnished to do so, subject to the following conditions:
-
-  The above copyright notice and this permission notice shall be included in
-  all copies or substantial portions of the Software.
-
-  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
-  THE SOFTWARE.
-*/
-
-#ifndef RINGBUFFER_H
-#define RINGBUFFER_H
-
-#include <memory.h>
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
 #include <algorithm>
-
-template <typename T>
+#include <atomic>
+
+/* Single producer, single consumer ring of N elements, N a power of two. Statically sized,
+ *  no locks, safe with the producer in an ISR and the consumer in a thread or the other way
+ *  around. Only the producer moves head and only the consumer moves tail. Both count up
+ *  freely and are masked on access, so a full ring holds all N elements
+ *
+ * claim()/commit() and peek()/consume() give contiguous spans of the storage so DMA or a
+ *  parser can work in place. A span stops at the end of the storage, the rest is in a second
+ *  span from the start
+ */
+
+template <typename T, size_t N>
 class ringbuffer
 {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "Ring size must be a power of two");
+
  public:
-  /**
-   * create a ringbuffer with space for up to size elements.
-   */
-  explicit ringbuffer(size_t size) : size(size), begin(0), end(0), wrap(false)
-  {
-    buffer = new T[size];
-  }
+  static constexpr size_t capacity() { return N; }
 
-  /**
-   * copy constructor
-   */
-  ringbuffer(const ringbuffer<T>& rb)
+  size_t getOccupied() const
   {
-    this(rb.size);
-    begin = rb.begin;
-    end = rb.end;
-    memcpy(buffer, rb.buffer, sizeof(T) * size);
+    uint32_t tail = _tail.load(std::memory_order_acquire);
+    return _head.load(std::memory_order_acquire) - tail;
   }
 
-  /**
-   * destructor
-   */
-  ~ringbuffer() { delete[] buffer; }
-
-  size_t write(const T* data, size_t n)
-  {
-    n = std::min(n, getFree());
+  size_t getFree() const { return N - getOccupied(); }
 
-    if (n == 0) {
-      return n;
-    }
+  // Producer
 
-    const size_t first_chunk = std::min(n, size - end);
-    memcpy(buffer + end, data, first_chunk * sizeof(T));
-    end = (end + first_chunk) % size;
+  // Free space at the head, fill up to the returned count then commit() it
+  size_t claim(T *&span)
+  {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    size_t free = N - (head - _tail.load(std::memory_order_acquire));
+    size_t offset = head & MASK;
+    span = _buffer + offset;
+    return std::min(free, N - offset);
+  }
 
-    if (first_chunk < n) {
-      const size_t second_chunk = n - first_chunk;
-      memcpy(buffer + end, data + first_chunk, second_chunk * sizeof(T));
-      end = (end + second_chunk) % size;
-    }
+  // Publishes n claimed elements to the consumer
+  void commit(size_t n)
+  {
+    _head.store(_head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+  }
 
-    if (begin == end) {
-      wrap = true;
+  size_t write(const T *data, size_t n)
+  {
+    size_t written = 0;
+    T *span;
+    size_t len;
+    while (written < n && (len = claim(span)) > 0) {
+      len = std::min(len, n - written);
+      memcpy(span, data + written, len * sizeof(T));
+      commit(len);
+      written += len;
     }
-
-    return n;
+    return written;
   }
 
-  size_t read(T* dest, size_t n)
+  bool push(const T &value)
   {
-    n = std::min(n, getOccupied());
-
-    if (n == 0) {
-      return n;
-    }
+    T *span;
+    if (claim(span) == 0) return false;
+    *span = value;
+    commit(1);
+    return true;
+  }
 
-    if (wrap) {
-      wrap = false;
-    }
+  // Consumer
 
-    const size_t first_chunk = std::min(n, size - begin);
-    memcpy(dest, buffer + begin, first_chunk * sizeof(T));
-    begin = (begin + first_chunk) % size;
+  // Oldest elements, use up to the returned count then consume() them
+  size_t peek(T *&span)
+  {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    size_t occupied = _head.load(std::memory_order_acquire) - tail;
+    size_t offset = tail & MASK;
+    span = _buffer + offset;
+    return std::min(occupied, N - offset);
+  }
 
-    if (first_chunk < n) {
-      const size_t second_chunk = n - first_chunk;
-      memcpy(dest + first_chunk, buffer + begin, second_chunk * sizeof(T));
-      begin = (begin + second_chunk) % size;
-    }
-    return n;
+  // Returns n peeked elements to the producer
+  void consume(size_t n)
+  {
+    _tail.store(_tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
   }
 
-  size_t getOccupied()
+  size_t read(T *dest, size_t n)
   {
-    if (end == begin) {
-      return wrap ? size : 0;
-    } else if (end > begin) {
-      return end - begin;
-    } else {
-      return size + end - begin;
+    size_t readlen = 0;
+    T *span;
+    size_t len;
+    while (readlen < n && (len = peek(span)) > 0) {
+      len = std::min(len, n - readlen);
+      memcpy(dest + readlen, span, len * sizeof(T));
+      consume(len);
+      readlen += len;
     }
+    return readlen;
   }
 
-  size_t getFree() { return size - getOccupied(); }
+  bool pop(T &value)
+  {
+    T *span;
+    if (peek(span) == 0) return false;
+    value = *span;
+    consume(1);
+    return true;
+  }
 
  private:
-  T* buffer;
-  size_t size;
-  size_t begin;
-  size_t end;
-  bool wrap;
+  static constexpr uint32_t MASK = N - 1;
+  T _buffer[N];
+  std::atomic<uint32_t> _head{0};
+  std::atomic<uint32_t> _tail{0};
 };
-
-#endif  // RINGBUFFER_H
\ No newline at end of file
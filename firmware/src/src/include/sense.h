@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+
 #define APDS_HYSTERISIS 10
 
 // Oversample Setting
@@ -9,6 +11,19 @@ const int SENSEUPDATE = 1;
 const int SENSEUPDATE = 6;
 #endif
 
+// Raw sensor sample, streamed to the GUI in binary for calibration
+#define RAW_ACC_VALID 0x01
+#define RAW_MAG_VALID 0x02
+#define RAW_GYR_VALID 0x04
+
+typedef struct __attribute__((packed)) {
+  uint16_t seq;  // Increments on every sensor read, gaps are dropped samples
+  uint8_t valid;
+  float acc[3];
+  float mag[3];
+  float gyr[3];
+} rawsample_t;
+
 int sense_Init();
 void sensor_Thread();
 void calculate_Thread();
@@ -16,3 +31,8 @@ float normalize(const float value, const float start, const float end);
 void rotate(float pn[3], const float rot[3]);
 void reset_fusion();
 void buildAuxData();
+void sense_startOutputGap();
+uint32_t sense_stopOutputGap();
+void sense_setRawStream(bool enabled);
+bool sense_getRawStream();
+int sense_getRawSamples(rawsample_t *samples, int max);
@@ -2,10 +2,12 @@
 
 #include <stdint.h>
 
-extern struct k_sem flashWriteSemaphore;
-
-int socReadFlash(char *dataout, int len);
-int socWriteFlash(const uint8_t *data, int len);
+int socReadFlash(uint32_t offset, void *data, int len);
 void socClearFlash();
-const uint8_t *socGetMMFlashPtr();
+bool socHasLegacyBlob();
+bool socHasRecords();
+int socFormatRecords();
+int socReadRecord(uint16_t id, void *data, int len);
+int socWriteRecord(uint16_t id, const void *data, int len);
+int socDeleteRecord(uint16_t id);
 
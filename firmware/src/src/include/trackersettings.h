@@ -57,6 +57,9 @@ class TrackerSettings : public BaseTrackerSettings
   bool getSettingsModfied() {return settingsModified;}
 
  private:
+  void migrateImage(int size, int fieldcount);
+  bool loadLegacyJSON();
+
   bool freshProgram;
   bool settingsModified;
 };
@@ -14,4 +14,6 @@ void UartSetMode(uartmodet mode);
 uartmodet UartGetMode();
 
 bool UartGetChannels(uint16_t channels[16]);
-void UartSetChannels(uint16_t channels[16]);
\ No newline at end of file
+void UartSetChannels(uint16_t channels[16]);
+void UartSetTelemetry(const float quat[4], float battery);
+void UartGetTxStats(uint16_t &rate, uint16_t &jitter, uint16_t &age);
\ No newline at end of file
@@ -58,6 +58,29 @@ rgb_s led_sequence[LED_MAX_SEQUENCE_COUNT];
 #define CENTERBTN_NODE	DT_ALIAS(centerbtn)
 static const struct gpio_dt_spec cbutton = GPIO_DT_SPEC_GET_OR(CENTERBTN_NODE, gpios, {0});
 
+// Sensor power is cut at startup to hard reset it
+static int64_t sensorPowerOffTime = 0;
+
+#if defined(HAS_BUZZER)
+static uint32_t beepStartTime = 0;
+#endif
+
+// Turns the sensor power back on once it has been off long enough. Called from the sensor
+//   init so the wait doesn't hold up the rest of boot
+void io_sensorPowerOn()
+{
+#if defined(CONFIG_BOARD_ARDUINO_NANO_33_BLE) || defined(CONFIG_BOARD_XIAO_BLE_NRF52840_SENSE)
+  int64_t remaining = SENSOR_RESET_TIME - (k_uptime_get() - sensorPowerOffTime);
+  if (remaining > 0) k_msleep(remaining);
+#endif
+#if defined(CONFIG_BOARD_ARDUINO_NANO_33_BLE)
+  digitalWrite(IO_VDDENA, 1);
+#endif
+#if defined(CONFIG_BOARD_XIAO_BLE_NRF52840_SENSE)
+  digitalWrite(IO_LSM6DS3PWR, 1);
+#endif
+}
+
 void io_init()
 {
   gpios[0] = DEVICE_DT_GET(DT_NODELABEL(gpio0));
@@ -71,19 +94,17 @@ void io_init()
   setPinHighDrive(IO_VDDENA);
   setPinHighDrive(IO_I2C_PU);
   digitalWrite(IO_I2C_PU, 1);
-  // Hard Reset Sensor
+  // Hard Reset Sensor, powered back on by io_sensorPowerOn()
   digitalWrite(IO_VDDENA, 0);
-  k_msleep(200);
-  digitalWrite(IO_VDDENA, 1);
+  sensorPowerOffTime = k_uptime_get();
 #endif
 
 #if defined(CONFIG_BOARD_XIAO_BLE_NRF52840_SENSE)
   pinMode(IO_LSM6DS3PWR, GPIO_OUTPUT);
   setPinHighDrive(IO_LSM6DS3PWR);
-  // Hard Reset Sensor
+  // Hard Reset Sensor, powered back on by io_sensorPowerOn()
   digitalWrite(IO_LSM6DS3PWR, 0);
-  k_msleep(200);
-  digitalWrite(IO_LSM6DS3PWR, 1);
+  sensorPowerOffTime = k_uptime_get();
 #endif
 
 #if defined(CONFIG_BOARD_XIAO_BLE)
@@ -114,14 +135,9 @@ void io_init()
 
 #if defined(HAS_BUZZER)
   pinMode(IO_BUZZ, GPIO_OUTPUT);
-  // Startup beep, beep
-  digitalWrite(IO_BUZZ, 1);
-  k_busy_wait(100000);
-  digitalWrite(IO_BUZZ, 0);
-  k_busy_wait(100000);
+  // Startup beep, beep. Turned off and on again by io_Thread
   digitalWrite(IO_BUZZ, 1);
-  k_busy_wait(100000);
-  digitalWrite(IO_BUZZ, 0);
+  beepStartTime = k_uptime_get_32();
 #endif
 
 #if defined(HAS_3DIODE_RGB)
@@ -210,7 +226,14 @@ void io_Thread()
     k_msleep(IO_PERIOD);
     k_poll(ioRunEvents, 1, K_FOREVER);
 
-    if (k_sem_count_get(&flashWriteSemaphore) == 1) continue;
+#if defined(HAS_BUZZER)
+    // Startup beep, beep. On 100ms, off 100ms, on 100ms
+    if (beepStartTime != 0) {
+      uint32_t beeptime = k_uptime_get_32() - beepStartTime;
+      digitalWrite(IO_BUZZ, beeptime < 100 || (beeptime >= 200 && beeptime < 300));
+      if (beeptime >= 300) beepStartTime = 0;
+    }
+#endif
 
 #if defined(HAS_NOTIFYLED)
     // LEDS
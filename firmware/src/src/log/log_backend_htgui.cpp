@@ -5,6 +5,7 @@
 #include <zephyr/logging/log_output.h>
 #include <zephyr/logging/log_backend_std.h>
 #include <zephyr/logging/log_core.h>
+#include <zephyr/logging/log_output_dict.h>
 #include <serial.h>
 #include "ucrc16lib.h"
 
@@ -74,6 +75,8 @@ static void preprint_char(int c)
 
 static uint8_t buf[_STDOUT_BUF_SIZE];
 
+void dropped(const struct log_backend *const backend, uint32_t cnt);
+
 static int char_out(uint8_t *data, size_t length, void *ctx)
 {
 	for (size_t i = 0; i < length; i++) {
@@ -85,10 +88,70 @@ static int char_out(uint8_t *data, size_t length, void *ctx)
 
 LOG_OUTPUT_DEFINE(log_output_htgui, char_out, buf, sizeof(buf));
 
+#if defined(CONFIG_LOG_DICTIONARY_SUPPORT)
+// Dictionary log messages are binary, one message per frame. Starts with 0x10 (data link
+// escape), ends with 0x03. Any byte the GUI uses for framing is escaped out with 0x1B
+
+#define LOG_DICT_START 0x10
+
+static char dictbuf[_JSONOUT_BUF_SIZE];
+static uint32_t dictlen = 0;
+static bool dictoverflow = false;
+
+static int dict_out(uint8_t *data, size_t length, void *ctx)
+{
+  for (size_t i = 0; i < length; i++) {
+    uint8_t c = data[i];
+    bool escape = c == 0x01 || c == 0x02 || c == 0x03 || c == 0x06 || c == LOG_DICT_START ||
+                  c == 0x15 || c == 0x1B || c == '\r' || c == '\n';
+    if (dictlen + 2 > sizeof(dictbuf) - 3) {
+      dictoverflow = true;
+      break;
+    }
+    if (escape) {
+      dictbuf[dictlen++] = 0x1B;
+      c ^= 0xFF;
+    }
+    dictbuf[dictlen++] = c;
+  }
+
+  return length;
+}
+
+static uint8_t dictoutbuf[_STDOUT_BUF_SIZE];
+LOG_OUTPUT_DEFINE(log_output_htgui_dict, dict_out, dictoutbuf, sizeof(dictoutbuf));
+
+static void process_dict(union log_msg_generic *msg, uint32_t flags)
+{
+  dictbuf[0] = LOG_DICT_START;
+  dictlen = 1;
+  dictoverflow = false;
+
+  log_dict_output_msg_process(&log_output_htgui_dict, &msg->log, flags);
+  log_output_flush(&log_output_htgui_dict);
+
+  if (dictoverflow) {
+    dropped(NULL, 1);
+    return;
+  }
+  dictbuf[dictlen++] = 0x03; // End of Text
+  dictbuf[dictlen++] = '\r';
+  dictbuf[dictlen++] = '\n';
+  serialWrite(dictbuf, dictlen);
+}
+#endif
+
 void process(const struct log_backend *const backend, union log_msg_generic *msg)
 {
 	uint32_t flags = log_backend_std_get_flags();
 
+#if defined(CONFIG_LOG_DICTIONARY_SUPPORT)
+  if (log_format_current == LOG_OUTPUT_DICT) {
+    process_dict(msg, flags);
+    return;
+  }
+#endif
+
 	log_format_func_t log_output_func = log_format_func_t_get(log_format_current);
 
 	log_output_func(&log_output_htgui, &msg->log, flags);
@@ -15,29 +15,85 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
-/* 4 Channels of PWM output, limited to 200Hz - 31Hz Update Rates
+/* 4 Channels of PWM output, limited to 400Hz - 31Hz Update Rates
  *  31 Comes from coounter top max value = 32767us
  *   1/32768 = 30.5Hz
+ *
+ * Two sequences of one period each play back to back. When one starts the ISR copies the newest
+ *  set of values into the other, so all four channels change together on a period boundary
  *    */
 
 #include "pmw.h"
+
+#include <string.h>
+#include <zephyr/kernel.h>
+
 #include "trackersettings.h"
 
 
 #if defined(CONFIG_SOC_SERIES_NRF52X)
 
-static uint16_t pwmvals[4];
-static constexpr uint16_t countertop = 5000;  // 5000uS per period, before end delay
-static uint16_t usperiod = 5000;
+#define PWM_CHANNELS 4
+
+/* Latest values, handed from setPWMValues to the ISR. The writer fills the slot that isn't
+ *  published then flips pwmSlotReady. The ISR preempts the writer so it always copies a
+ *  complete set, never one being built
+ */
+static uint16_t pwmSlots[2][PWM_CHANNELS];
+static volatile uint8_t pwmSlotReady = 0;
+static volatile uint32_t pwmversion = 0;
+static uint16_t seqvals[2][PWM_CHANNELS];  // Sequences being played
+static uint32_t seqversion[2] = {0, 0};
+static bool pwmstarted = false;
+static uint16_t usperiod = 20000;
+static int pwmrate = 50;
+
+// Sequence started, queue the latest values into the other one
+void PWM_isr(const void *)
+{
+  for (int seq = 0; seq < 2; seq++) {
+    if (NRF_PWM0->EVENTS_SEQSTARTED[seq] == 1) {
+      NRF_PWM0->EVENTS_SEQSTARTED[seq] = 0;
+      int next = !seq;
+      uint32_t version = pwmversion;
+      if (seqversion[next] != version) {
+        memcpy(seqvals[next], pwmSlots[pwmSlotReady], sizeof(seqvals[next]));
+        seqversion[next] = version;
+      }
+    }
+  }
+}
 
 int PWM_Init(int updateRate)
 {
-  if (updateRate > 200 || updateRate < 31) return -1;
+  if (updateRate > 400 || updateRate < 31) return -1;
+
+  irq_disable(PWM0_IRQn);
+  NRF_PWM0->INTENCLR = PWM_INTENCLR_SEQSTARTED0_Msk | PWM_INTENCLR_SEQSTARTED1_Msk;
+
+  // Stop first if changing rates. It takes effect at the end of the current period, wait for it
+  //  so the sequences and counter top aren't changed under a pulse being played
+  if (pwmstarted) {
+    NRF_PWM0->SHORTS = 0;
+    NRF_PWM0->EVENTS_STOPPED = 0;
+    NRF_PWM0->TASKS_STOP = 1;
+    for (int i = 0; i < usperiod / 10 + 10 && !NRF_PWM0->EVENTS_STOPPED; i++) k_busy_wait(10);
+    NRF_PWM0->EVENTS_STOPPED = 0;
+  }
 
-  usperiod = (1 / (float)updateRate * 1000000);
+  uint32_t key = irq_lock();
 
-  for (int i = 0; i < 4; i++) {
-    pwmvals[i] = usperiod - TrackerSettings::PPM_CENTER;
+  // Keep the pulse widths when changing rates
+  uint16_t oldperiod = usperiod;
+  pwmrate = updateRate;
+  usperiod = (1 / (float)updateRate * 1000000);
+  for (int slot = 0; slot < 2; slot++) {
+    for (int i = 0; i < PWM_CHANNELS; i++) {
+      if (pwmstarted)
+        pwmSlots[slot][i] = usperiod - (oldperiod - pwmSlots[slot][i]);
+      else
+        pwmSlots[slot][i] = usperiod - TrackerSettings::PPM_CENTER;
+    }
   }
 
   NRF_PWM0->PSEL.OUT[0] =
@@ -53,38 +109,79 @@ int PWM_Init(int updateRate)
   NRF_PWM0->MODE = (PWM_MODE_UPDOWN_Up << PWM_MODE_UPDOWN_Pos);
   NRF_PWM0->PRESCALER =
       (PWM_PRESCALER_PRESCALER_DIV_16 << PWM_PRESCALER_PRESCALER_Pos);  // 1Mhz 1uS Resolution
-  NRF_PWM0->COUNTERTOP = (usperiod << PWM_COUNTERTOP_COUNTERTOP_Pos);   // 1 msec
-  NRF_PWM0->LOOP = 0;
+  NRF_PWM0->COUNTERTOP = (usperiod << PWM_COUNTERTOP_COUNTERTOP_Pos);
   NRF_PWM0->DECODER = (PWM_DECODER_LOAD_Individual << PWM_DECODER_LOAD_Pos) |
                       (PWM_DECODER_MODE_RefreshCount << PWM_DECODER_MODE_Pos);
-  NRF_PWM0->SEQ[0].PTR = ((uint32_t)(pwmvals) << PWM_SEQ_PTR_PTR_Pos);
-  NRF_PWM0->SEQ[0].CNT = ((sizeof(pwmvals) / sizeof(uint16_t)) << PWM_SEQ_CNT_CNT_Pos);
-  NRF_PWM0->SEQ[0].REFRESH = 1;
-  NRF_PWM0->SEQ[0].ENDDELAY = 0;
+
+  // Both sequences start with the current values, one period each
+  for (int seq = 0; seq < 2; seq++) {
+    memcpy(seqvals[seq], pwmSlots[pwmSlotReady], sizeof(seqvals[seq]));
+    NRF_PWM0->SEQ[seq].PTR = ((uint32_t)(seqvals[seq]) << PWM_SEQ_PTR_PTR_Pos);
+    NRF_PWM0->SEQ[seq].CNT = (PWM_CHANNELS << PWM_SEQ_CNT_CNT_Pos);
+    NRF_PWM0->SEQ[seq].REFRESH = 0;
+    NRF_PWM0->SEQ[seq].ENDDELAY = 0;
+    NRF_PWM0->EVENTS_SEQSTARTED[seq] = 0;
+    seqversion[seq] = pwmversion;
+  }
+
+  // Play sequence 0 then 1, forever
+  NRF_PWM0->LOOP = 1 << PWM_LOOP_CNT_Pos;
+  NRF_PWM0->SHORTS = PWM_SHORTS_LOOPSDONE_SEQSTART0_Msk;
+
+  IRQ_CONNECT(PWM0_IRQn, 2, PWM_isr, NULL, 0);
+  NRF_PWM0->INTENSET = PWM_INTENSET_SEQSTARTED0_Msk | PWM_INTENSET_SEQSTARTED1_Msk;
+  irq_enable(PWM0_IRQn);
 
   NRF_PWM0->TASKS_SEQSTART[0] = 1;
+  pwmstarted = true;
+
+  irq_unlock(key);
   return 0;
 }
 
-void setPWMValue(int ch, uint16_t value)
+// Changes the refresh rate if it's running and different
+void PWM_SetRate(int updateRate)
 {
-  if (ch < 0 || ch > 3) return;
+  if (pwmstarted && updateRate != pwmrate) PWM_Init(updateRate);
+}
 
-  // Set PPM Channel, Limited to min/max
-  pwmvals[ch] = usperiod - MAX(MIN(value, TrackerSettings::MAX_PWM), TrackerSettings::MIN_PWM);
+// Sets the channels in the mask, all of them go out together on the next period
+void setPWMValues(const uint16_t values[PWM_CHANNELS], uint8_t mask)
+{
+  uint8_t idx = !pwmSlotReady;
+  memcpy(pwmSlots[idx], pwmSlots[pwmSlotReady], sizeof(pwmSlots[idx]));
+  for (int ch = 0; ch < PWM_CHANNELS; ch++) {
+    if (!(mask & BIT(ch))) continue;
+    // Limited to min/max
+    pwmSlots[idx][ch] =
+        usperiod - MAX(MIN(values[ch], TrackerSettings::MAX_PWM), TrackerSettings::MIN_PWM);
+  }
+  compiler_barrier();
+  pwmSlotReady = idx;
+  pwmversion++;
+}
 
-  NRF_PWM0->TASKS_SEQSTART[0] = 1;
+void setPWMValue(int ch, uint16_t value)
+{
+  if (ch < 0 || ch >= PWM_CHANNELS) return;
+  uint16_t values[PWM_CHANNELS];
+  values[ch] = value;
+  setPWMValues(values, BIT(ch));
 }
 
 
 #elif defined(CONFIG_SOC_ESP32C3)
 
 int PWM_Init(int updateRate) {return 0;}
+void PWM_SetRate(int updateRate) {}
+void setPWMValues(const uint16_t values[4], uint8_t mask) {}
 void setPWMValue(int ch, uint16_t value) {}
 
 #else
 
 int PWM_Init(int updateRate) {return 0;}
+void PWM_SetRate(int updateRate) {}
+void setPWMValues(const uint16_t values[4], uint8_t mask) {}
 void setPWMValue(int ch, uint16_t value) {}
 
 #warning "No PWM Support"
@@ -28,7 +28,7 @@
 #include "ble.h"
 #include "defines.h"
 #include "filters.h"
-#include "filters/SF1eFilter.h"
+#include "filters/SF1eFilterBank.h"
 #include "io.h"
 #include "joystick.h"
 
@@ -106,6 +106,16 @@ static bool hasAcc = false;
 static bool hasGyr = false;
 static bool hasMag = false;
 
+// Longest time between channel output updates, measured while saving settings
+static volatile bool outputGapMeasure = false;
+static volatile uint32_t outputGapMax = 0;
+static uint32_t outputLastCycles = 0;
+
+// Raw sensor stream, every read is queued for the serial thread while calibrating
+K_MSGQ_DEFINE(rawsample_msgq, sizeof(rawsample_t), RAW_STREAM_QUEUE, 1);
+static volatile bool rawStreamEnabled = false;
+static uint16_t rawSampleSeq = 0;
+
 #if defined(HAS_APDS9960)
 static bool blesenseboard = false;
 static bool lastproximity = false;
@@ -148,11 +158,9 @@ static volatile bool firstrun = true;
 static float aacc[3] = {0, 0, 0};
 static float amag[3] = {0, 0, 0};
 
-// Analog Filters
-SF1eFilter *anFilter[AN_CH_CNT];
-
-// Battery Voltage Filter
-SF1eFilter *anVoltFilter;
+// Analog Filters, AN0-AN3 then the battery voltage
+#define AN_VOLT_FILT AN_CH_CNT
+static SF1eFilterBank<AN_CH_CNT + 1> anFilters;
 
 static struct k_poll_signal senseThreadRunSignal = K_POLL_SIGNAL_INITIALIZER(senseThreadRunSignal);
 struct k_poll_event senseRunEvents[1] = {
@@ -168,6 +176,9 @@ struct k_poll_event calculateRunEvents[1] = {
 
 int sense_Init()
 {
+  // Sensor was hard reset in io_init
+  io_sensorPowerOn();
+
   // If an I2C bus is defined in the device tree, initialize it
 #if DT_NODE_EXISTS(DT_ALIAS(i2csensor))
   const struct device *i2c_dev = DEVICE_DT_GET(DT_ALIAS(i2csensor));
@@ -333,14 +344,8 @@ int sense_Init()
     bt_chansf[i] = 0;
   }
 
-  // Create analog filters
-  for (int i = 0; i < AN_CH_CNT; i++) {
-    anFilter[i] = SF1eFilterCreate(AN_FILT_FREQ, AN_FILT_MINCO, AN_FILT_SLOPE, AN_FILT_DERCO);
-    SF1eFilterInit(anFilter[i]);
-  }
-  // Create battery voltage filter
-  anVoltFilter = SF1eFilterCreate(AN_FILT_FREQ, AN_FILT_MINCO, AN_FILT_SLOPE, AN_FILT_DERCO);
-  SF1eFilterInit(anVoltFilter);
+  // Setup analog + battery voltage filters
+  anFilters.configure(AN_FILT_FREQ, AN_FILT_MINCO, AN_FILT_SLOPE, AN_FILT_DERCO);
 
   // Start reading the IMU sensors + fusion algorithm
   k_poll_signal_raise(&senseThreadRunSignal, 1);
@@ -364,11 +369,6 @@ void calculate_Thread()
     // Do not execute below until after initialization has happened
     k_poll(calculateRunEvents, 1, K_FOREVER);
 
-    if (k_sem_count_get(&flashWriteSemaphore) == 1) {
-      k_msleep(10);
-      continue;
-    }
-
     usduration = micros64();
 
     // Toggles output on and off if long pressed
@@ -596,16 +596,62 @@ void calculate_Thread()
     }
 
     // 7) Set Analog Channels
+    // Every channel in use is read in a single scan then filtered at once. anpins[] maps the
+    //  filters to their ADC channels
+    static const int8_t anpins[AN_CH_CNT + 1] = {
+#if defined(AN0)
+        AN0,
+#else
+        -1,
+#endif
+#if defined(AN1)
+        AN1,
+#else
+        -1,
+#endif
+#if defined(AN2)
+        AN2,
+#else
+        -1,
+#endif
+#if defined(AN3)
+        AN3,
+#else
+        -1,
+#endif
+#if defined(ANVOLTMON)
+        ANVOLTMON,
+#else
+        -1,
+#endif
+    };
+    uint32_t anfilt = (trkset.getAn0Ch() > 0 ? BIT(0) : 0) | (trkset.getAn1Ch() > 0 ? BIT(1) : 0) |
+                      (trkset.getAn2Ch() > 0 ? BIT(2) : 0) | (trkset.getAn3Ch() > 0 ? BIT(3) : 0) |
+                      BIT(AN_VOLT_FILT);
+    uint32_t anchannels = 0;
+    for (int i = 0; i < AN_CH_CNT + 1; i++) {
+      if (anpins[i] < 0) anfilt &= ~BIT(i);
+      if (anfilt & BIT(i)) anchannels |= BIT(anpins[i]);
+    }
+
+    static analog_snapshot_t ansnap;
+    analogScan(anchannels, &ansnap);
+
+    float anin[AN_CH_CNT + 1];
+    float anout[AN_CH_CNT + 1];
+    for (int i = 0; i < AN_CH_CNT + 1; i++) anin[i] = anpins[i] < 0 ? 0 : ansnap.volts[anpins[i]];
+    anFilters.process(anin, anout, anfilt);
+
     // Battery voltage monitor is always analog zero if it has the feature
 #if defined(ANVOLTMON)
-    float anbatt = SF1eFilterDo(anVoltFilter, analogRead(ANVOLTMON));
+    float anbatt = anout[AN_VOLT_FILT];
     anbatt *= ANVOLTMON_SCALE;
     anbatt += ANVOLTMON_OFFSET;
 #endif
 
 #if defined(AN0)
     if (trkset.getAn0Ch() > 0) {
-      float an4 = SF1eFilterDo(anFilter[0], analogRead(AN0));
+      float an4 = anout[0];
       an4 *= trkset.getAn0Gain();
       an4 += trkset.getAn0Off();
       an4 += TrackerSettings::MIN_PWM;
@@ -615,7 +661,7 @@ void calculate_Thread()
 #endif
 #ifdef AN1
     if (trkset.getAn1Ch() > 0) {
-      float an5 = SF1eFilterDo(anFilter[1], analogRead(AN1));
+      float an5 = anout[1];
       an5 *= trkset.getAn1Gain();
       an5 += trkset.getAn1Off();
       an5 += TrackerSettings::MIN_PWM;
@@ -625,7 +671,7 @@ void calculate_Thread()
 #endif
 #ifdef AN2
     if (trkset.getAn2Ch() > 0) {
-      float an6 = SF1eFilterDo(anFilter[2], analogRead(AN2));
+      float an6 = anout[2];
       an6 *= trkset.getAn2Gain();
       an6 += trkset.getAn2Off();
       an6 += TrackerSettings::MIN_PWM;
@@ -635,7 +681,7 @@ void calculate_Thread()
 #endif
 #ifdef AN3
     if (trkset.getAn3Ch() > 0) {
-      float an7 = SF1eFilterDo(anFilter[3], analogRead(AN3));
+      float an7 = anout[3];
       an7 *= trkset.getAn3Gain();
       an7 += trkset.getAn3Off();
       an7 += TrackerSettings::MIN_PWM;
@@ -694,6 +740,12 @@ void calculate_Thread()
       if (trkset.getCh5Arm()) channel_data[4] = 2000;
     }
 
+    // Time since the last output update
+    uint32_t outputcycles = k_cycle_get_32();
+    if (outputGapMeasure)
+      outputGapMax = MAX(outputGapMax, k_cyc_to_us_floor32(outputcycles - outputLastCycles));
+    outputLastCycles = outputcycles;
+
     // 10) Set the PPM Outputs
     PpmOut_execute();
     for (int i = 0; i < PpmOut_getChnCount(); i++) {
@@ -717,18 +769,27 @@ void calculate_Thread()
       else
         uart_data[i] = channel_data[i];
     }
+#if defined(ANVOLTMON)
+    UartSetTelemetry(madgwick.getQuat(), anbatt);
+#else
+    UartSetTelemetry(madgwick.getQuat(), -1);
+#endif
     UartSetChannels(uart_data);
 
-    // 13) Set PWM Channels
+    // 13) Set PWM Channels, all at once
     int8_t pwmchs[4] = {trkset.getPwm0(), trkset.getPwm1(), trkset.getPwm2(), trkset.getPwm3()};
+    uint16_t pwmouts[4];
+    uint8_t pwmmask = 0;
     for (int i = 0; i < 4; i++) {
       int pwmch = pwmchs[i] - 1;
       if (pwmch >= 0 && pwmch < 16) {
-        uint16_t pwmout = channel_data[pwmch];
-        if (pwmout == 0) pwmout = TrackerSettings::PPM_CENTER;
-        setPWMValue(i, pwmout);
+        pwmouts[i] = channel_data[pwmch];
+        if (pwmouts[i] == 0) pwmouts[i] = TrackerSettings::PPM_CENTER;
+        pwmmask |= BIT(i);
       }
     }
+    PWM_SetRate(trkset.getPwmRate());
+    if (pwmmask) setPWMValues(pwmouts, pwmmask);
 
     // 14 Set USB Joystick Channels, Only 8 channels, Half rate or USB is overwhelmed
     static uint32_t joystick_update = 0;
@@ -790,6 +851,13 @@ void calculate_Thread()
       trkset.setDataTrpEnabled(trpOutputEnabled);
       trkset.setDataGyroCal(gyroCalibrated);
 
+      // Achieved UART output timing
+      uint16_t txrate, txjitter, txage;
+      UartGetTxStats(txrate, txjitter, txage);
+      trkset.setDataUartTxRate(txrate);
+      trkset.setDataUartTxJit(txjitter);
+      trkset.setDataUartTxAge(txage);
+
       // Qauterion Data
       float *qd = madgwick.getQuat();
       trkset.setDataQuat(qd);
@@ -833,11 +901,6 @@ void sensor_Thread()
     // Do not execute below until after initialization has happened
     k_poll(senseRunEvents, 1, K_FOREVER);
 
-    if (k_sem_count_get(&flashWriteSemaphore) == 1) {
-      k_msleep(10);
-      continue;
-    }
-
     senseUsDuration = micros64();
 
 #if defined(HAS_APDS9960)
@@ -1001,6 +1064,18 @@ void sensor_Thread()
     }
 #endif
 
+    // Queue the uncalibrated reading, a full queue drops it. The GUI sees the gap in seq
+    if (rawStreamEnabled && (accValid || magValid || gyrValid)) {
+      rawsample_t sample;
+      sample.seq = rawSampleSeq++;
+      sample.valid = (accValid ? RAW_ACC_VALID : 0) | (magValid ? RAW_MAG_VALID : 0) |
+                     (gyrValid ? RAW_GYR_VALID : 0);
+      memcpy(sample.acc, tacc, sizeof(sample.acc));
+      memcpy(sample.mag, tmag, sizeof(sample.mag));
+      memcpy(sample.gyr, tgyr, sizeof(sample.gyr));
+      k_msgq_put(&rawsample_msgq, &sample, K_NO_WAIT);
+    }
+
     k_mutex_lock(&sensor_mutex, K_FOREVER);
 
     // -- Accelerometer
@@ -1286,6 +1361,38 @@ void gyroCalibrate()
   // printk("%.4f,%.2f,%.2f\n", (float)time / 1000000.0f, gyro_dif, acc_dif);
 }
 
+// Start measuring the longest gap between channel output updates
+void sense_startOutputGap()
+{
+  outputGapMax = 0;
+  outputGapMeasure = true;
+}
+
+// Stop measuring, returns the longest gap in us
+uint32_t sense_stopOutputGap()
+{
+  outputGapMeasure = false;
+  return outputGapMax;
+}
+
+// Enable or disable the raw sensor stream, clears anything still queued
+void sense_setRawStream(bool enabled)
+{
+  if (enabled != rawStreamEnabled) LOG_INF("Raw Sensor Stream %s", enabled ? "Started" : "Stopped");
+  rawStreamEnabled = enabled;
+  if (!enabled) k_msgq_purge(&rawsample_msgq);
+}
+
+bool sense_getRawStream() { return rawStreamEnabled; }
+
+// Take up to max queued raw samples, returns the number copied
+int sense_getRawSamples(rawsample_t *samples, int max)
+{
+  int count = 0;
+  while (count < max && k_msgq_get(&rawsample_msgq, &samples[count], K_NO_WAIT) == 0) count++;
+  return count;
+}
+
 // FROM https://stackoverflow.com/questions/1628386/normalise-orientation-between-0-and-360
 // Normalizes any number to an arbitrary range
 // by assuming the range wraps around when going below min or above max
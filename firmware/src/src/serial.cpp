@@ -31,8 +31,11 @@
 #include "io.h"
 
 #include "htmain.h"
+#include "sense.h"
 #include "soc_flash.h"
 #include "trackersettings.h"
+#include "serialcommands.h"
+#include "boottime.h"
 #include "ucrc16lib.h"
 #include "boards/features.h"
 
@@ -43,6 +46,7 @@ char *getJSONBuffer();
 void parseData(JsonDocument &json);
 uint16_t escapeCRC(uint16_t crc);
 int buffersFilled();
+void serialWriteRawSamples();
 
 // Connection state
 uint32_t dtr = 0;
@@ -116,9 +120,6 @@ int serial_init()
   ret = uart_line_ctrl_set(dev, UART_LINE_CTRL_DSR, 1);
 #endif
 
-  /* Wait 1 sec for the host to do all settings */
-  k_busy_wait(1000000);
-
   uart_irq_callback_set(dev, interrupt_handler);
 
   /* Enable rx interrupts */
@@ -134,17 +135,13 @@ int serial_init()
 void serial_Thread()
 {
   uint8_t buffer[256];
-  static uint32_t datacounter = 0;
+  uint32_t lastrates = k_uptime_get_32();
   LOG_INF("Serial Thread Loaded");
 
   while (1) {
     k_poll(serialRunEvents, 1, K_FOREVER);
     k_msleep(SERIAL_PERIOD);
 
-    if (k_sem_count_get(&flashWriteSemaphore) == 1) {
-      continue;
-    }
-
     // If serial not open, abort all transfers, clear buffer
     uint32_t new_dtr = 0;
     uart_line_ctrl_get(dev, UART_LINE_CTRL_DTR, &new_dtr);
@@ -155,6 +152,7 @@ void serial_Thread()
     // lost connection
     if (dtr && !new_dtr) {
       trkset.stopAllData();
+      sense_setRawStream(false);
     }
 
     // gaining new connection
@@ -186,20 +184,36 @@ void serial_Thread()
     k_mutex_unlock(&ring_tx_mutex);
     serialrx_Process();
 
-    // Data output
-    if (datacounter++ >= DATA_PERIOD) {
-      datacounter = 0;
+    // Raw sensor samples for calibration, sent ahead of the budgeted data items
+    if (sense_getRawStream()) serialWriteRawSamples();
+
+    // Data output, limited to the budget for one serial period and what fits in the TX buffer
+    uint32_t now = k_uptime_get_32();
+    int budget = (uint32_t)trkset.getDataBudget() * SERIAL_PERIOD / 1000;
+    k_mutex_lock(&ring_tx_mutex, K_FOREVER);
+    budget = MIN(budget, (int)ring_buf_space_get(&ringbuf_tx) - DATA_FRAME_OVERHEAD);
+    k_mutex_unlock(&ring_tx_mutex);
+
+    // If sense thread is writing, wait until complete
+    k_mutex_lock(&data_mutex, K_FOREVER);
+    json.clear();
+    trkset.setJSONData(json, now, budget);
+    if (json.size()) {
+      json["Cmd"] = "Data";
+      serialWriteJSON(json);
+    }
 
-      // If sense thread is writing, wait until complete
-      k_mutex_lock(&data_mutex, K_FOREVER);
+    // Achieved rates of the requested items
+    if (now - lastrates >= DATA_RATE_PERIOD) {
       json.clear();
-      trkset.setJSONData(json);
+      trkset.setJSONDataRates(json, now - lastrates);
       if (json.size()) {
-        json["Cmd"] = "Data";
+        json["Cmd"] = "DataRate";
         serialWriteJSON(json);
       }
-      k_mutex_unlock(&data_mutex);
+      lastrates = now;
     }
+    k_mutex_unlock(&data_mutex);
   }
 }
 
@@ -234,17 +248,26 @@ void serialrx_Process()
 
 void JSON_Process(char *jsonbuf)
 {
+  // Next expected sequence number and if the last accepted frame restarted the sequence. Until
+  //  a restart is seen rxseq is left from an old session (or boot) and can't be compared. The
+  //  GUI picks a new session id each time it restarts, frames from any other are NAKed
+  static uint8_t rxseq = 0;
+  static bool rxseqreset = false;
+  static bool rxsession = false;
+  static uint16_t rxsessionid = 0;
+
   // CRC Check Data
   int len = strlen(jsonbuf);
   if (len > 2) {
     k_mutex_lock(&ring_tx_mutex, K_FOREVER);
     uint16_t calccrc = escapeCRC(uCRC16Lib::calculate(jsonbuf, len - sizeof(uint16_t)));
     if (calccrc != *(uint16_t *)(jsonbuf + len - sizeof(uint16_t))) {
-      serialWrite("\x15\r\n");  // Not-Acknowledged
+      if (rxsession)
+        serialWriteF("\x15%02X\r\n", rxseq);  // Not-Acknowledged, resend from rxseq
+      else
+        serialWrite("\x15\r\n");  // Not-Acknowledged, resend all
       k_mutex_unlock(&ring_tx_mutex);
       return;
-    } else {
-      serialWrite("\x06\r\n");  // Acknowledged
     }
     // Remove CRC from end of buffer
     jsonbuf[len - sizeof(uint16_t)] = 0;
@@ -264,9 +287,45 @@ void JSON_Process(char *jsonbuf)
         LOG_ERR("DeserializeJson() Failed - TooDeep");
       else
         LOG_ERR("DeserializeJson() Failed - Other");
-    } else {
-      // Parse The JSON Data in dataparser.cpp
+      // CRC was good, resending won't help. Consume it so the window can move on
+      if (rxsession)
+        serialWriteF("\x06%02X\r\n", rxseq++);
+      else
+        serialWrite("\x06\r\n");
+
+    } else if (json["Sq"].isNull()) {
+      // No sequence number, GUI waits for each ACK
+      serialWrite("\x06\r\n");  // Acknowledged
       parseData(json);
+
+    } else {
+      uint8_t seq = json["Sq"];
+      bool reset = json["SqR"] | false;
+      uint16_t session = json["Ss"] | 0;
+
+      // A new session restarts the sequence, unless this is a resend of the restart
+      if (reset && !(rxsession && rxseqreset && session == rxsessionid &&
+                     seq == (uint8_t)(rxseq - 1))) {
+        rxseq = seq;
+        rxsession = true;
+        rxsessionid = session;
+      }
+
+      int8_t ahead = (int8_t)(seq - rxseq);
+      if (!rxsession || session != rxsessionid) {
+        serialWrite("\x15\r\n");  // Restart was lost, resend all
+      } else if (ahead == 0) {
+        serialWriteF("\x06%02X\r\n", seq);  // Acknowledged
+        rxseq++;
+        rxseqreset = reset;
+        parseData(json);
+      } else if (ahead < 0 && ahead >= -SERIAL_RX_WINDOW) {
+        serialWriteF("\x06%02X\r\n", seq);  // Already processed, ACK was lost
+      } else if (ahead < 0) {
+        serialWrite("\x15\r\n");  // Not from this session, resend all
+      } else {
+        serialWriteF("\x15%02X\r\n", rxseq);  // A frame was lost, resend from rxseq
+      }
     }
     k_mutex_unlock(&data_mutex);
     k_mutex_unlock(&ring_tx_mutex);
@@ -276,105 +335,152 @@ void JSON_Process(char *jsonbuf)
 // New JSON data received from the PC
 void parseData(JsonDocument &json)
 {
+  static uint32_t unknowncommands = 0;
+
   JsonVariant v = json["Cmd"];
   if (v.isNull()) {
     LOG_ERR("Invalid JSON, No Command");
     return;
   }
 
-  // For strcmp;
   const char *command = v;
+  if (command == nullptr) command = "";
 
-  // Reset Center
-  if (strcmp(command, "RstCnt") == 0) {
-    // TODO we should also log when the button on the device issues a Reset Center
-    LOG_INF("Resetting Center");
-    pressButton();
+  switch (serialCommandLookup(command)) {
+    // Reset Center
+    case CMD_RESETCENTER:
+      // TODO we should also log when the button on the device issues a Reset Center
+      LOG_INF("Resetting Center");
+      pressButton();
+      break;
 
     // Settings Sent from UI
-  } else if (strcmp(command, "Set") == 0) {
-    trkset.loadJSONSettings(json);
-    LOG_INF("Storing Settings");
+    case CMD_SET:
+      trkset.loadJSONSettings(json);
+      LOG_INF("Storing Settings");
+      break;
 
     // Save to Flash
-  } else if (strcmp(command, "Flash") == 0) {
-    LOG_INF("Saving to Flash");
-    k_sem_give(&saveToFlash_sem);
+    case CMD_FLASH:
+      LOG_INF("Saving to Flash");
+      k_sem_give(&saveToFlash_sem);
+      break;
 
     // Erase
-  } else if (strcmp(command, "Erase") == 0) {
-    LOG_INF("Clearing Flash");
-    socClearFlash();
+    case CMD_ERASE:
+      LOG_INF("Clearing Flash");
+      socClearFlash();
+      break;
 
     // Reboot
-  } else if (strcmp(command, "Reboot") == 0) {
-    sys_reboot(SYS_REBOOT_COLD);
+    case CMD_REBOOT:
+      sys_reboot(SYS_REBOOT_COLD);
+      break;
 
     // Force Bootloader
-  } else if (strcmp(command, "Boot") == 0) {
+    case CMD_BOOTLOADER:
 #if defined(ARDUINO_BOOTLOADER)
-    (*((volatile uint32_t *)0x20007FFCul)) = 0x07738135;
+      (*((volatile uint32_t *)0x20007FFCul)) = 0x07738135;
 #elif defined(SEEED_BOOTLOADER)
-    __disable_irq();
+      __disable_irq();
 #define DFU_MAGIC_UF2_RESET           0x57
-    NRF_POWER->GPREGRET = DFU_MAGIC_UF2_RESET;
+      NRF_POWER->GPREGRET = DFU_MAGIC_UF2_RESET;
 #endif
-    sys_reboot(SYS_REBOOT_COLD);
+      sys_reboot(SYS_REBOOT_COLD);
+      break;
 
     // Get settings
-  } else if (strcmp(command, "Get") == 0) {
-    LOG_INF("Sending Settings");
-    json.clear();
-    trkset.setJSONSettings(json);
-    json["Cmd"] = "Set";
-    serialWriteJSON(json);
+    case CMD_GET: {
+      // Only send settings changed since the GUI's last sync, if it was from this boot
+      uint32_t since = 0;
+      if (json["GenId"] == trkset.getGenerationId()) since = json["Since"] | 0;
+      LOG_INF("Sending Settings");
+      json.clear();
+      trkset.setJSONSettings(json, since);
+      json["Cmd"] = "Set";
+      json["Gen"] = trkset.getGeneration();
+      json["GenId"] = trkset.getGenerationId();
+      serialWriteJSON(json);
+      break;
+    }
 
     // Im Here Received, Means the GUI is running
-  } else if (strcmp(command, "IH") == 0) {
-
+    case CMD_IMHERE:
+      break;
 
     // Get a List of All Data Items
-  } else if (strcmp(command, "DatLst") == 0) {
-    json.clear();
-    trkset.setJSONDataList(json);
-    json["Cmd"] = "DataList";
-    serialWriteJSON(json);
+    case CMD_DATALIST:
+      json.clear();
+      trkset.setJSONDataList(json);
+      json["Cmd"] = "DataList";
+      serialWriteJSON(json);
+      break;
 
     // Stop All Data Items
-  } else if (strcmp(command, "D--") == 0) {
-    LOG_INF("Clearing Data List");
-    trkset.stopAllData();
+    case CMD_STOPDATA:
+      LOG_INF("Clearing Data List");
+      trkset.stopAllData();
+      sense_setRawStream(false);
+      break;
 
     // Request Data Items
-  } else if (strcmp(command, "RD") == 0) {
-    LOG_INF("Data Added/Remove");
-    // using C++11 syntax (preferred):
-    JsonObject root = json.as<JsonObject>();
-    for (JsonPair kv : root) {
-      if (kv.key() == "Cmd") continue;
-      trkset.setDataItemSend(kv.key().c_str(), kv.value().as<bool>());
+    case CMD_REQUESTDATA: {
+      LOG_INF("Data Added/Remove");
+      JsonObject root = json.as<JsonObject>();
+      for (JsonPair kv : root) {
+        if (kv.key() == "Cmd") continue;
+        // true/false uses the default rate, a number is the rate in Hz
+        bool enabled = kv.value().as<bool>();
+        uint16_t rate = 0;
+        if (!kv.value().is<bool>()) {
+          rate = kv.value().as<uint16_t>();
+          enabled = rate > 0;
+        }
+        if (!trkset.setDataItemSend(kv.key().c_str(), enabled, rate))
+          LOG_WRN("Unknown Data Item %s (%u total)", kv.key().c_str(),
+                  trkset.getUnknownDataItems());
+      }
+      break;
     }
 
     // Firmware Reqest
-  } else if (strcmp(command, "FW") == 0) {
-    JsonDocument fwjson;
-    fwjson["Cmd"] = "FW";
-    fwjson["Vers"] = STRINGIFY(FW_VER_TAG);
-    fwjson["Hard"] = FW_BOARD;
-    fwjson["Git"] = STRINGIFY(FW_GIT_REV);
-    serialWriteJSON(fwjson);
+    case CMD_FIRMWARE: {
+      JsonDocument fwjson;
+      fwjson["Cmd"] = "FW";
+      fwjson["Vers"] = STRINGIFY(FW_VER_TAG);
+      fwjson["Hard"] = FW_BOARD;
+      fwjson["Git"] = STRINGIFY(FW_GIT_REV);
+      serialWriteJSON(fwjson);
+      break;
+    }
 
     // Board Features Request
-  } else if (strcmp(command, "FE") == 0) {
-    json.clear();
-    getBoardFeatures(json);
-    json["Cmd"] = "FE";
-    serialWriteJSON(json);
+    case CMD_FEATURES:
+      json.clear();
+      getBoardFeatures(json);
+      json["Cmd"] = "FE";
+      serialWriteJSON(json);
+      break;
+
+    // Start/Stop the binary raw sensor stream
+    case CMD_RAWSTREAM:
+      sense_setRawStream(json["En"] | false);
+      break;
+
+    // Boot timeline
+    case CMD_BOOTTIME:
+      json.clear();
+      boot_setJSON(json);
+      json["Cmd"] = "BootTm";
+      serialWriteJSON(json);
+      break;
 
     // Unknown Command
-  } else {
-    LOG_WRN("Unknown Command");
-    return;
+    case CMD_UNKNOWN:
+    default:
+      unknowncommands++;
+      LOG_WRN("Unknown Command %s (%u total)", command, unknowncommands);
+      break;
   }
 }
 
@@ -425,6 +531,39 @@ int serialWriteF(const char *format, ...)
   return len;
 }
 
+// Raw sensor samples are binary. Frame starts with 0x11 (device control 1), sample count then
+// the packed samples, ends with 0x03. Any byte the GUI uses for framing is escaped with 0x1B
+void serialWriteRawSamples()
+{
+  rawsample_t samples[RAW_STREAM_FRAME];
+  char data[(sizeof(samples) + 1) * 2 + 4];
+
+  int count = sense_getRawSamples(samples, RAW_STREAM_FRAME);
+  if (count == 0) return;
+
+  uint8_t raw[sizeof(samples) + 1];
+  int rawlen = 1 + count * sizeof(rawsample_t);
+  raw[0] = count;
+  memcpy(raw + 1, samples, rawlen - 1);
+
+  int len = 0;
+  data[len++] = 0x11;
+  for (int i = 0; i < rawlen; i++) {
+    uint8_t c = raw[i];
+    if (c == 0x01 || c == 0x02 || c == 0x03 || c == 0x06 || c == 0x10 || c == 0x11 || c == 0x15 ||
+        c == 0x1B || c == '\r' || c == '\n') {
+      data[len++] = 0x1B;
+      c ^= 0xFF;
+    }
+    data[len++] = c;
+  }
+  data[len++] = 0x03;
+  data[len++] = '\r';
+  data[len++] = '\n';
+
+  serialWrite(data, len);
+}
+
 // FIX Me to Not use as Much Stack.
 void serialWriteJSON(JsonDocument &json)
 {
@@ -0,0 +1,84 @@
+/*
+* This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+* Copyright (c) 2022 Cliff Blackburn
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**********************************************
+ *
+ *  !!! THIS FILE IS AUTOMATICALLY GENERATED, DO NOT EDIT DIRECTLY !!!
+ *
+ *  Modify buildfwcommands.py and execute buildsettings.py to generate this FW header
+ *
+ ***********************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "basetrackersettings.h"
+
+enum SerialCommand {
+  CMD_UNKNOWN = 0,
+  CMD_RESETCENTER,
+  CMD_SET,
+  CMD_FLASH,
+  CMD_ERASE,
+  CMD_REBOOT,
+  CMD_BOOTLOADER,
+  CMD_GET,
+  CMD_IMHERE,
+  CMD_DATALIST,
+  CMD_STOPDATA,
+  CMD_REQUESTDATA,
+  CMD_FIRMWARE,
+  CMD_FEATURES,
+  CMD_RAWSTREAM,
+  CMD_BOOTTIME,
+};
+
+// Returns the command matching str, CMD_UNKNOWN if there is none
+static inline SerialCommand serialCommandLookup(const char *str)
+{
+  // Hash slot to command, 0 = empty
+  static const uint8_t slots[64] = {
+    0, 8, 0, 0, 0, 0, 0, 0, 2, 5, 0, 0, 0, 0, 0, 0,
+    6, 0, 3, 0, 7, 0, 0, 0, 0, 0, 0, 0, 0, 13, 11, 0,
+    0, 0, 0, 0, 0, 0, 0, 12, 0, 0, 4, 0, 1, 0, 0, 0,
+    0, 0, 10, 15, 0, 0, 0, 14, 9, 0, 0, 0, 0, 0, 0, 0,
+  };
+  static const char *const names[15] = {
+    "RstCnt",
+    "Set",
+    "Flash",
+    "Erase",
+    "Reboot",
+    "Boot",
+    "Get",
+    "IH",
+    "DatLst",
+    "D--",
+    "RD",
+    "FW",
+    "FE",
+    "RawS",
+    "BootTm",
+  };
+
+  uint8_t cmd = slots[BaseTrackerSettings::nameHash(str, 0x811c9dc8u) & 63];
+  if (cmd == 0 || strcmp(str, names[cmd - 1]) != 0)
+    return CMD_UNKNOWN;
+  return (SerialCommand)cmd;
+}
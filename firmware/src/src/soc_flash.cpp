@@ -20,16 +20,10 @@
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/drivers/flash.h>
+#include <zephyr/fs/nvs.h>
 #include <zephyr/storage/flash_map.h>
 #include <zephyr/logging/log.h>
 
-#if defined(CONFIG_SOC_ESP32) || defined(CONFIG_SOC_ESP32C3) || defined(CONFIG_SOC_ESP32S3)
-#include <spi_flash_mmap.h>
-#include <soc.h>
-static bool isFlashMemMapped = false;
-spi_flash_mmap_handle_t handle;
-#endif
-
 #include "defines.h"
 
 LOG_MODULE_REGISTER(soc_flash);
@@ -39,125 +33,159 @@ LOG_MODULE_REGISTER(soc_flash);
 #define FLASH_SIZE FIXED_PARTITION_SIZE(FLASH_PARTITION)
 #define FLASH_DEVICE FIXED_PARTITION_DEVICE(FLASH_PARTITION)
 
-// Pause for flash write to complete
-K_SEM_DEFINE(flashWriteSemaphore, 0, 1);
-
-// Use a pointer to flash on these architectures
-#if defined(CONFIG_SOC_ESP32) ||\
-    defined(CONFIG_SOC_ESP32C3) ||\
-    defined(CONFIG_SOC_ESP32S3) ||\
-    defined(CONFIG_SOC_SERIES_NRF52X)
-const uint8_t *mem_ptr = NULL;
-#else
-// Architecture does not support memory mapping, use a buffer
-uint8_t mem_ptr[FLASH_SIZE];
-#endif
-
-int socReadFlash(uint8_t dataout[FLASH_SIZE]);
-
-/* Get the flash space as a memory mapped pointer
- *   on ESP it must call spi_flash_mmap to map the flash space
- *   on nRF it just returns the address of the flash space
+// Settings are records in a NVS file system. NVS appends every write and only erases a
+// sector when it runs out of room, moving the records still in use (wear levelled)
+static struct nvs_fs settingsfs;
+static bool settingsMounted = false;
+
+// Present once the partition holds records, otherwise it may be an old JSON blob
+#define RECORD_HEADER_ID 0
+static const uint32_t RECORD_HEADER_MAGIC = 0x48545332;  // HTS2
+
+/* Reads len bytes at offset into the partition
  *
- *   Returns null on failure
+ *   Returns the bytes read, less at the end of the partition, negative on failure
  */
 
-const uint8_t *socGetMMFlashPtr()
+int socReadFlash(uint32_t offset, void *data, int len)
 {
-  #if defined(CONFIG_SOC_ESP32) || defined(CONFIG_SOC_ESP32C3) || defined(CONFIG_SOC_ESP32S3)
-  if(!isFlashMemMapped) {
-    const struct device *flash_device = DEVICE_DT_GET(DT_CHOSEN(zephyr_flash_controller));
-    if (!device_is_ready(flash_device)) {
-      LOG_ERR("%s: device not ready.\n", flash_device->name);
-      return NULL;
-    }
-
-    /* map selected region */
-    spi_flash_mmap(FLASH_OFFSET, FLASH_SIZE, SPI_FLASH_MMAP_DATA, (const void **)&mem_ptr, &handle);
-    isFlashMemMapped = true;
-  }
-  #elif defined(CONFIG_SOC_SERIES_NRF52X)
-  mem_ptr = (const uint8_t *)FLASH_OFFSET;
-  #else
-  socReadFlash(mem_ptr);
-  #endif
-  // Is flash memory blank. Return a indicator there is nothing to be read
-  if(*mem_ptr == 0xFF) {
-    return (uint8_t *)"{\"UUID\":837727,\"TEST\":343}";
+  const struct device *flash_device = FLASH_DEVICE;
+  if (!device_is_ready(flash_device)) {
+    LOG_ERR("%s: device not ready.\n", flash_device->name);
+    return -1;
   }
-  return mem_ptr;
+  if (offset >= FLASH_SIZE) return 0;
+  len = MIN(len, (int)(FLASH_SIZE - offset));
+  if (flash_read(flash_device, FLASH_OFFSET + offset, data, len)) return -1;
+  return len;
 }
 
-int socReadFlash(uint8_t dataout[FLASH_SIZE])
+/* Erases the partition one page at a time, sleeping in between so the real time threads
+ *   keep running. Only the page being erased stalls them
+ */
+
+static int socErasePages()
 {
   const struct device *flash_device = FLASH_DEVICE;
-	if (!device_is_ready(flash_device)) {
-		LOG_ERR("%s: device not ready.\n", flash_device->name);
-		return -1;
-	}
-  memset(dataout, 0, FLASH_SIZE);
-	flash_read(flash_device, FLASH_OFFSET, dataout, FLASH_SIZE);
+  struct flash_pages_info info;
+
+  settingsMounted = false;
+  for (off_t offset = FLASH_OFFSET; offset < FLASH_OFFSET + FLASH_SIZE; offset += info.size) {
+    if (flash_get_page_info_by_offs(flash_device, offset, &info)) {
+      LOG_ERR("Unable to get flash page info");
+      return -1;
+    }
+    if (flash_erase(flash_device, offset, info.size) != 0) {
+      LOG_ERR("Flash erase Failure");
+      return -1;
+    }
+    k_msleep(FLASH_CHUNK_PAUSE);
+  }
   return 0;
 }
 
-void socClearFlash()
+static int socMountRecords()
 {
-  const struct device *flash_device = FLASH_DEVICE;
-  if (!flash_device) {
-    LOG_ERR("Flash Device Not Found!");
-    return;
+  if (settingsMounted) return 0;
+
+  settingsfs.flash_device = FLASH_DEVICE;
+  if (!device_is_ready(settingsfs.flash_device)) {
+    LOG_ERR("%s: device not ready.\n", settingsfs.flash_device->name);
+    return -1;
   }
 
-  LOG_INF("Erasing Flash at Offset: %d", FLASH_OFFSET);
-  LOG_INF("Flash Size: %d", FLASH_SIZE);
+  struct flash_pages_info info;
+  settingsfs.offset = FLASH_OFFSET;
+  if (flash_get_page_info_by_offs(settingsfs.flash_device, FLASH_OFFSET, &info)) {
+    LOG_ERR("Unable to get flash page info");
+    return -1;
+  }
+  settingsfs.sector_size = info.size;
+  settingsfs.sector_count = FLASH_SIZE / info.size;
 
-  k_sem_give(&flashWriteSemaphore);
+  int rc = nvs_mount(&settingsfs);
+  if (rc) {
+    LOG_ERR("Unable to mount settings records (%d)", rc);
+    return rc;
+  }
+  settingsMounted = true;
+  return 0;
+}
 
-  k_msleep(PAUSE_BEFORE_FLASH);
+/* True if the partition holds the single JSON blob of older firmware. Checked with a raw read,
+ *  mounting the records would find no entries in the first sector and erase it
+ */
 
-  if (flash_erase(flash_device, FLASH_OFFSET, FLASH_SIZE) != 0) {
-    LOG_ERR("Flash erase Failure");
+bool socHasLegacyBlob()
+{
+  uint8_t first = 0xFF;
+  return !settingsMounted && socReadFlash(0, &first, 1) == 1 && first == '{';
+}
 
-    return;
-  }
-  k_sem_take(&flashWriteSemaphore, K_NO_WAIT);
-  LOG_INF("Flash erase succeeded");
+// True if the partition has been formatted for records
+bool socHasRecords()
+{
+  uint32_t magic = 0;
+  if (socMountRecords()) return false;
+  return nvs_read(&settingsfs, RECORD_HEADER_ID, &magic, sizeof(magic)) == sizeof(magic) &&
+         magic == RECORD_HEADER_MAGIC;
 }
 
-int socWriteFlash(const uint8_t *datain, int len)
+// Erases the partition, including an old JSON blob, and marks it as holding records
+int socFormatRecords()
 {
-  const struct device *flash_dev;
+  LOG_INF("Formatting flash for settings records");
 
-  flash_dev = DEVICE_DT_GET_OR_NULL(DT_CHOSEN(zephyr_flash_controller));
+  int rc = socErasePages();
+  if (rc == 0) rc = socMountRecords();
+  if (rc == 0 && nvs_write(&settingsfs, RECORD_HEADER_ID, &RECORD_HEADER_MAGIC,
+                           sizeof(RECORD_HEADER_MAGIC)) < 0)
+    rc = -1;
 
-  if (!flash_dev) {
-    LOG_ERR("Flash driver was not found!");
-    return -1;
-  }
+  if (rc) LOG_ERR("Flash format failure (%d)", rc);
+  return rc;
+}
 
-  k_sem_give(&flashWriteSemaphore);
-  k_msleep(PAUSE_BEFORE_FLASH);
+/* Reads a record into data
+ *
+ *   Returns the length of the record, it can be larger than len
+ *   -ENOENT if the record doesn't exist
+ */
 
-  LOG_INF("Erasing Flash at Offset: %d", FLASH_OFFSET);
-  LOG_INF("Flash Size: %d", FLASH_SIZE);
+int socReadRecord(uint16_t id, void *data, int len)
+{
+  if (socMountRecords()) return -1;
+  return nvs_read(&settingsfs, id + 1, data, len);
+}
 
-  if (flash_erase(flash_dev, FLASH_OFFSET, FLASH_SIZE) != 0) {
-    LOG_ERR("Flash erase Failure");
-    k_sem_take(&flashWriteSemaphore, K_NO_WAIT);
-    return -1;
-  }
+/* Appends a record to flash, unless it matches the one already stored
+ *
+ *   Returns the bytes written, 0 if nothing changed, negative on failure
+ */
 
-  LOG_INF("Flash erase succeeded");
-  k_msleep(PAUSE_BEFORE_FLASH);
+int socWriteRecord(uint16_t id, const void *data, int len)
+{
+  if (socMountRecords()) return -1;
+  return nvs_write(&settingsfs, id + 1, data, len);
+}
 
-  if (flash_write(flash_dev, FLASH_OFFSET, (const void *)datain, len) != 0) {
-    LOG_ERR("Flash write failed!");
-    k_sem_take(&flashWriteSemaphore, K_NO_WAIT);
-    return -1;
+int socDeleteRecord(uint16_t id)
+{
+  if (socMountRecords()) return -1;
+  return nvs_delete(&settingsfs, id + 1);
+}
+
+void socClearFlash()
+{
+  const struct device *flash_device = FLASH_DEVICE;
+  if (!flash_device) {
+    LOG_ERR("Flash Device Not Found!");
+    return;
   }
 
-  LOG_INF("Flash write succeeded, %d%% used", (len * 100) / FLASH_SIZE);
-  k_sem_take(&flashWriteSemaphore, K_NO_WAIT);
+  LOG_INF("Erasing Flash at Offset: %d", FLASH_OFFSET);
+  LOG_INF("Flash Size: %d", FLASH_SIZE);
 
-  return 0;
+  if (socErasePages()) return;
+  LOG_INF("Flash erase succeeded");
 }
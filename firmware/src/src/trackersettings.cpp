@@ -18,6 +18,7 @@
 #include "trackersettings.h"
 
 #include <zephyr/logging/log.h>
+#include <zephyr/random/random.h>
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
@@ -26,6 +27,7 @@
 #include "base64.h"
 #include "io.h"
 
+#include "htmain.h"
 #include "sense.h"
 #include "soc_flash.h"
 
@@ -63,48 +65,308 @@ bool TrackerSettings::isPanReversed() { return (servoreverse & PAN_REVERSE_BIT);
 
 void TrackerSettings::resetFusion() { reset_fusion(); }
 
-// Saves current data to flash
+// Settings records. The image is split in blocks so a save only writes the blocks that changed
+#define SETTINGS_HEADER_ID 0
+#define SETTINGS_FIELDS_ID 1
+#define SETTINGS_BLOCK_ID 2
+
+// Counts boots, after any settings block
+#define BOOT_COUNT_ID 0x7FF0
+
+struct __attribute__((packed)) SettingsHeader {
+  uint32_t schema;
+  uint16_t size;
+  uint16_t fields;
+};
+
+// Reads the old JSON blob straight from flash, in place of mapping or copying the partition
+class FlashReader
+{
+ public:
+  int read()
+  {
+    uint8_t c;
+    if (socReadFlash(offset, &c, 1) != 1) return -1;
+    offset++;
+    return c;
+  }
+  size_t readBytes(char *buffer, size_t length)
+  {
+    int len = socReadFlash(offset, buffer, length);
+    if (len <= 0) return 0;
+    offset += len;
+    return len;
+  }
+
+ private:
+  uint32_t offset = 0;
+};
+
+static int readImageBlocks(uint8_t *image, int size)
+{
+  for (int offset = 0; offset < size; offset += SETTINGS_BLOCK_SIZE) {
+    int len = MIN(SETTINGS_BLOCK_SIZE, size - offset);
+    if (socReadRecord(SETTINGS_BLOCK_ID + offset / SETTINGS_BLOCK_SIZE, image + offset, len) !=
+        len)
+      return -1;
+  }
+  return 0;
+}
+
+template <typename T>
+static double getField(const uint8_t *src)
+{
+  T v;
+  memcpy(&v, src, sizeof(v));
+  return v;
+}
+
+template <typename T>
+static void setField(uint8_t *dst, double val)
+{
+  T v = val;
+  memcpy(dst, &v, sizeof(v));
+}
+
+// Reads a numeric field as a double, false for text
+static bool fieldToDouble(uint8_t type, const uint8_t *src, double &val)
+{
+  switch (type) {
+    case BaseTrackerSettings::SETTING_BOOL: val = *src != 0; return true;
+    case BaseTrackerSettings::SETTING_U8: val = getField<uint8_t>(src); return true;
+    case BaseTrackerSettings::SETTING_S8: val = getField<int8_t>(src); return true;
+    case BaseTrackerSettings::SETTING_U16: val = getField<uint16_t>(src); return true;
+    case BaseTrackerSettings::SETTING_S16: val = getField<int16_t>(src); return true;
+    case BaseTrackerSettings::SETTING_U32: val = getField<uint32_t>(src); return true;
+    case BaseTrackerSettings::SETTING_S32: val = getField<int32_t>(src); return true;
+    case BaseTrackerSettings::SETTING_FLOAT: val = getField<float>(src); return true;
+    case BaseTrackerSettings::SETTING_DOUBLE: val = getField<double>(src); return true;
+  }
+  return false;
+}
+
+// Writes a double to a numeric field, clamped to what the type can hold
+static bool doubleToField(uint8_t type, uint8_t *dst, double val)
+{
+  switch (type) {
+    case BaseTrackerSettings::SETTING_BOOL:
+      *dst = val != 0;
+      return true;
+    case BaseTrackerSettings::SETTING_U8:
+      setField<uint8_t>(dst, CLAMP(val, 0, UINT8_MAX));
+      return true;
+    case BaseTrackerSettings::SETTING_S8:
+      setField<int8_t>(dst, CLAMP(val, INT8_MIN, INT8_MAX));
+      return true;
+    case BaseTrackerSettings::SETTING_U16:
+      setField<uint16_t>(dst, CLAMP(val, 0, UINT16_MAX));
+      return true;
+    case BaseTrackerSettings::SETTING_S16:
+      setField<int16_t>(dst, CLAMP(val, INT16_MIN, INT16_MAX));
+      return true;
+    case BaseTrackerSettings::SETTING_U32:
+      setField<uint32_t>(dst, CLAMP(val, 0, UINT32_MAX));
+      return true;
+    case BaseTrackerSettings::SETTING_S32:
+      setField<int32_t>(dst, CLAMP(val, INT32_MIN, INT32_MAX));
+      return true;
+    case BaseTrackerSettings::SETTING_FLOAT:
+      setField<float>(dst, val);
+      return true;
+    case BaseTrackerSettings::SETTING_DOUBLE:
+      setField<double>(dst, val);
+      return true;
+  }
+  return false;
+}
+
+// Saves the settings image to flash. Only blocks that changed are written
+//   The image is staged in RAM first. The other threads keep running, sleeping after each
+//   flash write lets them update the outputs between writes
 void TrackerSettings::saveToEEPROM()
 {
-  uint8_t buffer[TX_RNGBUF_SIZE];
+  SettingsImage img;
 
   k_mutex_lock(&data_mutex, K_FOREVER);
-  json.clear();
-  setJSONSettings(json);
-  int len = serializeJson(json, buffer, TX_RNGBUF_SIZE);
+  getSettingsImage(img);
   k_mutex_unlock(&data_mutex);
 
-  if (socWriteFlash(buffer, len)) {
-    LOG_ERR("Flash Write Failed size(%d)", len);
-  } else {
-    LOG_INF("Saved to Flash size(%d)", len);
+  int64_t start = k_uptime_get();
+  sense_startOutputGap();
+
+  // First save after programming, or on a partition holding the old single JSON blob
+  if (!socHasRecords() && socFormatRecords()) {
+    LOG_ERR("Flash Write Failed, unable to format");
+    sense_stopOutputGap();
+    return;
+  }
+
+  // Image first, the header and field table only change with the schema
+  const uint8_t *image = (const uint8_t *)&img;
+  int written = 0;
+  int rc = 0;
+  for (int offset = 0; offset < (int)sizeof(img) && rc >= 0; offset += SETTINGS_BLOCK_SIZE) {
+    rc = socWriteRecord(SETTINGS_BLOCK_ID + offset / SETTINGS_BLOCK_SIZE, image + offset,
+                        MIN(SETTINGS_BLOCK_SIZE, (int)sizeof(img) - offset));
+    if (rc > 0) {
+      written += rc;
+      k_msleep(FLASH_CHUNK_PAUSE);
+    }
+  }
+
+  SettingsHeader hdr = {SETTINGS_SCHEMA, sizeof(SettingsImage), SETTINGS_FIELD_COUNT};
+  if (rc >= 0) {
+    rc = socWriteRecord(SETTINGS_FIELDS_ID, settingsFields(),
+                        sizeof(SettingsField) * SETTINGS_FIELD_COUNT);
+    if (rc > 0) written += rc;
+  }
+  if (rc >= 0) {
+    rc = socWriteRecord(SETTINGS_HEADER_ID, &hdr, sizeof(hdr));
+    if (rc > 0) written += rc;
+  }
+
+  uint32_t gap = sense_stopOutputGap();
+  if (rc < 0) {
+    LOG_ERR("Flash Write Failed (%d)", rc);
+    return;
+  }
+  LOG_INF("Saved to Flash, %d bytes written in %lldms", written, k_uptime_get() - start);
+  LOG_INF("Longest output update gap while saving %uus", gap);
+}
+
+// Converts an image saved with another schema. Fields are matched by name, settings that
+//   are new or can't be converted keep their defaults
+void TrackerSettings::migrateImage(int size, int fieldcount)
+{
+  static uint8_t oldimage[SETTINGS_IMAGE_MAX];
+  static SettingsField oldfields[SETTINGS_FIELDS_MAX];
+
+  if (size > SETTINGS_IMAGE_MAX || fieldcount > SETTINGS_FIELDS_MAX ||
+      socReadRecord(SETTINGS_FIELDS_ID, oldfields, sizeof(SettingsField) * fieldcount) !=
+          (int)sizeof(SettingsField) * fieldcount ||
+      readImageBlocks(oldimage, size)) {
+    LOG_ERR("Unable to read the saved settings, using defaults");
+    return;
+  }
+
+  SettingsImage img;
+  uint8_t *image = (uint8_t *)&img;
+  const SettingsField *fields = settingsFields();
+  int migrated = 0;
+
+  k_mutex_lock(&data_mutex, K_FOREVER);
+  getSettingsImage(img);
+  for (int i = 0; i < SETTINGS_FIELD_COUNT; i++) {
+    for (int j = 0; j < fieldcount; j++) {
+      const SettingsField &from = oldfields[j];
+      if (from.name != fields[i].name) continue;
+      if (from.offset + from.size > size) break;
+
+      const uint8_t *src = oldimage + from.offset;
+      uint8_t *dst = image + fields[i].offset;
+      double val;
+      if (from.type == fields[i].type && from.size == fields[i].size) {
+        memcpy(dst, src, from.size);
+        migrated++;
+      } else if (from.type == SETTING_CHAR && fields[i].type == SETTING_CHAR) {
+        memset(dst, 0, fields[i].size);
+        memcpy(dst, src, MIN(from.size, fields[i].size - 1));
+        migrated++;
+      } else if (fieldToDouble(from.type, src, val) && doubleToField(fields[i].type, dst, val)) {
+        migrated++;
+      }
+      break;
+    }
   }
+  loadSettingsImage(img);
+  k_mutex_unlock(&data_mutex);
+
+  LOG_INF("Migrated %d of %d settings to the new layout", migrated, SETTINGS_FIELD_COUNT);
+
+  // Store it in the new layout
+  k_sem_give(&saveToFlash_sem);
+}
+
+// Increments the boot count kept in flash, 0 if it can't be stored
+
+static uint32_t nextBootCount()
+{
+  static_assert(SETTINGS_BLOCK_ID + sizeof(SettingsImage) / SETTINGS_BLOCK_SIZE < BOOT_COUNT_ID,
+                "Boot count overlaps the settings blocks");
+  uint32_t count = 0;
+  if (socReadRecord(BOOT_COUNT_ID, &count, sizeof(count)) != (int)sizeof(count)) count = 0;
+  count++;
+  if (socWriteRecord(BOOT_COUNT_ID, &count, sizeof(count)) < 0) return 0;
+  return count;
 }
 
 // Called on startup to read the data from Flash
 
 void TrackerSettings::loadFromEEPROM()
 {
-  // Load Settings
-  DeserializationError de;
+  // Older firmware stored the settings as a single JSON blob. It has to be read before the
+  //  records are mounted, then it's replaced by records straight away
+  if (socHasLegacyBlob() && loadLegacyJSON()) {
+    LOG_INF("Converting the saved settings to records");
+    if (socFormatRecords() == 0) saveToEEPROM();
+  }
 
-  k_mutex_lock(&data_mutex, K_FOREVER);
-  const uint8_t *memptr = socGetMMFlashPtr();
-  if(memptr == NULL) {
-    LOG_ERR("Unable to get flash memory pointer");
-    k_mutex_unlock(&data_mutex);
+  // Freshly programmed, or nothing usable was found. Start out with records so the boot count
+  //  can be kept
+  bool records = socHasRecords();
+  if (!records) {
+    LOG_INF("No settings records found, formatting");
+    records = socFormatRecords() == 0;
+  }
+
+  // New id each boot so the GUI can't use generations from before a reboot. Without an entropy
+  //  source the cycle count is about the same every boot, the boot count makes it unique
+#if defined(CONFIG_ENTROPY_GENERATOR)
+  setGenerationId(sys_rand32_get());
+#else
+  setGenerationId(k_cycle_get_32() ^ (records ? nextBootCount() * 2654435761u : 0));
+#endif
+
+  if (!records) return;
+
+  // Settings image, copied straight into place when the layout matches
+  SettingsHeader hdr;
+  if (socReadRecord(SETTINGS_HEADER_ID, &hdr, sizeof(hdr)) != (int)sizeof(hdr)) {
+    LOG_INF("No settings saved");
+    return;
+  }
+  if (hdr.schema != SETTINGS_SCHEMA || hdr.size != sizeof(SettingsImage)) {
+    LOG_INF("Settings saved with another layout (%08x), migrating", hdr.schema);
+    migrateImage(hdr.size, hdr.fields);
     return;
   }
-  de = deserializeJson(json, memptr);
 
-  if (de != DeserializationError::Ok) LOG_ERR("Invalid JSON Data");
+  SettingsImage img;
+  if (readImageBlocks((uint8_t *)&img, sizeof(img))) {
+    LOG_ERR("Unable to read the saved settings, using defaults");
+    return;
+  }
+  LOG_INF("Loading settings from flash");
+  k_mutex_lock(&data_mutex, K_FOREVER);
+  loadSettingsImage(img);
+  k_mutex_unlock(&data_mutex);
+}
 
-  if (json["UUID"] == 837727) {
-    LOG_INF("Device has been freshly programmed, no data found");
+// Loads the JSON blob older firmware saved, false if it doesn't parse. A record sector can
+//  also start with '{', its contents won't parse as JSON
 
+bool TrackerSettings::loadLegacyJSON()
+{
+  FlashReader reader;
+  bool loaded = false;
+  k_mutex_lock(&data_mutex, K_FOREVER);
+  if (deserializeJson(json, reader) != DeserializationError::Ok) {
+    LOG_ERR("Invalid JSON Data");
   } else {
     LOG_INF("Loading settings from flash");
     loadJSONSettings(json);
+    loaded = true;
   }
   k_mutex_unlock(&data_mutex);
+  return loaded;
 }
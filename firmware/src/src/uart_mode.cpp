@@ -18,16 +18,21 @@
 #include "uart_mode.h"
 
 #include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
 
 #include "CRSF/crsfin.h"
 #include "CRSF/crsfout.h"
 #include "SBUS/sbus.h"
+#include "auxserial.h"
+#include "chcodec.h"
 #include "defines.h"
 #include "io.h"
 
 #include "soc_flash.h"
 #include "trackersettings.h"
 
+LOG_MODULE_REGISTER(uartmode);
+
 // s#define DEBUG_UART_RATE
 
 // Globals
@@ -49,7 +54,29 @@ struct k_poll_event uartTxRunEvents[1] = {
     K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, &uartTxThreadRunSignal),
 };
 
+/* Latest outgoing channels (us) and telemetry, handed from the calculate thread to the TX
+ *  thread. The writer fills the slot that isn't published then flips txSlotReady. The TX
+ *  thread outranks the writer so it can't be lapped part way through copying the published slot
+ */
+static_assert(UARTTX_THREAD_PRIO < CALCULATE_THREAD_PRIO, "UART TX must preempt calculate");
+
+typedef struct {
+  uint16_t ch[16];
+  float quat[4];   // Madgwick orientation
+  float battery;   // (V) Negative if the board can't measure it
+  uint32_t stamp;  // k_cycle_get_32() when written
+} uartTxSlot;
 
+static uartTxSlot txSlots[2];
+static float txQuat[4] = {1, 0, 0, 0};
+static float txBattery = -1;
+static volatile uint8_t txSlotReady = 0;
+static volatile bool txSlotValid = false;
+
+// Achieved output timing of the active protocol over the last second
+static volatile uint16_t txRate = 0;
+static volatile uint16_t txJitter = 0;  // (us) Largest distance of a frame from its slot
+static volatile uint16_t txAge = 0;     // (us) Oldest channel data sent
 
 uint32_t PacketCount = 0;
 
@@ -67,11 +94,10 @@ void uartRx_Thread()
 {
   while (1) {
     k_poll(uartRxRunEvents, 1, K_FOREVER);
-    k_usleep(UART_PERIOD);
 
-    if (k_sem_count_get(&flashWriteSemaphore) == 1) {
-      continue;
-    }
+    // Woken as soon as the RX line goes idle after a frame. The timeout keeps mode changes and
+    //  the stale data checks going with nothing connected
+    AuxSerial_WaitRx(K_USEC(UART_PERIOD));
 
     if (curmode != trkset.getUartMode()) UartSetMode((uartmodet)trkset.getUartMode());
 
@@ -104,6 +130,7 @@ void uartRx_Thread()
         }
         break;
       case UARTCRSFOUT:
+        crsfout.loop();
         break;
       default:
         break;
@@ -111,31 +138,120 @@ void uartRx_Thread()
   }
 }
 
+static int64_t uptimeUs() { return k_ticks_to_us_floor64(k_uptime_ticks()); }
+
+// Copies the last published slot, false if none have been written yet
+static bool uartTxLatest(uartTxSlot &out)
+{
+  if (!txSlotValid) return false;
+  memcpy(&out, &txSlots[txSlotReady], sizeof(out));
+  return true;
+}
+
+/* Builds a frame from the newest channels and sends it, returns the age of the data in us.
+ *  CRSF telemetry goes in the time left in the frame period
+ */
+
+static int32_t uartTxFrame(uartmodet mode, uint32_t period)
+{
+  uartTxSlot slot;
+  if (!uartTxLatest(slot)) return -1;
+
+  uint16_t *channels = slot.ch;
+  switch (mode) {
+    case UARTSBUSIO:
+      for (int i = 0; i < 16; i++) channels[i] = ChCodec::UsToSbus::map(channels[i]);
+      SbusWriteChannels(channels);
+      SbusTx();
+      break;
+    case UARTCRSFOUT:
+      for (int i = 0; i < 16; i++) channels[i] = ChCodec::UsToCrsf::map(channels[i]);
+      ChCodec::pack(channels, (uint8_t *)crsfout.PackedRCdataOut);
+      crsfout.sendRCFrameToFC();
+      crsfout.negotiateSpeed(period);
+      crsfout.sendTelemetry(slot.quat, slot.battery, period);
+      break;
+    default:
+      return -1;
+  }
+  return k_cyc_to_us_floor32(k_cycle_get_32() - slot.stamp);
+}
+
+static uint16_t uartTxRate(uartmodet mode)
+{
+  switch (mode) {
+    case UARTSBUSIO:
+      return trkset.getSbusTxRate();
+    case UARTCRSFOUT:
+      return trkset.getCrsfTxRate();
+    default:
+      return 0;
+  }
+}
+
+/* Frames are sent on an absolute schedule, each one period after the last slot rather than
+ *  after the last send. Time spent building and writing the frame doesn't accumulate as
+ *  drift. If the thread falls more than a frame behind the schedule restarts from now
+ */
+
 void uartTx_Thread()
 {
+  uartmodet lastmode = UARTDISABLE;
+  int64_t nextframe = 0;
+  int64_t windowend = 0;
+  uint32_t frames = 0;
+  uint32_t maxjitter = 0;
+  int32_t maxage = 0;
+
   while (1) {
     k_poll(uartTxRunEvents, 1, K_FOREVER);
-    if (k_sem_count_get(&flashWriteSemaphore) == 1) {
-      k_msleep(10);
+
+    uartmodet mode = curmode;
+    uint16_t rate = uartTxRate(mode);
+    if (rate == 0) {
+      txRate = 0;
+      txJitter = 0;
+      txAge = 0;
+      lastmode = mode;
+      k_msleep(1000);
       continue;
     }
+    int64_t period = 1000000 / rate;
 
-    switch (curmode) {
-      case UARTSBUSIO:
-        SbusTx();
-        k_usleep((1.0f / (float)trkset.getSbusTxRate()) * 1.0e6f);
-        break;
-      case UARTCRSFOUT:
-        k_usleep((1.0f / (float)trkset.getCrsfTxRate()) * 1.0e6f);
-        crsfout.sendRCFrameToFC();
-        /*crsfout.AttitudeDataOut.pitch = 10;
-        crsfout.AttitudeDataOut.roll = 30;
-        crsfout.AttitudeDataOut.yaw += 1;
-        crsfout.sendAttitideToFC();*/
-        break;
-      default:
-        k_msleep(1000);
-        break;
+    int64_t now = uptimeUs();
+    if (mode != lastmode || now - nextframe > period) {
+      lastmode = mode;
+      nextframe = now;
+      windowend = now + 1000000;
+      frames = 0;
+      maxjitter = 0;
+      maxage = 0;
+    }
+
+    k_sleep(K_TIMEOUT_ABS_US(nextframe));
+    now = uptimeUs();
+    uint32_t jitter = now > nextframe ? now - nextframe : nextframe - now;
+    if (jitter > maxjitter) maxjitter = jitter;
+
+    int32_t age = uartTxFrame(mode, period);
+    if (age >= 0) {
+      frames++;
+      if (age > maxage) maxage = age;
+    }
+    nextframe += period;
+
+    if (now >= windowend) {
+      txRate = frames;
+      txJitter = MIN(maxjitter, UINT16_MAX);
+      txAge = MIN(maxage, UINT16_MAX);
+#ifdef DEBUG_UART_RATE
+      LOG_INF("%s TX %u Hz, Jitter %u us, Age %u us", mode == UARTSBUSIO ? "SBUS" : "CRSF",
+              txRate, txJitter, txAge);
+#endif
+      windowend += 1000000;
+      frames = 0;
+      maxjitter = 0;
+      maxage = 0;
     }
   }
 }
@@ -198,37 +314,29 @@ bool UartGetChannels(uint16_t channels[16])
   return dataIsValid;
 }
 
+// Publishes the outgoing channels (us), the TX thread scales and packs them when it sends
 void UartSetChannels(uint16_t channels[16])
 {
-  switch (curmode) {
-    case UARTSBUSIO:
-      for (int i = 0; i < 16; i++) {
-        channels[i] = (static_cast<float>(channels[i]) - TrackerSettings::PPM_CENTER) *
-                          TrackerSettings::SBUS_SCALE +
-                      TrackerSettings::SBUS_CENTER;
-      }
-      SbusWriteChannels(channels);
-      break;
-    case UARTCRSFOUT:
-      crsfout.PackedRCdataOut.ch0 = US_to_CRSF(channels[0]);
-      crsfout.PackedRCdataOut.ch1 = US_to_CRSF(channels[1]);
-      crsfout.PackedRCdataOut.ch2 = US_to_CRSF(channels[2]);
-      crsfout.PackedRCdataOut.ch3 = US_to_CRSF(channels[3]);
-      crsfout.PackedRCdataOut.ch4 = US_to_CRSF(channels[4]);
-      crsfout.PackedRCdataOut.ch5 = US_to_CRSF(channels[5]);
-      crsfout.PackedRCdataOut.ch6 = US_to_CRSF(channels[6]);
-      crsfout.PackedRCdataOut.ch7 = US_to_CRSF(channels[7]);
-      crsfout.PackedRCdataOut.ch8 = US_to_CRSF(channels[8]);
-      crsfout.PackedRCdataOut.ch9 = US_to_CRSF(channels[9]);
-      crsfout.PackedRCdataOut.ch10 = US_to_CRSF(channels[10]);
-      crsfout.PackedRCdataOut.ch11 = US_to_CRSF(channels[11]);
-      crsfout.PackedRCdataOut.ch12 = US_to_CRSF(channels[12]);
-      crsfout.PackedRCdataOut.ch13 = US_to_CRSF(channels[13]);
-      crsfout.PackedRCdataOut.ch14 = US_to_CRSF(channels[14]);
-      crsfout.PackedRCdataOut.ch15 = US_to_CRSF(channels[15]);
-      crsfout.LinkStatistics.rf_Mode = RATE_LORA_100HZ_8CH;
-      break;
-    default:
-      break;
-  }
+  uint8_t idx = !txSlotReady;
+  memcpy(txSlots[idx].ch, channels, sizeof(txSlots[idx].ch));
+  memcpy(txSlots[idx].quat, txQuat, sizeof(txQuat));
+  txSlots[idx].battery = txBattery;
+  txSlots[idx].stamp = k_cycle_get_32();
+  compiler_barrier();
+  txSlotReady = idx;
+  txSlotValid = true;
+}
+
+// Orientation and battery voltage for CRSF telemetry, sent with the next UartSetChannels
+void UartSetTelemetry(const float quat[4], float battery)
+{
+  memcpy(txQuat, quat, sizeof(txQuat));
+  txBattery = battery;
+}
+
+void UartGetTxStats(uint16_t &rate, uint16_t &jitter, uint16_t &age)
+{
+  rate = txRate;
+  jitter = txJitter;
+  age = txAge;
 }
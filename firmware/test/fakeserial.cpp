@@ -0,0 +1,90 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fakeserial.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "auxserial.h"
+#include "trackersettings.h"
+
+TrackerSettings trkset;
+uint32_t PacketCount = 0;
+
+static std::vector<uint8_t> rxData;
+static size_t rxPos = 0;
+static size_t rxMaxChunk = 32;
+static std::vector<uint8_t> txData;
+static uint32_t openBaud = 0;
+static int openCount = 0;
+
+namespace FakeSerial {
+
+void reset(size_t maxChunk)
+{
+  rxData.clear();
+  rxPos = 0;
+  rxMaxChunk = maxChunk;
+  txData.clear();
+  openBaud = 0;
+  openCount = 0;
+}
+
+void feed(const uint8_t *data, size_t len) { rxData.insert(rxData.end(), data, data + len); }
+
+size_t pending() { return rxData.size() - rxPos; }
+
+std::vector<uint8_t> &written() { return txData; }
+
+uint32_t baud() { return openBaud; }
+
+int opens() { return openCount; }
+
+}  // namespace FakeSerial
+
+int AuxSerial_Open(uint32_t baudrate, uint16_t, uint8_t)
+{
+  openBaud = baudrate;
+  openCount++;
+  return 0;
+}
+
+bool AuxSerial_Available() { return rxPos < rxData.size(); }
+
+void AuxSerial_Close() {}
+
+uint32_t AuxSerial_Write(const uint8_t *buffer, uint32_t len)
+{
+  txData.insert(txData.end(), buffer, buffer + len);
+  return len;
+}
+
+uint32_t AuxSerial_Read(uint8_t *buffer, uint32_t bufsize)
+{
+  size_t len = std::min<size_t>({bufsize, rxData.size() - rxPos, (size_t)rand() % rxMaxChunk + 1});
+  std::copy_n(rxData.begin() + rxPos, len, buffer);
+  rxPos += len;
+
+  // Keep the feed from growing without end in the longer runs
+  if (rxPos == rxData.size()) {
+    rxData.clear();
+    rxPos = 0;
+  }
+  return len;
+}
@@ -0,0 +1,39 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+/* Aux serial stand in. Bytes fed by a test come back from AuxSerial_Read() in pieces of a
+ *  random size up to the chunk limit, like the DMA idle/half full events deliver them
+ */
+
+namespace FakeSerial {
+
+void reset(size_t maxChunk = 32);
+void feed(const uint8_t *data, size_t len);
+size_t pending();
+
+std::vector<uint8_t> &written();
+uint32_t baud();
+int opens();
+
+}  // namespace FakeSerial
@@ -0,0 +1,50 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include <chrono>
+
+// Minimal checks for the host tests, a failed check is printed and fails the test
+
+inline int hostTestFailures = 0;
+
+#define CHECK(cond)                                                 \
+  do {                                                              \
+    if (!(cond)) {                                                  \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      hostTestFailures++;                                           \
+    }                                                               \
+  } while (0)
+
+inline int testResult(const char *name)
+{
+  printf("%s: %s\n", name, hostTestFailures ? "FAILED" : "passed");
+  return hostTestFailures ? 1 : 0;
+}
+
+// Nanoseconds per iteration of fn, for the benchmark lines the tests print
+template <typename F>
+double nsPerCall(int iterations, F fn)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) fn(i);
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
@@ -0,0 +1,192 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Settings record store on the native_sim flash simulator. soc_flash.cpp is built into this
+ *  file so a test can drop the mount, which is all a reboot does to it
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/drivers/flash.h>
+#include <zephyr/drivers/flash/flash_simulator.h>
+#include <zephyr/ztest.h>
+
+#include "soc_flash.cpp"
+
+// The partition in the simulator's memory, written directly to cut the power part way
+static uint8_t *partition()
+{
+  size_t size;
+  uint8_t *mem = (uint8_t *)flash_simulator_get_memory(FLASH_DEVICE, &size);
+  return mem + FLASH_OFFSET;
+}
+
+static void reboot()
+{
+  settingsMounted = false;
+  memset(&settingsfs, 0, sizeof(settingsfs));
+}
+
+static void eraseBefore(void *)
+{
+  socClearFlash();
+  reboot();
+}
+
+ZTEST_SUITE(soc_flash, NULL, NULL, eraseBefore, NULL, NULL);
+
+ZTEST(soc_flash, test_format)
+{
+  zassert_false(socHasRecords(), "Erased partition has records");
+  reboot();
+  zassert_false(socHasLegacyBlob(), "Erased partition has a JSON blob");
+
+  zassert_ok(socFormatRecords());
+  zassert_true(socHasRecords());
+  uint32_t v;
+  zassert_equal(socReadRecord(0, &v, sizeof(v)), -ENOENT);
+
+  reboot();
+  zassert_false(socHasLegacyBlob(), "Formatted partition taken for a JSON blob");
+  zassert_true(socHasRecords(), "Format lost on reboot");
+}
+
+ZTEST(soc_flash, test_save_load)
+{
+  zassert_ok(socFormatRecords());
+  for (uint16_t id = 0; id < 10; id++) {
+    uint32_t v = id * 1000 + 7;
+    zassert_equal(socWriteRecord(id, &v, sizeof(v)), (int)sizeof(v));
+  }
+
+  // Unchanged records aren't written again
+  uint32_t v = 3007;
+  zassert_equal(socWriteRecord(3, &v, sizeof(v)), 0);
+  v = 42;
+  zassert_equal(socWriteRecord(3, &v, sizeof(v)), (int)sizeof(v));
+  zassert_ok(socDeleteRecord(5));
+
+  reboot();
+  zassert_true(socHasRecords());
+  for (uint16_t id = 0; id < 10; id++) {
+    int rc = socReadRecord(id, &v, sizeof(v));
+    if (id == 5) {
+      zassert_equal(rc, -ENOENT, "Deleted record %u read back", id);
+    } else {
+      zassert_equal(rc, (int)sizeof(v), "Record %u missing", id);
+      zassert_equal(v, id == 3 ? 42 : id * 1000 + 7, "Record %u is %u", id, v);
+    }
+  }
+
+  // A short buffer still gets the length of the record
+  uint8_t small;
+  zassert_equal(socReadRecord(0, &small, sizeof(small)), (int)sizeof(uint32_t));
+}
+
+// Enough saves to fill every sector, the records still in use are moved as sectors are erased
+ZTEST(soc_flash, test_wear_levelling)
+{
+  zassert_ok(socFormatRecords());
+  uint8_t block[64];  // One settings block
+  memset(block, 0x5A, sizeof(block));
+  zassert_equal(socWriteRecord(1, block, sizeof(block)), (int)sizeof(block));
+
+  for (uint32_t i = 0; i < 2000; i++) {
+    zassert_equal(socWriteRecord(2, &i, sizeof(i)), (int)sizeof(i), "Save %u failed", i);
+  }
+
+  reboot();
+  zassert_true(socHasRecords(), "Header lost moving records");
+  uint8_t readblock[sizeof(block)];
+  zassert_equal(socReadRecord(1, readblock, sizeof(readblock)), (int)sizeof(readblock));
+  zassert_mem_equal(readblock, block, sizeof(block));
+  uint32_t v;
+  zassert_equal(socReadRecord(2, &v, sizeof(v)), (int)sizeof(v));
+  zassert_equal(v, 1999);
+}
+
+/* Cuts the power part way through a save. The bytes the write changed are put back in address
+ *  order, the data before its entry the same as NVS writes them, for every length from none to
+ *  all. After a reboot the record has to read as the old or the new value and the store must
+ *  still take writes
+ */
+ZTEST(soc_flash, test_power_loss)
+{
+  static uint8_t before[FLASH_SIZE];
+  static uint8_t after[FLASH_SIZE];
+  const uint32_t oldv = 0x11111111, newv = 0x22222222, nextv = 0x33333333;
+
+  zassert_ok(socFormatRecords());
+  zassert_equal(socWriteRecord(7, &oldv, sizeof(oldv)), (int)sizeof(oldv));
+  memcpy(before, partition(), FLASH_SIZE);
+  zassert_equal(socWriteRecord(7, &newv, sizeof(newv)), (int)sizeof(newv));
+  memcpy(after, partition(), FLASH_SIZE);
+
+  int changed = 0;
+  for (int i = 0; i < FLASH_SIZE; i++) changed += before[i] != after[i];
+  zassert_true(changed > 0);
+
+  for (int cut = 0; cut <= changed; cut++) {
+    uint8_t *mem = partition();
+    memcpy(mem, before, FLASH_SIZE);
+    for (int i = 0, n = 0; i < FLASH_SIZE && n < cut; i++) {
+      if (before[i] == after[i]) continue;
+      mem[i] = after[i];
+      n++;
+    }
+
+    reboot();
+    zassert_true(socHasRecords(), "Format lost, cut after %d of %d bytes", cut, changed);
+    uint32_t v = 0;
+    zassert_equal(socReadRecord(7, &v, sizeof(v)), (int)sizeof(v), "Record lost, cut at %d", cut);
+    zassert_true(v == oldv || v == newv, "Record is %08x, cut at %d", v, cut);
+    if (cut == changed) zassert_equal(v, newv);
+
+    zassert_equal(socWriteRecord(7, &nextv, sizeof(nextv)), (int)sizeof(nextv), "Cut at %d", cut);
+    reboot();
+    zassert_equal(socReadRecord(7, &v, sizeof(v)), (int)sizeof(v));
+    zassert_equal(v, nextv, "Write after a cut at %d lost", cut);
+  }
+}
+
+/* Boards updated from older firmware hold one JSON blob at the start of the partition. It has
+ *  to be found and read without mounting the records, then replaced by them
+ */
+ZTEST(soc_flash, test_legacy_blob)
+{
+  static const char legacy[64] = "{\"rll_min\":1000,\"rll_max\":2000,\"btmode\":1}";
+  zassert_ok(flash_write(FLASH_DEVICE, FLASH_OFFSET, legacy, sizeof(legacy)));
+  reboot();
+
+  zassert_true(socHasLegacyBlob());
+  char blob[sizeof(legacy)];
+  zassert_equal(socReadFlash(0, blob, sizeof(blob)), (int)sizeof(blob));
+  zassert_mem_equal(blob, legacy, sizeof(blob), "Blob changed by the check");
+
+  // Converted the way loadFromEEPROM does it
+  zassert_ok(socFormatRecords());
+  zassert_false(socHasLegacyBlob(), "Mounted records taken for a JSON blob");
+  zassert_equal(socWriteRecord(0, blob, sizeof(blob)), (int)sizeof(blob));
+
+  reboot();
+  zassert_false(socHasLegacyBlob(), "JSON blob still there after converting");
+  zassert_true(socHasRecords());
+  char record[sizeof(legacy)];
+  zassert_equal(socReadRecord(0, record, sizeof(record)), (int)sizeof(record));
+  zassert_mem_equal(record, legacy, sizeof(record));
+}
@@ -0,0 +1,38 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Baud rates are plain numbers on the host
+#define BAUD100000 100000
+#define BAUD400000 400000
+#define BAUD420000 420000
+#define BAUD921600 921600
+#define BAUD1000000 1000000
+
+#define CONF8N1 0x00000000
+#define CONF8E2 0x0000001E
+#define CONFINV_TX (1 << 0)
+#define CONFINV_RX (1 << 1)
+
+int AuxSerial_Open(uint32_t baudrate, uint16_t settings, uint8_t inversions = 0);
+bool AuxSerial_Available();
+void AuxSerial_Close();
+uint32_t AuxSerial_Write(const uint8_t* buffer, uint32_t len);
+uint32_t AuxSerial_Read(uint8_t* buffer, uint32_t bufsize);
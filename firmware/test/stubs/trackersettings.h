@@ -0,0 +1,37 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// The settings the host built modules read, set directly by the tests
+class TrackerSettings
+{
+ public:
+  bool getSbInInv() const { return sbInInv; }
+  bool getSbOutInv() const { return sbOutInv; }
+  bool getCrsfTxInv() const { return crsfTxInv; }
+  uint8_t getCrsfTxBaud() const { return crsfTxBaud; }
+
+  bool sbInInv = false;
+  bool sbOutInv = false;
+  bool crsfTxInv = false;
+  uint8_t crsfTxBaud = 0;
+};
+
+extern TrackerSettings trkset;
@@ -0,0 +1,32 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Host stand in for the kernel, time only moves when a test sets it
+
+inline int64_t hostUptimeMs = 0;
+
+static inline int64_t k_uptime_get() { return hostUptimeMs; }
+static inline uint32_t k_cycle_get_32() { return (uint32_t)(hostUptimeMs * 1000); }
+static inline uint32_t k_cyc_to_ms_floor32(uint32_t cyc) { return cyc / 1000; }
+
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#define ARG_UNUSED(x) (void)(x)
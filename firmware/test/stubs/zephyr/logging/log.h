@@ -0,0 +1,27 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Arguments are still evaluated and used, so the host build warns the same as the firmware
+inline void hostLogDiscard(...) {}
+
+#define LOG_MODULE_REGISTER(...)
+#define LOG_ERR(...) do { hostLogDiscard(__VA_ARGS__); } while (0)
+#define LOG_WRN(...) do { hostLogDiscard(__VA_ARGS__); } while (0)
+#define LOG_INF(...) do { hostLogDiscard(__VA_ARGS__); } while (0)
+#define LOG_DBG(...) do { hostLogDiscard(__VA_ARGS__); } while (0)
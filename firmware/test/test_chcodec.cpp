@@ -0,0 +1,185 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Channel codec. pack()/unpack() against a bit at a time reference for every value of every
+ *  channel, the integer scaling against the float formulas it replaced for every input, and
+ *  the time per frame of each
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <algorithm>
+
+#include "chcodec.h"
+#include "hosttest.h"
+
+// Bit n of the payload is bit n % 8 of byte n / 8, channels LSB first
+static void refPack(const uint16_t ch[16], uint8_t packed[22])
+{
+  for (int i = 0; i < 22; i++) packed[i] = 0;
+  for (int i = 0; i < 16 * 11; i++)
+    if (ch[i / 11] & (1 << (i % 11))) packed[i / 8] |= 1 << (i % 8);
+}
+
+static bool packMatches(const uint16_t ch[16])
+{
+  uint8_t ref[22], got[22];
+  uint16_t back[16];
+  refPack(ch, ref);
+  ChCodec::pack(ch, got);
+  ChCodec::unpack(ref, back);
+  for (int i = 0; i < 22; i++)
+    if (got[i] != ref[i]) return false;
+  for (int i = 0; i < 16; i++)
+    if (back[i] != ch[i]) return false;
+  return true;
+}
+
+// Every value in every channel, with the neighbours all clear and all set
+static void testPackExhaustive()
+{
+  for (int c = 0; c < 16; c++) {
+    for (uint16_t v = 0; v < 2048; v++) {
+      uint16_t ch[16];
+      for (int i = 0; i < 16; i++) ch[i] = 0;
+      ch[c] = v;
+      CHECK(packMatches(ch));
+      for (int i = 0; i < 16; i++) ch[i] = 0x7FF;
+      ch[c] = v;
+      CHECK(packMatches(ch));
+    }
+  }
+}
+
+static void testPackRandom()
+{
+  for (int t = 0; t < 100000; t++) {
+    uint16_t ch[16];
+    for (int i = 0; i < 16; i++) ch[i] = rand() & 0x7FF;
+    CHECK(packMatches(ch));
+  }
+
+  // Bits above 11 are dropped
+  uint16_t ch[16], back[16];
+  uint8_t packed[22];
+  for (int i = 0; i < 16; i++) ch[i] = 0xF800 | i;
+  ChCodec::pack(ch, packed);
+  ChCodec::unpack(packed, back);
+  for (int i = 0; i < 16; i++) CHECK(back[i] == i);
+}
+
+// The float conversions in sbus.cpp, uart_mode.cpp and crsfin.cpp before the integer scaling
+static uint16_t oldSbusToUs(int ch)
+{
+  int16_t us = ((float)ch - 992) / 1.6f + 1500;
+  return us > 2012 ? 2012 : (us < 988 ? 988 : us);
+}
+
+static uint16_t oldUsToSbus(int us) { return (uint16_t)(((float)us - 1500) * 1.6f + 992) & 0x7FF; }
+
+static uint16_t oldCrsfToUs(int ch) { return (ch - 191.0f) * (2000 - 1000) / (1792 - 191) + 1000; }
+
+static uint16_t oldUsToCrsf(int us)
+{
+  return roundf((uint16_t)((us - 988.0f) * (1811 - 172) / (2012 - 988) + 172));
+}
+
+static void testScaleExhaustive()
+{
+  for (int ch = 0; ch < 2048; ch++) {
+    CHECK(ChCodec::SbusToUs::map(ch) == oldSbusToUs(ch));
+    CHECK(ChCodec::CrsfToUs::map(ch) == oldCrsfToUs(ch));
+  }
+  for (int us = 988; us <= 2012; us++) {
+    CHECK(ChCodec::UsToSbus::map(us) == oldUsToSbus(us));
+    CHECK(ChCodec::UsToCrsf::map(us) == oldUsToCrsf(us));
+  }
+}
+
+// Out and back in again stays close over the whole PWM range. CRSF in maps 1000-2000us to
+// 191-1792, slightly narrower than out does, so it only comes back close within 1000-2000us
+static void testScaleRoundTrip()
+{
+  int sbusErr = 0, crsfErr = 0;
+  for (int us = 988; us <= 2012; us++) {
+    sbusErr = std::max(sbusErr, abs(ChCodec::SbusToUs::map(ChCodec::UsToSbus::map(us)) - us));
+    if (us >= 1000 && us <= 2000)
+      crsfErr = std::max(crsfErr, abs(ChCodec::CrsfToUs::map(ChCodec::UsToCrsf::map(us)) - us));
+  }
+  printf("round trip: sbus max error %dus, crsf max error %dus\n", sbusErr, crsfErr);
+  CHECK(sbusErr <= 1);
+  CHECK(crsfErr <= 1);
+}
+
+static inline uint64_t cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static void benchmark()
+{
+  const int frames = 1000000;
+  static uint16_t ch[16];
+  static uint8_t packed[22];
+  for (int i = 0; i < 16; i++) ch[i] = rand() & 0x7FF;
+
+  uint64_t start = cycles();
+  double ns = nsPerCall(frames, [&](int i) {
+    ch[i & 15] = i & 0x7FF;
+    ChCodec::pack(ch, packed);
+    asm volatile("" : : "r"(packed) : "memory");
+  });
+  uint64_t cyc = cycles() - start;
+  printf("pack: %.1f ns/frame, %.0f cycles/frame\n", ns, (double)cyc / frames);
+
+  start = cycles();
+  ns = nsPerCall(frames, [&](int i) {
+    packed[i % 22] = i;
+    ChCodec::unpack(packed, ch);
+    asm volatile("" : : "r"(ch) : "memory");
+  });
+  cyc = cycles() - start;
+  printf("unpack: %.1f ns/frame, %.0f cycles/frame\n", ns, (double)cyc / frames);
+
+  start = cycles();
+  ns = nsPerCall(frames, [&](int i) {
+    ch[i & 15] = ChCodec::UsToCrsf::map(988 + (i & 1023));
+    asm volatile("" : : "r"(ch) : "memory");
+  });
+  cyc = cycles() - start;
+  printf("UsToCrsf: %.1f ns/channel, %.0f cycles/channel\n", ns, (double)cyc / frames);
+}
+
+int main()
+{
+  srand(1);
+  testPackExhaustive();
+  testPackRandom();
+  testScaleExhaustive();
+  testScaleRoundTrip();
+  benchmark();
+  return testResult("chcodec");
+}
@@ -0,0 +1,142 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* CRCs. The table driven uCRC16Lib is checked against the bit at a time version it replaced
+ *  for every length up to past the slicing threshold, every alignment and random data, and
+ *  both are timed. Built once with the firmware copy and once with the GUI copy so the two
+ *  ends of the serial link are known to agree. The CRSF CRC8 tables are checked the same way
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "CRSF/crc8.h"
+#include "hosttest.h"
+#include "ucrc16lib.h"
+
+// uCRC16Lib 2.0.0 calculate(), before the tables
+static uint16_t oldCrc16(const char *data_p, uint16_t length)
+{
+  uint8_t i;
+  uint16_t data;
+  uint16_t crc = 0xffff;
+
+  if (length == 0) {
+    return (~crc);
+  }
+
+  do {
+    for (i = 0, data = (uint16_t)0xff & *data_p++; i < 8; i++, data >>= 1) {
+      if ((crc & 0x0001) ^ (data & 0x0001)) {
+        crc = (crc >> 1) ^ uCRC16Lib_POLYNOMIAL;
+      } else {
+        crc >>= 1;
+      }
+    }
+  } while (--length);
+  crc = ~crc;
+  return (crc);
+}
+
+static uint8_t oldCrc8(uint8_t poly, const uint8_t *data, uint8_t len)
+{
+  uint8_t crc = 0;
+  while (len--) {
+    crc ^= *data++;
+    for (int i = 0; i < 8; i++) crc = (crc & 0x80) ? (crc << 1) ^ poly : crc << 1;
+  }
+  return crc;
+}
+
+static char buf[4100];
+
+static void fill()
+{
+  for (size_t i = 0; i < sizeof(buf); i++) buf[i] = rand();
+}
+
+static void testCrc16()
+{
+  // Short lengths either side of the slicing threshold, at every alignment
+  fill();
+  for (int offset = 0; offset < 4; offset++) {
+    for (int len = 0; len <= 4 * uCRC16Lib_SLICE4_MIN + 3; len++)
+      CHECK(uCRC16Lib::calculate(buf + offset, len) == oldCrc16(buf + offset, len));
+  }
+
+  for (int t = 0; t < 20000; t++) {
+    fill();
+    int offset = rand() % 4;
+    int len = rand() % 4096;
+    CHECK(uCRC16Lib::calculate(buf + offset, len) == oldCrc16(buf + offset, len));
+  }
+
+  // CRC-16/X-25 check value
+  CHECK(uCRC16Lib::calculate("123456789", 9) == 0x906E);
+
+  // The CRC appended little endian leaves the good residue
+  fill();
+  uint16_t crc = uCRC16Lib::calculate(buf, 100);
+  buf[100] = crc & 0xFF;
+  buf[101] = crc >> 8;
+  CHECK(uCRC16Lib::calculate(buf, 102) == uCRC16Lib::crc_ok);
+}
+
+static void testCrc8()
+{
+  for (int t = 0; t < 20000; t++) {
+    fill();
+    uint8_t len = rand() % 64;
+    const uint8_t *data = (const uint8_t *)buf;
+    CHECK(CrsfCrc8::calc(data, len) == oldCrc8(CRSF_CRC_POLY, data, len));
+    CHECK(CrsfCmdCrc8::calc(data, len) == oldCrc8(CRSF_COMMAND_CRC_POLY, data, len));
+
+    // Continued in two pieces, as the receive ring does when a frame wraps
+    uint8_t split = len ? rand() % len : 0;
+    CHECK(CrsfCrc8::calc(data + split, len - split, CrsfCrc8::calc(data, split)) ==
+          CrsfCrc8::calc(data, len));
+  }
+}
+
+static void benchmark()
+{
+  fill();
+  const int lengths[] = {8, 64, 512, 4096};
+  for (int len : lengths) {
+    int iterations = 4000000 / len;
+    volatile uint16_t sink = 0;
+    double oldNs = nsPerCall(iterations, [&](int i) { sink += oldCrc16(buf + (i & 3), len); });
+    double newNs =
+        nsPerCall(iterations, [&](int i) { sink += uCRC16Lib::calculate(buf + (i & 3), len); });
+    printf("crc16 %4d bytes: bitwise %.2f ns/byte, tables %.2f ns/byte\n", len, oldNs / len,
+           newNs / len);
+  }
+
+  volatile uint8_t sink = 0;
+  double ns =
+      nsPerCall(1000000, [&](int i) { sink += CrsfCrc8::calc((uint8_t *)buf + (i & 7), 24); });
+  printf("crc8 CRSF channels frame: %.1f ns\n", ns);
+}
+
+int main()
+{
+  srand(1);
+  testCrc16();
+  testCrc8();
+  benchmark();
+  return testResult("crc");
+}
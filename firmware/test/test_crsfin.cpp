@@ -0,0 +1,334 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* CRSF receive parser. Frames of every kind, good and bad CRCs, other addresses and line
+ *  noise go through the fake aux serial in random sized pieces. Only whole, valid frames to
+ *  the flight controller may come out, and the ring must never lose sync for long
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+
+#include <deque>
+#include <vector>
+
+#include "CRSF/crsfin.h"
+#include "chcodec.h"
+#include "fakeserial.h"
+#include "hosttest.h"
+
+static uint32_t channelPackets;
+static uint32_t gpsPackets;
+static uint32_t statsPackets;
+static int linkUps;
+static int linkDowns;
+
+static CrsfSerial *parser;
+static std::deque<std::vector<uint16_t>> sentChannels;  // Channel frames not delivered yet
+
+static void randomChannels(uint16_t ch[16])
+{
+  for (int i = 0; i < 16; i++) ch[i] = CRSF_CHANNEL_VALUE_MIN + rand() % 1640;
+}
+
+static bool matches(const CrsfSerial &crsf, const uint16_t ch[16])
+{
+  for (int i = 0; i < 16; i++) {
+    // Same as the float map the parser used before the integer scaling
+    uint16_t us = fmap(ch[i], CRSF_CHANNEL_VALUE_1000, CRSF_CHANNEL_VALUE_2000, 1000, 2000);
+    if (crsf.getChannel(i + 1) != us) return false;
+  }
+  return true;
+}
+
+// A frame held back by junk in front of it comes out later, but in order. Whatever comes out
+// must be one of the frames sent since the last delivery
+static void onChannels()
+{
+  channelPackets++;
+  while (!sentChannels.empty()) {
+    bool match = matches(*parser, sentChannels.front().data());
+    sentChannels.pop_front();
+    if (match) return;
+  }
+  CHECK(!"Channels delivered that weren't sent");
+}
+
+static void onGps(crsf_sensor_gps_t *) { gpsPackets++; }
+static void onStats(crsfLinkStatistics_t *) { statsPackets++; }
+static void onUp() { linkUps++; }
+static void onDown() { linkDowns++; }
+
+static std::vector<uint8_t> frame(uint8_t addr, uint8_t type, const void *payload, uint8_t len)
+{
+  std::vector<uint8_t> f(len + 4);
+  f[0] = addr;
+  f[1] = len + 2;
+  f[2] = type;
+  memcpy(&f[3], payload, len);
+  f[len + 3] = CrsfCrc8::calc(&f[2], len + 1);
+  return f;
+}
+
+static std::vector<uint8_t> channelFrame(const uint16_t ch[16])
+{
+  uint8_t packed[ChCodec::PACKED_LEN];
+  ChCodec::pack(ch, packed);
+  return frame(CRSF_ADDRESS_FLIGHT_CONTROLLER, CRSF_FRAMETYPE_RC_CHANNELS_PACKED, packed,
+               sizeof(packed));
+}
+
+static void feed(const std::vector<uint8_t> &f) { FakeSerial::feed(f.data(), f.size()); }
+
+static void feedChannels(const uint16_t ch[16])
+{
+  sentChannels.emplace_back(ch, ch + 16);
+  feed(channelFrame(ch));
+}
+
+static void drain(CrsfSerial &crsf)
+{
+  while (FakeSerial::pending()) crsf.loop();
+}
+
+static CrsfSerial *newParser()
+{
+  CrsfSerial *crsf = new CrsfSerial;
+  crsf->onLinkUp = onUp;
+  crsf->onLinkDown = onDown;
+  crsf->onShiftyByte = nullptr;
+  crsf->onPacketChannels = onChannels;
+  crsf->onPacketLinkStatistics = onStats;
+  crsf->onPacketGps = onGps;
+  channelPackets = gpsPackets = statsPackets = 0;
+  linkUps = linkDowns = 0;
+  sentChannels.clear();
+  parser = crsf;
+  return crsf;
+}
+
+// Valid channel frames back to back, every one delivered intact
+static void testClean(size_t maxChunk)
+{
+  FakeSerial::reset(maxChunk);
+  CrsfSerial *crsf = newParser();
+  for (int t = 0; t < 5000; t++) {
+    uint16_t ch[16];
+    randomChannels(ch);
+    feedChannels(ch);
+    uint32_t before = channelPackets;
+    drain(*crsf);
+    CHECK(channelPackets == before + 1);
+    CHECK(sentChannels.empty());
+  }
+  CHECK(linkUps == 1);
+  delete crsf;
+}
+
+/* Mixed traffic. Each valid frame to the FC is preceded by junk: noise without the FC
+ *  address, frames with a bad CRC, frames to other devices, types the parser ignores and
+ *  bad lengths. The junk can swallow a following frame when its declared length runs into
+ *  it, so a small loss is allowed but nothing may be delivered that wasn't sent
+ */
+static void testFuzz()
+{
+  FakeSerial::reset(20);
+  CrsfSerial *crsf = newParser();
+  uint32_t sentChannelFrames = 0, sentStats = 0, sentGps = 0;
+  for (int t = 0; t < 20000; t++) {
+    int junk = rand() % 5;
+    for (int j = 0; j < junk; j++) {
+      switch (rand() % 5) {
+        case 0: {
+          int n = rand() % 30;
+          for (int i = 0; i < n; i++) {
+            uint8_t b = rand();
+            if (b == CRSF_ADDRESS_FLIGHT_CONTROLLER) b = 0;
+            FakeSerial::feed(&b, 1);
+          }
+          break;
+        }
+        case 1: {
+          uint16_t ch[16];
+          randomChannels(ch);
+          std::vector<uint8_t> f = channelFrame(ch);
+          f[3 + rand() % 23] ^= 1 << (rand() % 8);
+          feed(f);
+          break;
+        }
+        case 2: {
+          uint16_t ch[16];
+          randomChannels(ch);
+          std::vector<uint8_t> f = channelFrame(ch);
+          f[0] = CRSF_ADDRESS_CRSF_TRANSMITTER;
+          f.back() = CrsfCrc8::calc(&f[2], f.size() - 3);
+          feed(f);
+          break;
+        }
+        case 3: {
+          uint8_t payload[10] = {};
+          feed(frame(CRSF_ADDRESS_FLIGHT_CONTROLLER, CRSF_FRAMETYPE_BATTERY_SENSOR, payload,
+                     sizeof(payload)));
+          break;
+        }
+        case 4: {
+          uint8_t bad[2] = {CRSF_ADDRESS_FLIGHT_CONTROLLER,
+                            (uint8_t)(rand() % 2 ? rand() % 3 : CRSF_MAX_PACKET_LEN + 1)};
+          FakeSerial::feed(bad, sizeof(bad));
+          break;
+        }
+      }
+    }
+
+    int kind = rand() % 10;
+    if (kind < 8) {
+      uint16_t ch[16];
+      randomChannels(ch);
+      feedChannels(ch);
+      sentChannelFrames++;
+    } else if (kind == 8) {
+      crsfLinkStatistics_t ls = {};
+      ls.uplink_Link_quality = rand() % 101;
+      feed(frame(CRSF_ADDRESS_FLIGHT_CONTROLLER, CRSF_FRAMETYPE_LINK_STATISTICS, &ls,
+                 sizeof(ls)));
+      sentStats++;
+    } else {
+      crsf_sensor_gps_t gps = {};
+      gps.latitude = rand();
+      gps.satellites = 9;
+      feed(frame(CRSF_ADDRESS_FLIGHT_CONTROLLER, CRSF_FRAMETYPE_GPS, &gps, sizeof(gps)));
+      sentGps++;
+    }
+
+    drain(*crsf);
+  }
+
+  uint32_t sent = sentChannelFrames + sentStats + sentGps;
+  uint32_t got = channelPackets + statsPackets + gpsPackets;
+  printf("fuzz: %u of %u valid frames delivered\n", got, sent);
+  CHECK(channelPackets <= sentChannelFrames && statsPackets <= sentStats && gpsPackets <= sentGps);
+  CHECK(got >= sent * 95 / 100);
+  delete crsf;
+}
+
+// Pure noise must never produce a frame and never wedge the ring, once the line goes quiet
+// for the packet timeout the next frame is received
+static void testNoise()
+{
+  FakeSerial::reset(32);
+  CrsfSerial *crsf = newParser();
+  for (int i = 0; i < 1000000; i++) {
+    uint8_t b = rand();
+    if (b == CRSF_ADDRESS_FLIGHT_CONTROLLER) b = 0;
+    FakeSerial::feed(&b, 1);
+    if ((i & 1023) == 0) drain(*crsf);
+  }
+  drain(*crsf);
+  CHECK(channelPackets == 0 && statsPackets == 0 && gpsPackets == 0);
+
+  hostUptimeMs += CrsfSerial::CRSF_PACKET_TIMEOUT_MS + 1;
+  crsf->loop();
+  uint16_t ch[16];
+  randomChannels(ch);
+  feedChannels(ch);
+  drain(*crsf);
+  CHECK(channelPackets == 1 && sentChannels.empty());
+  hostUptimeMs = 0;
+  delete crsf;
+}
+
+// A partial frame is dropped after the packet timeout, no channels for the failsafe time
+// takes the link down
+static void testTimeouts()
+{
+  FakeSerial::reset(32);
+  hostUptimeMs = 1000;
+  CrsfSerial *crsf = newParser();
+  uint16_t ch[16];
+  randomChannels(ch);
+  std::vector<uint8_t> f = channelFrame(ch);
+  FakeSerial::feed(f.data(), 10);
+  drain(*crsf);
+
+  hostUptimeMs += CrsfSerial::CRSF_PACKET_TIMEOUT_MS + 1;
+  crsf->loop();
+  feedChannels(ch);
+  drain(*crsf);
+  CHECK(channelPackets == 1 && sentChannels.empty());
+  CHECK(crsf->isLinkUp());
+
+  hostUptimeMs += CrsfSerial::CRSF_FAILSAFE_STAGE1_MS + 1;
+  crsf->loop();
+  CHECK(!crsf->isLinkUp() && linkDowns == 1);
+  hostUptimeMs = 0;
+  delete crsf;
+}
+
+static void testGps()
+{
+  FakeSerial::reset(32);
+  CrsfSerial *crsf = newParser();
+  crsf_sensor_gps_t gps = {};
+  gps.latitude = htobe32(-123456789);
+  gps.longitude = htobe32(987654321);
+  gps.groundspeed = htobe16(1234);
+  gps.heading = htobe16(4567);
+  gps.altitude = htobe16(1100);
+  gps.satellites = 12;
+  feed(frame(CRSF_ADDRESS_FLIGHT_CONTROLLER, CRSF_FRAMETYPE_GPS, &gps, sizeof(gps)));
+  drain(*crsf);
+  const crsf_sensor_gps_t *got = crsf->getGpsSensor();
+  CHECK(gpsPackets == 1);
+  CHECK(got->latitude == -123456789 && got->longitude == 987654321);
+  CHECK(got->groundspeed == 1234 && got->heading == 4567 && got->altitude == 1100);
+  CHECK(got->satellites == 12);
+  delete crsf;
+}
+
+static void benchmark()
+{
+  const int frames = 200000;
+  FakeSerial::reset(32);
+  CrsfSerial *crsf = newParser();
+  uint16_t ch[16];
+  randomChannels(ch);
+  std::vector<uint8_t> f = channelFrame(ch);
+  crsf->onPacketChannels = [] { channelPackets++; };
+  double ns = nsPerCall(frames, [&](int) {
+    feed(f);
+    drain(*crsf);
+  });
+  CHECK(channelPackets == (uint32_t)frames);
+  printf("CrsfSerial::loop: %.1f ns/channels frame, %.1f MB/s\n", ns, f.size() * 1e3 / ns);
+  delete crsf;
+}
+
+int main()
+{
+  srand(1);
+  testClean(1);
+  testClean(7);
+  testClean(64);
+  testFuzz();
+  testNoise();
+  testTimeouts();
+  testGps();
+  benchmark();
+  return testResult("crsfin");
+}
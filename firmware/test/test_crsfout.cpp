@@ -0,0 +1,296 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* CRSF output. The output runs against a flight controller stand in on the fake aux serial,
+ *  checking the speed proposal frame, how the FC's answers are parsed, the fall back when the
+ *  FC goes quiet and that nothing sent in a frame period overruns the line
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "CRSF/crc8.h"
+#include "CRSF/crsfout.h"
+#include "fakeserial.h"
+#include "hosttest.h"
+#include "trackersettings.h"
+
+static const float quat[4] = {0.995f, 0.0998f, 0, 0};
+
+struct Frame {
+  uint8_t type;
+  std::vector<uint8_t> bytes;
+};
+
+// Splits what the output wrote into frames, checking each CRC on the way
+static std::vector<Frame> takeWritten()
+{
+  std::vector<uint8_t> &tx = FakeSerial::written();
+  std::vector<Frame> frames;
+  size_t p = 0;
+  while (p + 2 <= tx.size()) {
+    uint8_t len = tx[p + 1];
+    CHECK(p + len + 2 <= tx.size());
+    if (p + len + 2 > tx.size()) break;
+    CHECK(CrsfCrc8::calc(&tx[p + 2], len - 1) == tx[p + len + 1]);
+    frames.push_back({tx[p + 2], std::vector<uint8_t>(&tx[p], &tx[p + len + 2])});
+    p += len + 2;
+  }
+  tx.clear();
+  return frames;
+}
+
+// The FC's answer to a speed proposal, from the FC to the receiver
+static std::vector<uint8_t> speedResponse(bool accept)
+{
+  std::vector<uint8_t> f = {CRSF_SYNC_BYTE,
+                            9,
+                            CRSF_FRAMETYPE_COMMAND,
+                            CRSF_ADDRESS_CRSF_RECEIVER,
+                            CRSF_ADDRESS_FLIGHT_CONTROLLER,
+                            CRSF_COMMAND_SUBCMD_GENERAL,
+                            CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_RESPONSE,
+                            0,
+                            accept,
+                            0,
+                            0};
+  f[9] = CrsfCmdCrc8::calc(&f[2], 7);
+  f[10] = CrsfCrc8::calc(&f[2], 8);
+  return f;
+}
+
+// Telemetry a FC sends back, anything valid will do
+static std::vector<uint8_t> fcTelemetry()
+{
+  std::vector<uint8_t> f = {CRSF_SYNC_BYTE, 4, CRSF_FRAMETYPE_BATTERY_SENSOR, 1, 2, 0};
+  f[5] = CrsfCrc8::calc(&f[2], 3);
+  return f;
+}
+
+static int64_t nowUs = 10000000;  // Only ever goes forward, like the uptime
+
+// One frame period, as uartTxFrame() sends it
+static void sendFrame(uint32_t period)
+{
+  nowUs += period;
+  hostUptimeMs = nowUs / 1000;
+  crsfout.loop();
+  crsfout.sendRCFrameToFC();
+  crsfout.negotiateSpeed(period);
+  crsfout.sendTelemetry(quat, 3.7f, period);
+}
+
+static void start(uint8_t baud)
+{
+  FakeSerial::reset(32);
+  trkset.crsfTxBaud = baud;
+  trkset.crsfTxInv = false;
+  nowUs += 1000000;
+  hostUptimeMs = nowUs / 1000;
+  crsfout.Begin();
+}
+
+static void testProposal()
+{
+  start(2);
+  CHECK(FakeSerial::baud() == 400000);
+  sendFrame(10000);
+  std::vector<Frame> frames = takeWritten();
+  CHECK(frames.size() >= 2 && frames[0].type == CRSF_FRAMETYPE_RC_CHANNELS_PACKED);
+  CHECK(frames.size() >= 2 && frames[1].type == CRSF_FRAMETYPE_COMMAND);
+  if (frames.size() < 2) return;
+
+  const std::vector<uint8_t> &f = frames[1].bytes;
+  const uint8_t expect[] = {CRSF_SYNC_BYTE,
+                            12,
+                            CRSF_FRAMETYPE_COMMAND,
+                            CRSF_ADDRESS_FLIGHT_CONTROLLER,
+                            CRSF_ADDRESS_CRSF_RECEIVER,
+                            CRSF_COMMAND_SUBCMD_GENERAL,
+                            CRSF_COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL,
+                            0,
+                            0x00,
+                            0x0F,
+                            0x42,
+                            0x40};  // 1000000 big endian
+  CHECK(f.size() == 14);
+  CHECK(memcmp(f.data(), expect, sizeof(expect)) == 0);
+  CHECK(CrsfCmdCrc8::calc(&f[2], 10) == f[12]);
+}
+
+// Noise, a reply with a bad command CRC, then an accept. Only the accept switches the rate
+static void testAccept()
+{
+  start(2);
+  sendFrame(10000);
+  takeWritten();
+
+  const uint8_t noise[] = {0x00, CRSF_SYNC_BYTE, 0xFF, 0x12};
+  FakeSerial::feed(noise, sizeof(noise));
+  std::vector<uint8_t> bad = speedResponse(true);
+  bad[9] ^= 1;
+  bad[10] = CrsfCrc8::calc(&bad[2], 8);
+  FakeSerial::feed(bad.data(), bad.size());
+  sendFrame(10000);
+  CHECK(FakeSerial::baud() == 400000);
+
+  std::vector<uint8_t> good = speedResponse(true);
+  FakeSerial::feed(good.data(), good.size());
+  sendFrame(10000);
+  CHECK(FakeSerial::baud() == 1000000);
+
+  // No more proposals once switched, and no fall back while the FC talks
+  takeWritten();
+  for (int i = 0; i < 300; i++) {
+    if (i % 10 == 0) {
+      std::vector<uint8_t> tlm = fcTelemetry();
+      FakeSerial::feed(tlm.data(), tlm.size());
+    }
+    sendFrame(10000);
+  }
+  for (const Frame &f : takeWritten()) CHECK(f.type != CRSF_FRAMETYPE_COMMAND);
+  CHECK(FakeSerial::baud() == 1000000);
+}
+
+static void testReject()
+{
+  start(1);
+  sendFrame(10000);
+  std::vector<uint8_t> no = speedResponse(false);
+  FakeSerial::feed(no.data(), no.size());
+  sendFrame(10000);
+  takeWritten();
+  for (int i = 0; i < 200; i++) sendFrame(10000);
+  for (const Frame &f : takeWritten()) CHECK(f.type != CRSF_FRAMETYPE_COMMAND);
+  CHECK(FakeSerial::baud() == 400000);
+}
+
+// Unanswered, the proposal is repeated every 200ms until the attempts run out
+static void testNoAnswer()
+{
+  start(1);
+  int proposals = 0;
+  for (int i = 0; i < 500; i++) {
+    sendFrame(10000);
+    for (const Frame &f : takeWritten()) proposals += f.type == CRSF_FRAMETYPE_COMMAND;
+  }
+  CHECK(proposals == 10);
+  CHECK(FakeSerial::baud() == 400000);
+}
+
+/* 26 bytes of RC frame and 14 of proposal don't fit in the 36 a 1kHz period carries at
+ *  400000 baud, so the proposal waits. At 500Hz there's room
+ */
+static void testProposalBudget()
+{
+  start(2);
+  for (int i = 0; i < 1000; i++) sendFrame(1000);
+  for (const Frame &f : takeWritten()) CHECK(f.type != CRSF_FRAMETYPE_COMMAND);
+
+  start(2);
+  int proposals = 0;
+  for (int i = 0; i < 10; i++) sendFrame(2000);
+  for (const Frame &f : takeWritten()) proposals += f.type == CRSF_FRAMETYPE_COMMAND;
+  CHECK(proposals == 1);
+}
+
+// The FC restarts at its default rate and goes quiet at the faster one. The output drops back
+// to 400000 and proposes again
+static void testFallback()
+{
+  start(2);
+  sendFrame(10000);
+  std::vector<uint8_t> yes = speedResponse(true);
+  FakeSerial::feed(yes.data(), yes.size());
+  sendFrame(10000);
+  CHECK(FakeSerial::baud() == 1000000);
+  int opens = FakeSerial::opens();
+
+  // Quiet for just under the timeout, no change
+  for (int i = 0; i < 140; i++) sendFrame(10000);
+  CHECK(FakeSerial::baud() == 1000000 && FakeSerial::opens() == opens);
+
+  takeWritten();
+  for (int i = 0; i < 20; i++) sendFrame(10000);
+  CHECK(FakeSerial::baud() == 400000);
+  int proposals = 0;
+  for (const Frame &f : takeWritten()) proposals += f.type == CRSF_FRAMETYPE_COMMAND;
+  CHECK(proposals >= 1);
+
+  // Accepted again
+  FakeSerial::feed(yes.data(), yes.size());
+  sendFrame(10000);
+  CHECK(FakeSerial::baud() == 1000000);
+}
+
+// Everything sent in a period fits in what the line carries, telemetry goes at its rates when
+// there's room and the RC rate is never reduced
+static void testTelemetryBudget(uint32_t rate, uint8_t baud, uint32_t baudrate)
+{
+  start(baud);
+  if (baud) {
+    sendFrame(1000000 / rate);
+    std::vector<uint8_t> yes = speedResponse(true);
+    FakeSerial::feed(yes.data(), yes.size());
+    sendFrame(1000000 / rate);
+    CHECK(FakeSerial::baud() == baudrate);
+    takeWritten();
+  }
+
+  uint32_t period = 1000000 / rate;
+  uint32_t capacity = (uint64_t)baudrate * period / 10000000 * 9 / 10;
+  std::map<uint8_t, int> count;
+  size_t most = 0;
+  for (uint32_t i = 0; i < rate * 2; i++) {
+    if (i % 20 == 0) {
+      std::vector<uint8_t> tlm = fcTelemetry();
+      FakeSerial::feed(tlm.data(), tlm.size());
+    }
+    sendFrame(period);
+    size_t bytes = FakeSerial::written().size();
+    most = std::max(most, bytes);
+    CHECK(bytes <= capacity);
+    for (const Frame &f : takeWritten()) count[f.type]++;
+  }
+  printf("%4uHz %7u baud: RC %d link %d attitude %d battery %d, most %zu of %u bytes/period\n",
+         rate, baudrate, count[CRSF_FRAMETYPE_RC_CHANNELS_PACKED],
+         count[CRSF_FRAMETYPE_LINK_STATISTICS], count[CRSF_FRAMETYPE_ATTITUDE],
+         count[CRSF_FRAMETYPE_BATTERY_SENSOR], most, capacity);
+  CHECK(count[CRSF_FRAMETYPE_RC_CHANNELS_PACKED] == (int)rate * 2);
+  CHECK(FakeSerial::baud() == baudrate);
+}
+
+int main()
+{
+  testProposal();
+  testAccept();
+  testReject();
+  testNoAnswer();
+  testProposalBudget();
+  testFallback();
+  testTelemetryBudget(150, 0, 400000);
+  testTelemetryBudget(500, 0, 400000);
+  testTelemetryBudget(1000, 0, 400000);
+  testTelemetryBudget(1000, 2, 1000000);
+  return testResult("crsfout");
+}
@@ -0,0 +1,146 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* One Euro filter bank against the original C filter in reference/, which the firmware used
+ *  one instance per channel before the bank. Same settings as the analog channels in
+ *  sense.cpp, noisy signals with steps so both the slow and the fast cutoff are exercised.
+ *  Then the time for all channels of a cycle each way
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "filters/SF1eFilterBank.h"
+#include "hosttest.h"
+#include "reference/SF1eFilter.h"
+
+// sense.cpp, the analog channels and the battery voltage
+#define CHANNELS 5
+#define FREQ 150
+#define MINCO 0.02f
+#define SLOPE 6
+#define DERCO 1
+
+static float signal(int n, int channel)
+{
+  float x = sinf(n * 0.01f * (channel + 1)) + (rand() % 100) / 500.0f;
+  if ((n / 700) % 2) x += 2.0f * channel;  // Steps
+  return x;
+}
+
+// Worst difference to the reference, relative to the signal size
+static float compare(SF1eFilterBank<CHANNELS> &bank, SF1eFilter *ref[CHANNELS], int samples,
+                     uint32_t mask)
+{
+  float worst = 0;
+  float x[CHANNELS], y[CHANNELS];
+  for (int n = 0; n < samples; n++) {
+    for (int i = 0; i < CHANNELS; i++) x[i] = signal(n, i);
+    bank.process(x, y, mask);
+    for (int i = 0; i < CHANNELS; i++) {
+      if (!(mask & (1UL << i))) continue;
+      float r = SF1eFilterDo(ref[i], x[i]);
+      worst = fmaxf(worst, fabsf(r - y[i]) / fmaxf(1.0f, fabsf(r)));
+    }
+  }
+  return worst;
+}
+
+static void newReference(SF1eFilter *ref[CHANNELS])
+{
+  for (int i = 0; i < CHANNELS; i++) {
+    ref[i] = SF1eFilterCreate(FREQ, MINCO, SLOPE, DERCO);
+    SF1eFilterInit(ref[i]);
+  }
+}
+
+static void freeReference(SF1eFilter *ref[CHANNELS])
+{
+  for (int i = 0; i < CHANNELS; i++) SF1eFilterDestroy(ref[i]);
+}
+
+static void testMatches()
+{
+  static SF1eFilterBank<CHANNELS> bank;
+  SF1eFilter *ref[CHANNELS];
+  bank.configure(FREQ, MINCO, SLOPE, DERCO);
+  newReference(ref);
+  float worst = compare(bank, ref, 100000, bank.ALL);
+  printf("all channels: worst relative difference %g\n", worst);
+  CHECK(worst < 1e-5f);
+  freeReference(ref);
+}
+
+// Channels left out of the mask keep their state, a reset channel starts over from its next
+// input like a new filter
+static void testMaskAndReset()
+{
+  static SF1eFilterBank<CHANNELS> bank;
+  SF1eFilter *ref[CHANNELS];
+  bank.configure(FREQ, MINCO, SLOPE, DERCO);
+  newReference(ref);
+
+  CHECK(compare(bank, ref, 1000, 0x15) < 1e-5f);
+  CHECK(compare(bank, ref, 1000, 0x0A) < 1e-5f);
+
+  bank.reset(0x04);
+  SF1eFilterDestroy(ref[2]);
+  ref[2] = SF1eFilterCreate(FREQ, MINCO, SLOPE, DERCO);
+  SF1eFilterInit(ref[2]);
+  CHECK(compare(bank, ref, 1000, bank.ALL) < 1e-5f);
+
+  // Single channel calls
+  float worst = 0;
+  for (int n = 0; n < 1000; n++) {
+    float x = signal(n, 3);
+    worst = fmaxf(worst, fabsf(bank.process(3, x) - SF1eFilterDo(ref[3], x)));
+  }
+  CHECK(worst < 1e-4f);
+  freeReference(ref);
+}
+
+static void benchmark()
+{
+  static SF1eFilterBank<CHANNELS> bank;
+  SF1eFilter *ref[CHANNELS];
+  bank.configure(FREQ, MINCO, SLOPE, DERCO);
+  newReference(ref);
+
+  const int cycles = 2000000;
+  float x[CHANNELS], y[CHANNELS];
+  volatile float sink = 0;
+  double bankNs = nsPerCall(cycles, [&](int n) {
+    for (int i = 0; i < CHANNELS; i++) x[i] = (n & 63) * 0.01f + i;
+    bank.process(x, y);
+    sink = sink + y[0];
+  });
+  double refNs = nsPerCall(cycles, [&](int n) {
+    for (int i = 0; i < CHANNELS; i++) sink = sink + SF1eFilterDo(ref[i], (n & 63) * 0.01f + i);
+  });
+  printf("%d channels: bank %.1f ns/cycle, SF1eFilterDo %.1f ns/cycle\n", CHANNELS, bankNs,
+         refNs);
+  freeReference(ref);
+}
+
+int main()
+{
+  srand(1);
+  testMatches();
+  testMaskAndReset();
+  benchmark();
+  return testResult("filterbank");
+}
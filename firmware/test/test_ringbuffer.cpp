@@ -0,0 +1,160 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Lock free ring. Wrapping and full/empty edges single threaded, then a producer and a
+ *  consumer thread streaming a counting pattern through every claim/commit, write,
+ *  peek/consume, read, push and pop path. Any lost, repeated or torn element breaks the
+ *  count. Build with -DSANITIZE=thread to have TSan watch the same run
+ */
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "hosttest.h"
+#include "ringbuffer.h"
+
+static void testEdges()
+{
+  ringbuffer<uint8_t, 16> rb;
+  uint8_t *span;
+  CHECK(rb.getOccupied() == 0 && rb.getFree() == 16);
+  CHECK(rb.peek(span) == 0);
+
+  // A full ring holds all N
+  for (int i = 0; i < 16; i++) CHECK(rb.push(i));
+  CHECK(!rb.push(99));
+  CHECK(rb.getFree() == 0 && rb.claim(span) == 0);
+
+  // Spans stop at the end of the storage
+  uint8_t out[16];
+  CHECK(rb.read(out, 10) == 10);
+  CHECK(rb.claim(span) == 10);
+  uint8_t in[8] = {16, 17, 18, 19, 20, 21, 22, 23};
+  CHECK(rb.write(in, 8) == 8);
+  CHECK(rb.peek(span) == 6 && span[0] == 10);
+  rb.consume(6);
+  CHECK(rb.peek(span) == 8 && span[0] == 16);
+  CHECK(rb.read(out, 16) == 8 && out[7] == 23);
+  CHECK(rb.getOccupied() == 0);
+
+  // write() and read() split across the end themselves
+  for (int lap = 0; lap < 100; lap++) {
+    uint8_t data[13];
+    for (int i = 0; i < 13; i++) data[i] = lap + i;
+    CHECK(rb.write(data, 13) == 13);
+    CHECK(rb.read(out, 16) == 13);
+    CHECK(memcmp(out, data, 13) == 0);
+  }
+}
+
+static void testStreams()
+{
+  static ringbuffer<uint8_t, 512> rb;
+  const uint32_t total = 50000000;
+  std::atomic<bool> bad{false};
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread producer([&] {
+    std::mt19937 r(1);
+    uint8_t chunk[64];
+    uint32_t v = 0;
+    while (v < total) {
+      size_t n;
+      if (r() & 1) {
+        uint8_t *span;
+        n = std::min<size_t>({rb.claim(span), 1 + r() % 40, total - v});
+        for (size_t i = 0; i < n; i++) span[i] = v + i;
+        rb.commit(n);
+      } else {
+        size_t len = std::min<size_t>(1 + r() % 64, total - v);
+        for (size_t i = 0; i < len; i++) chunk[i] = v + i;
+        n = rb.write(chunk, len);
+      }
+      v += n;
+      if (n == 0) std::this_thread::yield();
+    }
+  });
+  std::thread consumer([&] {
+    std::mt19937 r(2);
+    uint8_t chunk[64];
+    uint32_t v = 0;
+    while (v < total) {
+      size_t n;
+      if (r() & 1) {
+        uint8_t *span;
+        n = std::min<size_t>(rb.peek(span), 1 + r() % 50);
+        for (size_t i = 0; i < n; i++)
+          if (span[i] != (uint8_t)(v + i)) bad = true;
+        rb.consume(n);
+      } else {
+        n = rb.read(chunk, 1 + r() % 64);
+        for (size_t i = 0; i < n; i++)
+          if (chunk[i] != (uint8_t)(v + i)) bad = true;
+      }
+      v += n;
+      if (n == 0) std::this_thread::yield();
+    }
+  });
+  producer.join();
+  consumer.join();
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  CHECK(!bad);
+  CHECK(rb.getOccupied() == 0);
+  printf("spans: %u bytes across threads, %.0f MB/s\n", total, total / s / 1e6);
+
+  // Elements wider than a byte one at a time, a torn element shows up as a wrong value
+  static ringbuffer<uint32_t, 64> rp;
+  const uint32_t count = 5000000;
+  start = std::chrono::steady_clock::now();
+  std::thread pusher([&] {
+    for (uint32_t v = 0; v < count;) {
+      if (rp.push(v * 0x01010101u))
+        v++;
+      else
+        std::this_thread::yield();
+    }
+  });
+  std::thread popper([&] {
+    uint32_t x;
+    for (uint32_t v = 0; v < count;) {
+      if (rp.pop(x)) {
+        if (x != v * 0x01010101u) bad = true;
+        v++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  pusher.join();
+  popper.join();
+  s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  CHECK(!bad);
+  CHECK(rp.getOccupied() == 0);
+  printf("push/pop: %u elements across threads, %.0f ns each\n", count, s * 1e9 / count);
+}
+
+int main()
+{
+  testEdges();
+  testStreams();
+  return testResult("ringbuffer");
+}
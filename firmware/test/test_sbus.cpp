@@ -0,0 +1,194 @@
+/*
+ * This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+ * Copyright (c) 2022 Cliff Blackburn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* SBUS span parser. Frames built by SbusWriteChannels() are fed back through the fake aux
+ *  serial in random sized pieces, with and without line noise between them
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "SBUS/sbus.h"
+#include "chcodec.h"
+#include "fakeserial.h"
+#include "hosttest.h"
+#include "uart_mode.h"
+
+extern uint8_t localTXBuffer[25];
+
+// The float scaling sbus.cpp used before the lookup table
+static uint16_t floatSbusToUs(uint16_t ch)
+{
+  int us = (uint16_t)(((float)ch - 992) / 1.6f + 1500);
+  return us < 988 ? 988 : (us > 2012 ? 2012 : us);
+}
+
+static void randomChannels(uint16_t ch[16])
+{
+  for (int i = 0; i < 16; i++) ch[i] = rand() & 0x7FF;
+}
+
+static bool matches(const uint16_t sent[16], const uint16_t got[16])
+{
+  for (int i = 0; i < 16; i++)
+    if (got[i] != floatSbusToUs(sent[i])) return false;
+  return true;
+}
+
+static void testScaling()
+{
+  for (int i = 0; i < 2048; i++) CHECK(ChCodec::SbusToUs::map(i) == floatSbusToUs(i));
+}
+
+static void testChunked(size_t maxChunk)
+{
+  FakeSerial::reset(maxChunk);
+  int received = 0;
+  for (int t = 0; t < 2000; t++) {
+    uint16_t ch[16], out[16];
+    randomChannels(ch);
+    SbusWriteChannels(ch);
+    FakeSerial::feed(localTXBuffer, sizeof(localTXBuffer));
+    while (FakeSerial::pending()) {
+      if (SbusReadChannels(out)) {
+        CHECK(matches(ch, out));
+        received++;
+      }
+    }
+  }
+  CHECK(received == 2000);
+}
+
+// Noise without a header byte can't start a false frame, every frame must still be found
+static void testNoise()
+{
+  FakeSerial::reset(7);
+  int received = 0;
+  for (int t = 0; t < 2000; t++) {
+    uint16_t ch[16], out[16];
+    randomChannels(ch);
+    SbusWriteChannels(ch);
+    int noise = rand() % 40;
+    for (int i = 0; i < noise; i++) {
+      uint8_t b = rand();
+      if (b == 0x0F) b = 0x55;
+      FakeSerial::feed(&b, 1);
+    }
+    uint8_t footer = 0x00;
+    FakeSerial::feed(&footer, 1);
+    FakeSerial::feed(localTXBuffer, sizeof(localTXBuffer));
+    bool got = false;
+    while (FakeSerial::pending()) {
+      if (SbusReadChannels(out)) {
+        CHECK(matches(ch, out));
+        got = true;
+      }
+    }
+    received += got;
+  }
+  CHECK(received == 2000);
+}
+
+// Several frames in one read, the most recent is returned and all are counted
+static void testBacklog()
+{
+  FakeSerial::reset(64);
+  uint16_t ch[16], out[16];
+  for (int i = 0; i < 3; i++) {
+    randomChannels(ch);
+    SbusWriteChannels(ch);
+    FakeSerial::feed(localTXBuffer, sizeof(localTXBuffer));
+  }
+  uint32_t before = PacketCount;
+  bool got = false;
+  while (FakeSerial::pending()) got |= SbusReadChannels(out);
+  CHECK(got);
+  CHECK(matches(ch, out));
+  CHECK(PacketCount - before == 3);
+}
+
+// Footer 0x00 or any xxxx0100 ends a frame, anything else drops it
+static void testFooters()
+{
+  uint16_t ch[16], out[16];
+  const uint8_t footers[] = {0x00, 0x04, 0x14, 0x24, 0x34};
+  for (uint8_t footer : footers) {
+    FakeSerial::reset(32);
+    randomChannels(ch);
+    SbusWriteChannels(ch);
+    uint8_t frame[25];
+    memcpy(frame, localTXBuffer, sizeof(frame));
+    frame[24] = footer;
+    FakeSerial::feed(frame, sizeof(frame));
+    bool got = false;
+    while (FakeSerial::pending()) got |= SbusReadChannels(out);
+    CHECK(got && matches(ch, out));
+  }
+
+  FakeSerial::reset(32);
+  randomChannels(ch);
+  SbusWriteChannels(ch);
+  uint8_t frame[25];
+  memcpy(frame, localTXBuffer, sizeof(frame));
+  frame[24] = 0x55;
+  FakeSerial::feed(frame, sizeof(frame));
+  bool got = false;
+  while (FakeSerial::pending()) got |= SbusReadChannels(out);
+  CHECK(!got);
+
+  // The bad footer isn't a footer, the next frame needs one ahead of it to sync
+  uint8_t footer = 0x00;
+  FakeSerial::feed(&footer, 1);
+  SbusWriteChannels(ch);
+  FakeSerial::feed(localTXBuffer, sizeof(localTXBuffer));
+  while (FakeSerial::pending()) got |= SbusReadChannels(out);
+  CHECK(got && matches(ch, out));
+}
+
+static void benchmark()
+{
+  const int frames = 200000;
+  uint16_t ch[16], out[16];
+  randomChannels(ch);
+  SbusWriteChannels(ch);
+  FakeSerial::reset(32);
+  double ns = nsPerCall(frames, [&](int) {
+    FakeSerial::feed(localTXBuffer, sizeof(localTXBuffer));
+    while (FakeSerial::pending()) SbusReadChannels(out);
+  });
+  printf("SbusReadChannels: %.1f ns/frame, 32 byte reads\n", ns);
+
+  ns = nsPerCall(frames, [&](int i) {
+    ch[i & 15] = i & 0x7FF;
+    SbusWriteChannels(ch);
+  });
+  printf("SbusWriteChannels: %.1f ns/frame\n", ns);
+}
+
+int main()
+{
+  srand(1);
+  testScaling();
+  testChunked(1);
+  testChunked(5);
+  testChunked(32);
+  testNoise();
+  testBacklog();
+  testFooters();
+  benchmark();
+  return testResult("sbus");
+}
@@ -2,7 +2,7 @@ QT       += core gui svg serialport network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets opengl openglwidgets
 
-CONFIG += c++11 file_copies
+CONFIG += c++17 file_copies
 
 # The following define makes your compiler emit warnings if you use
 # any Qt feature that has been marked deprecated (the exact warnings
@@ -38,6 +38,7 @@ SOURCES += \
     main.cpp \
     mainwindow.cpp \
     led.cpp \
+    logdictionary.cpp \
     graph.cpp \
     popupslider.cpp \
     servominmax.cpp \
@@ -59,6 +60,7 @@ HEADERS += \
     magcalwidget.h \
     mainwindow.h \
     led.h \
+    logdictionary.h \
     graph.h \
     popupslider.h \
     servominmax.h \
@@ -95,6 +95,7 @@ public:
     _setting["pwm1"] = -1;
     _setting["pwm2"] = -1;
     _setting["pwm3"] = -1;
+    _setting["pwmrate"] = 50;
     _setting["an0ch"] = -1;
     _setting["an1ch"] = -1;
     _setting["an2ch"] = -1;
@@ -143,6 +144,7 @@ public:
     _setting["sbininv"] = true;
     _setting["sboutinv"] = true;
     _setting["crsftxinv"] = false;
+    _setting["crsftxbaud"] = 0;
     _setting["ch5arm"] = false;
     _setting["btmode"] = 0;
     _setting["rstonwave"] = false;
@@ -157,6 +159,7 @@ public:
     _setting["ppmframe"] = 22500;
     _setting["ppmsync"] = 350;
     _setting["ppmchcnt"] = 8;
+    _setting["databudget"] = 12000;
     _setting["btpairedaddress"] = QString("");
     _dataItems["magx"] = false;
     _dataItems["magy"] = false;
@@ -189,6 +192,9 @@ public:
     _dataItems["rolloff"] = false;
     _dataItems["panoff"] = false;
     _dataItems["gyrocal"] = false;
+    _dataItems["uarttxrate"] = false;
+    _dataItems["uarttxjit"] = false;
+    _dataItems["uarttxage"] = false;
     descriptions["rll_min"] = tr("Roll Minimum");
     descriptions["rll_max"] = tr("Roll Maximum");
     descriptions["rll_cnt"] = tr("Roll Center");
@@ -209,6 +215,7 @@ public:
     descriptions["pwm1"] = tr("PWM 1 Channel");
     descriptions["pwm2"] = tr("PWM 2 Channel");
     descriptions["pwm3"] = tr("PWM 3 Channel");
+    descriptions["pwmrate"] = tr("PWM Refresh Rate (Hz)");
     descriptions["an0ch"] = tr("Analog 0 Channel");
     descriptions["an1ch"] = tr("Analog 1 Channel");
     descriptions["an2ch"] = tr("Analog 2 Channel");
@@ -257,6 +264,7 @@ public:
     descriptions["sbininv"] = tr("SBUS Receieve Inverted");
     descriptions["sboutinv"] = tr("SBUS Transmit Inverted");
     descriptions["crsftxinv"] = tr("Invert CRSF output");
+    descriptions["crsftxbaud"] = tr("CRSF Output Baud Rate (0=400000 1=921600 2=1000000)");
     descriptions["ch5arm"] = tr("Set channel 5 to 2000us");
     descriptions["btmode"] = tr("Bluetooth Mode (-1=Uninit, 0-Disable, 1-Head, 2-Receive, 3-Scanner, 4-Gamepad)");
     descriptions["rstonwave"] = tr("Reset on Proximity Sense");
@@ -271,6 +279,7 @@ public:
     descriptions["ppmframe"] = tr("PPM Frame Length (us)");
     descriptions["ppmsync"] = tr("PPM Sync Pulse Length (us)");
     descriptions["ppmchcnt"] = tr("PPM channels to output");
+    descriptions["databudget"] = tr("GUI Data Bandwidth (bytes/s)");
     descriptions["magx"] = tr("Raw Sensor Mag X(uT)");
     descriptions["magy"] = tr("Raw Sensor Mag Y(uT)");
     descriptions["magz"] = tr("Raw Sensor Mag Z(uT)");
@@ -302,6 +311,9 @@ public:
     descriptions["rolloff"] = tr("Offset Roll in Degrees");
     descriptions["panoff"] = tr("Offset Pan in Degrees");
     descriptions["gyrocal"] = tr("Gyro Has Been Calibrated");
+    descriptions["uarttxrate"] = tr("Uart Output Frame Rate (Hz)");
+    descriptions["uarttxjit"] = tr("Uart Output Frame Jitter (us)");
+    descriptions["uarttxage"] = tr("Uart Output Channel Age (us)");
     descriptions["btpairedaddress"] = tr("Bluetooth Remote address to Pair With");
     descriptions["chout"] = tr("Channel Outputs");
     descriptions["btch"] = tr("Bluetooth Inputs");
@@ -563,6 +575,18 @@ public:
     return false;
   }
 
+  // PWM Refresh Rate (Hz)
+  uint16_t getPwmRate() {
+    return _setting["pwmrate"].toUInt();
+  }
+  bool setPwmRate(uint16_t val=50) {
+    if(val >= 31 && val <= 400) {
+      _setting["pwmrate"] = val;
+      return true;
+    }
+    return false;
+  }
+
   // Analog 0 Channel
   int8_t getAn0Ch() {
     return _setting["an0ch"].toInt();
@@ -1088,7 +1112,7 @@ public:
   }
 
 
-  // Uart Mode (0- Off, 1-SBUS, 2-CRSFIN, 3-CRSFOUT)
+  // Uart Mode (0-Off, 1-SBUS, 2-CRSFIN, 3-CRSFOUT)
   uint8_t getUartMode() {
     return _setting["uartmode"].toUInt();
   }
@@ -1101,11 +1125,11 @@ public:
   }
 
   // CRSF Transmit Frequncy
-  uint8_t getCrsfTxRate() {
+  uint16_t getCrsfTxRate() {
     return _setting["crsftxrate"].toUInt();
   }
-  bool setCrsfTxRate(uint8_t val=140) {
-    if(val >= 30 && val <= 140) {
+  bool setCrsfTxRate(uint16_t val=140) {
+    if(val >= 30 && val <= 1000) {
       _setting["crsftxrate"] = val;
       return true;
     }
@@ -1136,6 +1160,18 @@ public:
   bool getCrsfTxInv() {return _setting["crsftxinv"].toBool();}
   void setCrsfTxInv(bool val=false) { _setting["crsftxinv"] = val; }
 
+  // CRSF Output Baud Rate (0=400000 1=921600 2=1000000)
+  uint8_t getCrsfTxBaud() {
+    return _setting["crsftxbaud"].toUInt();
+  }
+  bool setCrsfTxBaud(uint8_t val=0) {
+    if(val <= 2) {
+      _setting["crsftxbaud"] = val;
+      return true;
+    }
+    return false;
+  }
+
   // Set channel 5 to 2000us
   bool getCh5Arm() {return _setting["ch5arm"].toBool();}
   void setCh5Arm(bool val=false) { _setting["ch5arm"] = val; }
@@ -1251,6 +1287,18 @@ public:
     return false;
   }
 
+  // GUI Data Bandwidth (bytes/s)
+  uint16_t getDataBudget() {
+    return _setting["databudget"].toUInt();
+  }
+  bool setDataBudget(uint16_t val=12000) {
+    if(val >= 1000 && val <= 60000) {
+      _setting["databudget"] = val;
+      return true;
+    }
+    return false;
+  }
+
   // Bluetooth Remote address to Pair With
   QString getBtPairedAddress() {
     return _setting["btpairedaddress"].toString();
@@ -1352,6 +1400,15 @@ public:
   // Gyro Has Been Calibrated
   bool getDataGyroCal() { return _data["gyrocal"].toBool(); }
 
+  // Uart Output Frame Rate (Hz)
+  uint16_t getDataUartTxRate() { return _data["uarttxrate"].toUInt(); }
+
+  // Uart Output Frame Jitter (us)
+  uint16_t getDataUartTxJit() { return _data["uarttxjit"].toUInt(); }
+
+  // Uart Output Channel Age (us)
+  uint16_t getDataUartTxAge() { return _data["uarttxage"].toUInt(); }
+
   // Local Bluetooth Address
   QString getDataBtAddr() { return _data["btaddr"].toString(); }
 
@@ -1391,6 +1448,9 @@ public:
     rv.append("rolloff");
     rv.append("panoff");
     rv.append("gyrocal");
+    rv.append("uarttxrate");
+    rv.append("uarttxjit");
+    rv.append("uarttxage");
     rv.append("chout[0]");
     rv.append("chout[1]");
     rv.append("chout[2]");
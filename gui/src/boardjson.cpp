@@ -1,9 +1,8 @@
 #include "boardjson.h"
 #include "ucrc16lib.h"
-
-#ifndef WINDOWS
-#define Sleep(x) sleep(x)
-#endif
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <cstring>
 
 BoardJson::BoardJson(TrackerSettings *ts)
 {
@@ -12,6 +11,8 @@ BoardJson::BoardJson(TrackerSettings *ts)
     bleCalibratorDialog = new CalibrateBLE(trkset);
 
     connect(&imheretimout,SIGNAL(timeout()),this,SLOT(ihTimeout()));
+    connect(&acknaktimer,SIGNAL(timeout()),this,SLOT(ackNakTimeout()));
+    acknaktimer.setSingleShot(true);
     connect(&rxParamsTimer,SIGNAL(timeout()),this,SLOT(rxParamsTimeout()));
     connect(&rxFeaturesTimer,SIGNAL(timeout()),this,SLOT(rxFeaturesTimeout()));
     rxParamsTimer.setSingleShot(true);
@@ -30,11 +31,18 @@ BoardJson::BoardJson(TrackerSettings *ts)
     savedToRAM=true;
     paramTXErrorSent=false;
     paramRXErrorSent=false;
-    jsonwaitingack =0;
     rxparamfaults=0;
     featuresTXErrorSent=false;
     featuresRXErrorSent=false;
     rxfeaturesfaults=0;
+    settingsgenvalid=false;
+    settingsgen=0;
+    settingsgenid=0;
+    logdictionarytried=false;
+    rawseqvalid=false;
+    rawseq=0;
+    rawdrops=0;
+    resetSequence();
 }
 
 BoardJson::~BoardJson()
@@ -59,20 +67,17 @@ void BoardJson::dataIn(QByteArray &data)
         //}
 
         //  Found the acknowldege Character, data was received without error
+        //  Followed by the hex sequence number, older firmware sends none
     } else if(data.left(1)[0] == (char)0x06) {
-        // Clear the fault counter
-        jsonwaitingack = 0;
-
-        // If more data in queue, send it and wait for another ack char.
-        if(!jsonqueue.isEmpty()) {
-            serialDataOut += jsonqueue.dequeue();
-            jsonwaitingack = 1;
-            emit serialTxReady();            
-        }
+        bool ok;
+        int seq = data.mid(1,2).toInt(&ok,16);
+        ackReceived(ok ? seq : -1);
 
-        // Found a not-acknowldege character, resend data
+        // Found a not-acknowldege character, resend from the sequence number
     } else if(data.left(1)[0] == (char)0x15) {
-        nakError();
+        bool ok;
+        int seq = data.mid(1,2).toInt(&ok,16);
+        nakReceived(ok ? seq : -1);
 
         // Other data sent, show the user
     } else if(data.left(1)[0] == (char)0x01 && data.right(1)[0] == (char)0x03) { // Log information
@@ -81,6 +86,21 @@ void BoardJson::dataIn(QByteArray &data)
         if(logd.length()) {
             emit addToLog(logd + "\n");
         }
+
+        // Binary dictionary log message
+    } else if(data.left(1)[0] == (char)0x10 && data.right(1)[0] == (char)0x03) {
+        if(!logdictionarytried) {
+            logdictionarytried = true;
+            QString dictfile = QCoreApplication::applicationDirPath() + "/log_dictionary.json";
+            if(!logdictionary.load(dictfile))
+                emit addToLog("Unable to load " + dictfile + ", binary log messages can't be decoded\n");
+        }
+        if(logdictionary.isLoaded())
+            emit addToLog(logdictionary.decode(unescapeLog(data.mid(1,data.length()-2))) + "\n");
+
+        // Binary raw sensor samples, every sensor read while calibrating
+    } else if(data.left(1)[0] == (char)0x11 && data.right(1)[0] == (char)0x03) {
+        parseRawSamples(unescapeLog(data.mid(1,data.length()-2)));
     }
 
 }
@@ -155,7 +175,13 @@ void BoardJson::requestParameters()
         return;
     }
 
-    sendSerialJSON("Get"); // Get the Settings
+    // Only ask for settings changed since the last ones received
+    QVariantMap map;
+    if(settingsgenvalid) {
+        map["Since"] = settingsgen + 1;
+        map["GenId"] = settingsgenid;
+    }
+    sendSerialJSON("Get", map); // Get the Settings
 
     rxParamsTimer.stop();
     rxParamsTimer.start(800); // Start a timer, if we haven't got them, try again
@@ -252,7 +278,12 @@ void BoardJson::changeDataItems()
     QMapIterator<QString, bool> i(toChange);
     while (i.hasNext()) {
         i.next();
-        di[i.key()] = i.value();
+        // Items with a requested rate send it in Hz instead of true
+        int rate = trkset->dataItemRate(i.key());
+        if(i.value() && rate > 0)
+            di[i.key()] = rate;
+        else
+            di[i.key()] = i.value();
     }
     sendSerialJSON("RD",di);
 
@@ -260,6 +291,49 @@ void BoardJson::changeDataItems()
     trkset->setDataItemsMatched();
 }
 
+// Each sample goes to the calibration the same way a live data update would
+void BoardJson::parseRawSamples(const QByteArray &data)
+{
+    if(data.size() < 1)
+        return;
+    int count = (quint8)data[0];
+    if(data.size() != 1 + count * (int)sizeof(RawSample)) {
+        qDebug() << "Invalid raw sample frame" << data.size();
+        return;
+    }
+
+    for(int i=0; i < count; i++) {
+        RawSample sample;
+        memcpy(&sample, data.constData() + 1 + i * sizeof(RawSample), sizeof(RawSample));
+
+        // Gaps in the sequence are samples the board couldn't send
+        if(rawseqvalid && sample.seq != rawseq) {
+            rawdrops += (quint16)(sample.seq - rawseq);
+            qDebug() << "Raw samples dropped" << rawdrops;
+        }
+        rawseq = sample.seq + 1;
+        rawseqvalid = true;
+
+        QVariantMap cmap;
+        if(sample.valid & RAW_ACC_VALID) {
+            cmap["accx"] = sample.acc[0];
+            cmap["accy"] = sample.acc[1];
+            cmap["accz"] = sample.acc[2];
+        }
+        if(sample.valid & RAW_MAG_VALID) {
+            cmap["magx"] = sample.mag[0];
+            cmap["magy"] = sample.mag[1];
+            cmap["magz"] = sample.mag[2];
+        }
+        if(sample.valid & RAW_GYR_VALID) {
+            cmap["gyrox"] = sample.gyr[0];
+            cmap["gyroy"] = sample.gyr[1];
+            cmap["gyroz"] = sample.gyr[2];
+        }
+        trkset->setLiveDataMap(cmap);
+    }
+}
+
 void BoardJson::startCalibration()
 {
     // Save a list if the currently sending data items
@@ -270,6 +344,17 @@ void BoardJson::startCalibration()
     trkset->clearDataItems();
     stopData();
 
+    // Newer boards send every raw sensor read in binary, stopped again by D--
+    if(_features.contains("RAWSTREAM")) {
+        QVariantMap en;
+        en["En"] = true;
+        rawseqvalid = false;
+        rawdrops = 0;
+        sendSerialJSON("RawS", en);
+        bleCalibratorDialog->show();
+        return;
+    }
+
     // Request just calibration items
     QMap<QString, bool> dat;
     dat["magx"] = true;
@@ -279,13 +364,17 @@ void BoardJson::startCalibration()
     dat["accy"] = true;
     dat["accz"] = true;
     trkset->setDataItemSend(dat);
+    QMapIterator<QString, bool> i(dat);
+    while (i.hasNext()) {
+        i.next();
+        trkset->setDataItemRate(i.key(), CALIBRATION_RATE);
+    }
     bleCalibratorDialog->show();
 }
 
 void BoardJson::startData()
 {
-    jsonqueue.clear();
-    jsonwaitingack = 0;
+    resetSequence();
 }
 
 void BoardJson::stopData()
@@ -302,10 +391,8 @@ void BoardJson::disconnected()
     savedToRAM=true;
     paramTXErrorSent=false;
     paramRXErrorSent=false;
-    jsonwaitingack =0;
     rxparamfaults=0;
-    jsonqueue.clear();
-    lastjson.clear();
+    resetSequence();
     imheretimout.stop();
     updatesettingstmr.stop();    
     rxParamsTimer.stop();
@@ -319,51 +406,148 @@ void BoardJson::resetCenter()
 
 void BoardJson::sendSerialJSON(QString command, QVariantMap map)
 {
-    // Don't send any new data until last has been received successfully
     map.remove("Hard");
     map.remove("Vers");
 
     QJsonObject jobj = QJsonObject::fromVariantMap(map);
     jobj["Cmd"] = command;
-    QJsonDocument jdoc(jobj);
-    QString json = QJsonDocument(jdoc).toJson(QJsonDocument::Compact);
 
-    // Calculate the CRC Checksum
-    uint16_t CRC = escapeCRC(uCRC16Lib::calculate(json.toUtf8().data(),json.length()));
+    // Frames go out once there is room in the send window
+    jsonqueue.enqueue(jobj);
+    sendQueuedJSON();
+}
 
-    lastjson = (char)0x02 + json.toLatin1() + QByteArray::fromRawData((char*)&CRC,2) + (char)0x03 + "\r\n";
-    //qDebug() << "JSONout" << lastjson;
+// Sends queued JSON until TX_WINDOW frames are waiting for an ack
+void BoardJson::sendQueuedJSON()
+{
+    bool sent = false;
+    while(!jsonqueue.isEmpty() && txunacked.size() < TX_WINDOW) {
+        QJsonObject jobj = jsonqueue.dequeue();
+        jobj["Sq"] = (int)txseq;
+        jobj["Ss"] = (int)txsession;
+        if(txseqreset) {
+            jobj["SqR"] = true;
+            txseqreset = false;
+        }
+        QString json = QJsonDocument(jobj).toJson(QJsonDocument::Compact);
 
-    // If still waiting for an ack, add to the queue
-    if(jsonwaitingack != 0) {
-        jsonqueue.enqueue(lastjson);
-        return;
+        // Calculate the CRC Checksum
+        uint16_t CRC = escapeCRC(uCRC16Lib::calculate(json.toUtf8().data(),json.length()));
+
+        QByteArray frame = (char)0x02 + json.toLatin1() + QByteArray::fromRawData((char*)&CRC,2) + (char)0x03 + "\r\n";
+        //qDebug() << "JSONout" << frame;
+
+        txunacked.append(qMakePair(txseq, frame));
+        serialDataOut += frame;
+        txseq++;
+        sent = true;
     }
 
-    // Add serial data to the TX buffer, emit a signal it's ready
-    serialDataOut += lastjson;    
-    jsonwaitingack = 1; // Set as faulted until ACK returned
+    if(!sent)
+        return;
 
     emit serialTxReady();
+    if(!acknaktimer.isActive())
+        acknaktimer.start(ACKNAK_TIMEOUT);
 
     // Reset Ack Timer
     imheretimout.stop();
     imheretimout.start(IMHERETIME);
 }
 
+// Board received every frame up to seq, -1 = the oldest one (no sequence number)
+void BoardJson::ackReceived(int seq)
+{
+    int acked = seq < 0 && !txunacked.isEmpty() ? 0 : -1;
+    for(int i=0; i < txunacked.size() && acked < 0; i++) {
+        if(txunacked.at(i).first == seq)
+            acked = i;
+    }
+    if(acked < 0) // Duplicate ack
+        return;
+
+    txunacked.erase(txunacked.begin(), txunacked.begin() + acked + 1);
+    txsessionacked = true;
+    txfaults = 0;
+    acknaktimer.stop();
+    if(!txunacked.isEmpty())
+        acknaktimer.start(ACKNAK_TIMEOUT);
+
+    sendQueuedJSON();
+}
+
+// Board wants everything from seq resent, -1 = all frames waiting for an ack
+void BoardJson::nakReceived(int seq)
+{
+    // Frames before seq were received. Until the board acks one of this session its NAK number
+    //  can be left from the last one, keep everything so the restart frame is sent again
+    for(int i=0; i < txunacked.size() && txsessionacked; i++) {
+        if(txunacked.at(i).first == seq) {
+            txunacked.erase(txunacked.begin(), txunacked.begin() + i);
+            break;
+        }
+    }
+
+    // Several frames after a lost one all NAK, resend once they have stopped
+    emit addToLog("ERROR: CRC Fault - Re-sending data\r\n");
+    acknaktimer.stop();
+    acknaktimer.start(TX_FAULT_PAUSE);
+}
+
+// No ack in time or a nak was received, resend everything not acked
+void BoardJson::ackNakTimeout()
+{
+    if(txunacked.isEmpty())
+        return;
+
+    // If too many faults, disconnect.
+    if(++txfaults > MAX_TX_FAULTS) {
+        if(!paramTXErrorSent) {
+            emit addToLog("\r\nERROR: Critical - " + QString::number(MAX_TX_FAULTS)+ " transmission faults, disconnecting\r\n");
+            emit paramSendFailure(1);
+            paramTXErrorSent = true;
+        }
+        return;
+    }
+
+    for(int i=0; i < txunacked.size(); i++)
+        serialDataOut += txunacked.at(i).second;
+    emit serialTxReady();
+    acknaktimer.start(ACKNAK_TIMEOUT);
+}
+
+// Start a new sequence, the first frame tells the board to follow it
+void BoardJson::resetSequence()
+{
+    jsonqueue.clear();
+    txunacked.clear();
+    acknaktimer.stop();
+    txfaults = 0;
+    txseq = QRandomGenerator::global()->bounded(256);
+    txseqreset = true;
+    txsession = QRandomGenerator::global()->bounded(65536);
+    txsessionacked = false;
+}
+
 void BoardJson::parseIncomingJSON(const QVariantMap &map)
 {
     // Settings from the Tracker Sent, save them and update the UI
     if(map["Cmd"].toString() == "Set") {
         rxParamsTimer.stop(); // Stop error timer
         rxparamfaults = 0;
-        trkset->setAllData(map);
+        QVariantMap setmap = map;
+        if(setmap.contains("Gen")) {
+            settingsgen = setmap.take("Gen").toUInt();
+            settingsgenid = setmap.take("GenId").toUInt();
+            settingsgenvalid = true;
+        }
+        trkset->setAllData(setmap);
         emit paramReceiveComplete();
         // Remind user to calibrate
         if((fabs(trkset->getAccXOff()) < 0.0001 &&
             fabs(trkset->getAccXOff()) < 0.0001 &&
             fabs(trkset->getAccXOff()) < 0.0001) ||
-            (map["dismag"].toBool() == false &&
+            (trkset->getDisMag() == false &&
             fabs(trkset->getMagXOff()) < 0.0001 &&
             fabs(trkset->getMagYOff()) < 0.0001 &&
             fabs(trkset->getMagZOff()) < 0.0001)) {
@@ -384,6 +568,26 @@ void BoardJson::parseIncomingJSON(const QVariantMap &map)
         rxfeaturesfaults = 0;
         emit featuresReceiveComplete();
 
+        // Ask for the boot timeline
+        if(_features.contains("BOOTTIME"))
+            sendSerialJSON("BootTm");
+
+    // Boot timeline, each stage is [name, start us, end us]
+    } else if (map["Cmd"].toString() == "BootTm") {
+        foreach(QVariant stage, map["Stages"].toList()) {
+            QVariantList st = stage.toList();
+            if(st.size() < 3)
+                continue;
+            emit addToLog(QString("Boot %1 %2ms - %3ms\n").arg(st[0].toString(), -10)
+                          .arg(st[1].toDouble() / 1000.0, 0, 'f', 1)
+                          .arg(st[2].toDouble() / 1000.0, 0, 'f', 1));
+        }
+        emit addToLog(QString("Boot complete in %1ms\n").arg(map["Done"].toDouble() / 1000.0, 0, 'f', 1));
+
+    // Achieved data item rates
+    } else if (map["Cmd"].toString() == "DataRate") {
+        trkset->setDataRates(map);
+
     // Data sent, Update the graph / servo sliders / calibration
     } else if (map["Cmd"].toString() == "Data") {
         QVariantMap cmap = map;
@@ -481,29 +685,6 @@ QByteArray BoardJson::unescapeLog(QByteArray data)
     }
     return rval;
 }
-void BoardJson::nakError()
-{
-    // If too many faults, disconnect.
-    if(jsonwaitingack > MAX_TX_FAULTS) {
-        if(!paramTXErrorSent) {
-            emit addToLog("\r\nERROR: Critical - " + QString::number(MAX_TX_FAULTS)+ " transmission faults, disconnecting\r\n");
-            emit paramSendFailure(1);
-            paramTXErrorSent = true;
-        }
-    } else {
-        // Pause a bit, give time for device to catch up
-        Sleep(TX_FAULT_PAUSE);
-
-        // Resend last JSON
-        serialDataOut += lastjson;
-        emit serialTxReady();
-        emit addToLog("ERROR: CRC Fault - Re-sending data\r\nGUI: " +  lastjson + "\r\n");
-
-        // Increment fault counter
-        jsonwaitingack++;
-    }
-}
-
 void BoardJson::ihTimeout()
 {
     sendSerialJSON("IH");
@@ -10,6 +10,7 @@
 
 #include "trackersettings.h"
 #include "calibrateble.h"
+#include "logdictionary.h"
 
 class BoardJson : public QObject
 {
@@ -48,23 +49,47 @@ private:
     static const int MAX_TX_FAULTS=8; // Number of times to try re-sending data
     static const int TX_FAULT_PAUSE=750; // milliseconds wait before trying another send
     static const int ACKNAK_TIMEOUT=500; // milliseconds without an ack/nak is a fault
+    static const int TX_WINDOW=4; // Frames sent before waiting for an ack
+    static const int CALIBRATION_RATE=100; // Hz to request raw sensor data at while calibrating
+    static const int RAW_ACC_VALID=0x01;
+    static const int RAW_MAG_VALID=0x02;
+    static const int RAW_GYR_VALID=0x04;
+
+    // Raw sensor sample as packed by the board, rawsample_t in the firmware sense.h
+#pragma pack(push, 1)
+    struct RawSample {
+        quint16 seq;
+        quint8 valid;
+        float acc[3];
+        float mag[3];
+        float gyr[3];
+    };
+#pragma pack(pop)
 
     bool calmsgshowed;
     bool savedToNVM;
     bool savedToRAM;
     bool paramTXErrorSent;
     bool paramRXErrorSent;
-    int jsonwaitingack;
+    int txfaults;
+    quint8 txseq; // Sequence number of the next frame
+    bool txseqreset; // Next frame asks the board to restart its sequence
+    quint16 txsession; // Random id of this sequence, sent in every frame
+    bool txsessionacked; // Board has acked a frame of this sequence
     int rxparamfaults;
     bool featuresTXErrorSent;
     bool featuresRXErrorSent;
     int rxfeaturesfaults;
+    bool settingsgenvalid;
+    quint32 settingsgen; // Settings generation of the last received Set
+    quint32 settingsgenid; // Board boot id the generation belongs to
     QStringList _features;
     QMap<QString, QVariant> _pins;
 
     QByteArray serialDataOut;
-    QByteArray lastjson;
-    QQueue<QByteArray> jsonqueue;
+    QQueue<QJsonObject> jsonqueue;
+    QList<QPair<quint8, QByteArray>> txunacked; // Frames sent, waiting for an ack
+    QTimer acknaktimer;
     QTimer imheretimout;
     QTimer updatesettingstmr;
     QTimer rxParamsTimer;
@@ -74,11 +99,20 @@ private:
     TrackerSettings *trkset;
     CalibrateBLE *bleCalibratorDialog;
     QString _boardName;
+    LogDictionary logdictionary;
+    bool logdictionarytried;
+    bool rawseqvalid;
+    quint16 rawseq; // Next expected raw sample sequence
+    quint32 rawdrops;
 
     void sendSerialJSON(QString command, QVariantMap map=QVariantMap());
     void parseIncomingJSON(const QVariantMap &map);
+    void parseRawSamples(const QByteArray &data);
 
-    void nakError();
+    void sendQueuedJSON();
+    void ackReceived(int seq);
+    void nakReceived(int seq);
+    void resetSequence();
 
     template<class T>
     class ArrayType {
@@ -93,6 +127,7 @@ private:
 
 private slots:
     void ihTimeout();
+    void ackNakTimeout();
     void rxParamsTimeout();
     void rxFeaturesTimeout();
     void changeDataItems();
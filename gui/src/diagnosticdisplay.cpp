@@ -98,6 +98,7 @@ DataModel::DataModel(TrackerSettings *ts, QObject *parent)
     datalist.append(dataitem);
   }
   connect(trkset,&TrackerSettings::liveDataChanged, this, &DataModel::dataupdate);
+  connect(trkset,&TrackerSettings::dataRatesChanged, this, &DataModel::ratesupdate);
 }
 
 DataModel::~DataModel()
@@ -160,6 +161,20 @@ QVariant DataModel::data(const QModelIndex &index, int role) const
         }
         return trkset->descriptions[name];
     }
+    if(index.column() == 3) { // Achieved / requested rate, reported by the board
+        QString name = datalist.at(index.row())->name;
+        int pos = name.indexOf(QChar('['));
+        if(pos >= 0) {
+            name = name.left(pos);
+        }
+        QVariantList rate = trkset->dataRates().value(name).toList();
+        if(rate.size() < 3)
+            return QVariant();
+        QString text = tr("%1 / %2 Hz").arg(rate[1].toDouble(), 0, 'f', 1).arg(rate[0].toInt());
+        if(rate[2].toInt() > 0)
+            text += tr(" (%1 dropped)").arg(rate[2].toInt());
+        return text;
+    }
   } else if (role == Qt::CheckStateRole) {
       if(index.column() == 0)
         return datalist.at(index.row())->checked?Qt::Checked:Qt::Unchecked;
@@ -196,6 +211,8 @@ QVariant DataModel::headerData(int section, Qt::Orientation orientation, int rol
     return tr("Value");
   if(section == 2)
     return tr("Description");
+  if(section == 3)
+    return tr("Rate");
   return QVariant();
 }
 
@@ -241,3 +258,8 @@ void DataModel::dataupdate()
   }
 }
 
+void DataModel::ratesupdate()
+{
+  if(datalist.count() > 1)
+    Q_EMIT(dataChanged(createIndex(0,3),createIndex(datalist.count()-2,3)));
+}
@@ -56,7 +56,7 @@ public:
   QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
   QModelIndex parent(const QModelIndex &index) const override;
   int rowCount(const QModelIndex &parent = QModelIndex()) const override {Q_UNUSED(parent); return datalist.count()-1;}
-  int columnCount(const QModelIndex &parent = QModelIndex()) const override {Q_UNUSED(parent); return 3;}
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override {Q_UNUSED(parent); return 4;}
   QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
 private:
   void checkArray(QString array, bool checked);
@@ -64,6 +64,7 @@ private:
   QList<DataItem *> datalist;
 private slots:
   void dataupdate();
+  void ratesupdate();
 
 };
 
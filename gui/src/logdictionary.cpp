@@ -0,0 +1,257 @@
+#include "logdictionary.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cstring>
+
+// Dictionary log message types
+#define MSG_TYPE_NORMAL 0
+#define MSG_TYPE_DROPPED 1
+
+// type, domain:4 level:4, package_len, data_len, source. Followed by the timestamp
+#define MSG_HEADER_SIZE 10
+
+// cbprintf package header and format string pointer, arguments follow
+#define PKG_HEADER_SIZE 8
+
+bool LogDictionary::load(const QString &filename)
+{
+    sections.clear();
+    sources.clear();
+
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+
+    // Read only data sections, where the format strings live
+    QJsonValue secs = root["sections"];
+    QJsonArray seclist = secs.isArray() ? secs.toArray() : QJsonArray();
+    if(secs.isObject()) {
+        QJsonObject secobj = secs.toObject();
+        foreach(QString key, secobj.keys())
+            seclist.append(secobj[key]);
+    }
+    foreach(QJsonValue val, seclist) {
+        QJsonObject sec = val.toObject();
+        Section section;
+        section.start = sec["start"].toVariant().toULongLong();
+        section.data = QByteArray::fromBase64(sec["data_b64"].toString().toLatin1());
+        if(!section.data.isEmpty())
+            sections.append(section);
+    }
+
+    // Log module names by source address
+    QJsonObject instances = root["log_subsys"].toObject()["log_instances"].toObject();
+    foreach(QString key, instances.keys()) {
+        bool ok;
+        quint32 addr = key.toUInt(&ok, 0);
+        QJsonValue name = instances[key];
+        if(ok)
+            sources[addr] = name.isObject() ? name.toObject()["name"].toString() : name.toString();
+    }
+
+    return isLoaded();
+}
+
+// Expands a single unescaped dictionary log message into text
+QString LogDictionary::decode(const QByteArray &msg)
+{
+    static const char *levels[] = {"", "err", "wrn", "inf", "dbg"};
+
+    if(msg.size() >= 3 && msg[0] == (char)MSG_TYPE_DROPPED)
+        return QString("Dropped %1 log messages").arg(getU16(msg, 1));
+
+    if(msg.size() < MSG_HEADER_SIZE || msg[0] != (char)MSG_TYPE_NORMAL)
+        return QString("Invalid dictionary log message (%1)").arg(QString(msg.toHex()));
+
+    int level = ((quint8)msg[1] >> 4) & 0x0F;
+    int pkglen = getU16(msg, 2);
+    int datalen = getU16(msg, 4);
+    quint32 source = getU32(msg, 6);
+
+    // Timestamp is 32 or 64 bit depending on CONFIG_LOG_TIMESTAMP_64BIT
+    int pkgstart = msg.size() - pkglen - datalen;
+    if(pkgstart != MSG_HEADER_SIZE + 4 && pkgstart != MSG_HEADER_SIZE + 8)
+        return QString("Invalid dictionary log message (%1)").arg(QString(msg.toHex()));
+    QByteArray pkg = msg.mid(pkgstart, pkglen);
+    if(pkg.size() < PKG_HEADER_SIZE)
+        return QString("Invalid dictionary log message (%1)").arg(QString(msg.toHex()));
+
+    // Package header, length in words then the appended string counts
+    int argsend = (quint8)pkg[0] * 4;
+    int strcnt = (quint8)pkg[1];
+    int rostrcnt = (quint8)pkg[2];
+    int rwstrcnt = (quint8)pkg[3];
+
+    // Strings copied into the message, each is its argument word index then the string
+    QMap<int, QString> strtbl;
+    QByteArray appended = pkg.mid(argsend + rostrcnt + rwstrcnt);
+    for(int i=0; i < appended.size() && strtbl.size() < strcnt;) {
+        int idx = (quint8)appended[i++];
+        int end = appended.indexOf('\0', i);
+        if(end < 0)
+            end = appended.size();
+        strtbl[idx] = QString::fromLatin1(appended.mid(i, end - i));
+        i = end + 1;
+    }
+
+    QString fmt = getString(getU32(pkg, 4), 4, strtbl);
+    QString text = format(fmt, pkg.left(argsend), PKG_HEADER_SIZE, strtbl);
+    if(datalen > 0)
+        text += " " + QString(msg.mid(pkgstart + pkglen, datalen).toHex(' '));
+
+    QString module = sources.value(source, QString("0x%1").arg(source, 8, 16, QChar('0')));
+    return QString("<%1> %2: %3").arg(QString(level < 5 ? levels[level] : "???"), module, text);
+}
+
+bool LogDictionary::findString(quint32 addr, QString &str)
+{
+    foreach(const Section &sec, sections) {
+        if(addr >= sec.start && addr < sec.start + (quint32)sec.data.size()) {
+            int offset = addr - sec.start;
+            int end = sec.data.indexOf('\0', offset);
+            if(end < 0)
+                end = sec.data.size();
+            str = QString::fromLatin1(sec.data.mid(offset, end - offset));
+            return true;
+        }
+    }
+    return false;
+}
+
+// String from the dictionary, otherwise one copied into the package at pkgoffset
+QString LogDictionary::getString(quint32 addr, int pkgoffset, const QMap<int, QString> &strtbl)
+{
+    QString str;
+    if(findString(addr, str))
+        return str;
+    if(strtbl.contains(pkgoffset / 4))
+        return strtbl[pkgoffset / 4];
+    return QString("<string@0x%1>").arg(addr, 8, 16, QChar('0'));
+}
+
+// printf style formatting with the arguments from the package, starting at argoffset
+QString LogDictionary::format(const QString &fmt, const QByteArray &pkg, int argoffset,
+                              const QMap<int, QString> &strtbl)
+{
+    QString out;
+    int off = argoffset;
+
+    for(int i=0; i < fmt.length(); i++) {
+        if(fmt[i] != '%') {
+            out += fmt[i];
+            continue;
+        }
+        int start = i++;
+        if(i < fmt.length() && fmt[i] == '%') {
+            out += '%';
+            continue;
+        }
+
+        // Flags, width and precision. * takes its value from the arguments
+        QByteArray spec = "%";
+        while(i < fmt.length() && QString("-+ #0.123456789*").contains(fmt[i])) {
+            if(fmt[i] == '*') {
+                spec += QByteArray::number((qint32)getU32(pkg, off));
+                off += 4;
+            } else {
+                spec += fmt[i].toLatin1();
+            }
+            i++;
+        }
+        QString length;
+        while(i < fmt.length() && QString("hlzjtL").contains(fmt[i]))
+            length += fmt[i++];
+        if(i >= fmt.length())
+            break;
+
+        char conv = fmt[i].toLatin1();
+        bool wide = length == "ll" || length == "j" || length == "L";
+        int size = wide || QString("fFeEgGaA").contains(conv) ? 8 : 4;
+        if(size == 8)
+            off = (off + 7) & ~7; // 64 bit arguments are 8 byte aligned
+        if(off + size > pkg.size()) {
+            out += "<missing>";
+            break;
+        }
+
+        quint64 val = getU32(pkg, off);
+        if(size == 8)
+            val |= (quint64)getU32(pkg, off + 4) << 32;
+
+        switch(conv) {
+        case 'd':
+        case 'i':
+            if(wide)
+                out += QString::asprintf((spec + "lld").constData(), (qint64)val);
+            else if(length == "hh")
+                out += QString::asprintf((spec + "d").constData(), (qint8)val);
+            else if(length == "h")
+                out += QString::asprintf((spec + "d").constData(), (qint16)val);
+            else
+                out += QString::asprintf((spec + "d").constData(), (qint32)val);
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            if(wide)
+                out += QString::asprintf((spec + "ll" + conv).constData(), (quint64)val);
+            else if(length == "hh")
+                out += QString::asprintf((spec + conv).constData(), (quint8)val);
+            else if(length == "h")
+                out += QString::asprintf((spec + conv).constData(), (quint16)val);
+            else
+                out += QString::asprintf((spec + conv).constData(), (quint32)val);
+            break;
+        case 'c':
+            out += QString::asprintf((spec + "c").constData(), (int)val);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A': {
+            double d;
+            memcpy(&d, &val, sizeof(d));
+            out += QString::asprintf((spec + conv).constData(), d);
+            break;
+        }
+        case 's':
+            out += QString::asprintf((spec + "s").constData(),
+                                     getString(val, off, strtbl).toLatin1().constData());
+            break;
+        case 'p':
+            out += QString("0x%1").arg((quint32)val, 8, 16, QChar('0'));
+            break;
+        default:
+            out += fmt.mid(start, i - start + 1);
+            continue;
+        }
+        off += size;
+    }
+    return out;
+}
+
+quint32 LogDictionary::getU32(const QByteArray &ba, int offset)
+{
+    if(offset < 0 || offset + 4 > ba.size())
+        return 0;
+    return (quint8)ba[offset] |
+           (quint8)ba[offset + 1] << 8 |
+           (quint8)ba[offset + 2] << 16 |
+           (quint32)(quint8)ba[offset + 3] << 24;
+}
+
+quint16 LogDictionary::getU16(const QByteArray &ba, int offset)
+{
+    if(offset < 0 || offset + 2 > ba.size())
+        return 0;
+    return (quint8)ba[offset] | (quint8)ba[offset + 1] << 8;
+}
@@ -0,0 +1,37 @@
+#ifndef LOGDICTIONARY_H
+#define LOGDICTIONARY_H
+
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+// Expands Zephyr dictionary log messages sent by the board when built with
+// CONFIG_LOG_BACKEND_HTGUI_OUTPUT_DICTIONARY. Format strings and module names are
+// looked up in the log_dictionary.json generated by the firmware build.
+
+class LogDictionary
+{
+public:
+    bool load(const QString &filename);
+    bool isLoaded() {return !sections.isEmpty();}
+    QString decode(const QByteArray &msg);
+
+private:
+    struct Section {
+        quint32 start;
+        QByteArray data;
+    };
+    QList<Section> sections;
+    QMap<quint32, QString> sources;
+
+    bool findString(quint32 addr, QString &str);
+    QString getString(quint32 addr, int pkgoffset, const QMap<int, QString> &strtbl);
+    QString format(const QString &fmt, const QByteArray &pkg, int argoffset,
+                   const QMap<int, QString> &strtbl);
+
+    static quint32 getU32(const QByteArray &ba, int offset);
+    static quint16 getU16(const QByteArray &ba, int offset);
+};
+
+#endif // LOGDICTIONARY_H
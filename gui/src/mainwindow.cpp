@@ -134,6 +134,7 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->spnRotZ, &QSpinBox::valueChanged, this, &MainWindow::updateFromUI);
     connect(ui->spnSBUSRate, &QSpinBox::valueChanged, this, &MainWindow::updateFromUI);
     connect(ui->spnCRSFRate, &QSpinBox::valueChanged, this, &MainWindow::updateFromUI);
+    connect(ui->cmbCRSFBaud, &QComboBox::currentIndexChanged, this, &MainWindow::updateFromUI);
     connect(ui->spnRstDblTapMax, &QSpinBox::valueChanged, this, &MainWindow::updateFromUI);
     connect(ui->spnRstDblTapMin, &QSpinBox::valueChanged, this, &MainWindow::updateFromUI);
     connect(ui->spnRstDblTapThres, &QSpinBox::valueChanged, this, &MainWindow::updateFromUI);
@@ -184,6 +185,7 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->cmbPWM1, &QComboBox::currentIndexChanged, this, &MainWindow::updateFromUI);
     connect(ui->cmbPWM2, &QComboBox::currentIndexChanged, this, &MainWindow::updateFromUI);
     connect(ui->cmbPWM3, &QComboBox::currentIndexChanged, this, &MainWindow::updateFromUI);
+    connect(ui->spnPWMRate, &QSpinBox::valueChanged, this, &MainWindow::updateFromUI);
     connect(ui->cmbBTRmtMode, &QComboBox::currentIndexChanged, this, &MainWindow::updateFromUI);
     connect(ui->cmbUartMode, &QComboBox::currentIndexChanged, this, &MainWindow::updateFromUI);
 
@@ -575,6 +577,7 @@ void MainWindow::updateToUI()
     ui->spnA3Off->setValue(trkset.getAn3Off());
     ui->spnSBUSRate->setValue(trkset.getSbusTxRate());
     ui->spnCRSFRate->setValue(trkset.getCrsfTxRate());
+    ui->cmbCRSFBaud->setCurrentIndex(trkset.getCrsfTxBaud());
 
     // Reset on double tap
     if(trkset.getRstOnDbltTap()) {
@@ -635,6 +638,7 @@ void MainWindow::updateToUI()
     ui->cmbPWM1->setCurrentIndex(pwm1Ch==-1?0:pwm1Ch);
     ui->cmbPWM2->setCurrentIndex(pwm2Ch==-1?0:pwm2Ch);
     ui->cmbPWM3->setCurrentIndex(pwm3Ch==-1?0:pwm3Ch);
+    ui->spnPWMRate->setValue(trkset.getPwmRate());
 
     ui->cmbBtMode->setCurrentIndex(trkset.getBtMode());
     int rot[3];
@@ -766,6 +770,7 @@ void MainWindow::updateFromUI()
     trkset.setPwm1(pwmCh1==0?-1:pwmCh1);
     trkset.setPwm2(pwmCh2==0?-1:pwmCh2);
     trkset.setPwm3(pwmCh3==0?-1:pwmCh3);
+    trkset.setPwmRate(ui->spnPWMRate->value());
 
     // Button Press Mode - Enable/Disable on long press (Disable if no button pin selected)
     /*if(trkset.getButtonPin() > 0)
@@ -795,6 +800,7 @@ void MainWindow::updateFromUI()
     trkset.setSbusTxRate(ui->spnSBUSRate->value());
     trkset.setCrsfTxRate(ui->spnCRSFRate->value());
     trkset.setCrsfTxInv(ui->chkCRSFInv->isChecked());
+    trkset.setCrsfTxBaud(ui->cmbCRSFBaud->currentIndex());
 
     uint16_t setframelen = ui->spnPPMFrameLen->value() * 1000;
     trkset.setPpmFrame(setframelen);
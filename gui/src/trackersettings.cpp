@@ -291,6 +291,7 @@ void TrackerSettings::clearDataItems()
         i.next();
         _dataItems[i.key()] = false;
     }
+    _dataItemRates.clear();
     setDataItemsMatched();
 }
 
@@ -305,6 +306,18 @@ void TrackerSettings::setDataItemSend(const QString &itm, const bool &enabled)
     }
 }
 
+// Change the rate of a data item, resent to the board if it's already sending
+void TrackerSettings::setDataItemRate(const QString &itm, int rate)
+{
+    if(!_dataItems.contains(itm) || _dataItemRates.value(itm, 0) == rate)
+        return;
+    _dataItemRates[itm] = rate;
+    if(_dataItems[itm]) {
+        _deviceDataItems.remove(itm);
+        emit requestedDataItemChanged();
+    }
+}
+
 // Add/remove multiple items
 void TrackerSettings::setDataItemSend(QMap<QString, bool> items)
 {
@@ -335,3 +348,10 @@ QMap<QString, bool> TrackerSettings::getDataItems()
 {
   return _dataItems;
 }
+
+void TrackerSettings::setDataRates(const QVariantMap &rates)
+{
+    _dataRates = rates;
+    _dataRates.remove("Cmd");
+    emit dataRatesChanged();
+}
@@ -88,6 +88,12 @@ public:
     void setDataItemsMatched() {_deviceDataItems = _dataItems;}
     // Gets all currently sending data items
     QMap<QString, bool> getDataItems();    
+    // Requested rate (Hz) of a data item, 0 = board default
+    void setDataItemRate(const QString &itm, int rate);
+    int dataItemRate(const QString &itm) {return _dataItemRates.value(itm, 0);}
+    // Requested rate, achieved rate and drops of each data item reported by the board
+    void setDataRates(const QVariantMap &rates);
+    QVariantMap dataRates() {return _dataRates;}
 
 signals:
     void rawGyroChanged(float x, float y, float z);
@@ -99,10 +105,13 @@ signals:
     void ppmOutChanged(int t, int r, int p);
     void liveDataChanged();
     void requestedDataItemChanged();
+    void dataRatesChanged();
 
 private:
     QStringList bleAddresses;
     QStringList _features;
+    QMap<QString, int> _dataItemRates;
+    QVariantMap _dataRates;
 };
 
 #endif // TRACKERSETTINGS_H
@@ -9,6 +9,26 @@
  */
 #include "ucrc16lib.h"
 
+/* Lookup tables, generated at compile time. Table 0 advances the CRC a byte, tables 1-3
+ *  advance it over the bytes that follow so four can be done at once
+ */
+struct uCRC16Tables {
+    uint16_t t[4][256];
+    constexpr uCRC16Tables() : t()
+    {
+        for (int i = 0; i < 256; i++) {
+            uint16_t crc = i;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc & 1) ? (crc >> 1) ^ uCRC16Lib_POLYNOMIAL : crc >> 1;
+            t[0][i] = crc;
+        }
+        for (int i = 0; i < 256; i++) {
+            for (int j = 1; j < 4; j++) t[j][i] = (t[j - 1][i] >> 8) ^ t[0][t[j - 1][i] & 0xFF];
+        }
+    }
+};
+static constexpr uCRC16Tables tables;
+
 /**
  * Constructor
  *
@@ -16,35 +36,32 @@
  */
 uCRC16Lib::uCRC16Lib() {}
 
-
 /**
  * Calculate CRC16 function
  *
  * @param	data_p	*char	Pointer to data
- * @param	length	uint16_t	Length, in bytes, of data to calculate CRC16 of. Should be the same or inferior to data pointer's length.
+ * @param	length	uint16_t	Length, in bytes, of data to calculate CRC16 of. Should be the
+ * same or inferior to data pointer's length.
  */
-uint16_t uCRC16Lib::calculate(char *data_p, uint16_t length) {
-    uint8_t i;
-    uint16_t data;
+uint16_t uCRC16Lib::calculate(const char *data_p, uint16_t length) {
+    const uint8_t *data = (const uint8_t *)data_p;
     uint16_t crc = 0xffff;
 
-    if (length == 0) {
-        return (~crc);
+#if uCRC16Lib_SLICE4_MIN > 0
+    if (length >= uCRC16Lib_SLICE4_MIN) {
+        for (; length >= 4; length -= 4, data += 4) {
+            uint16_t x = crc ^ (data[0] | (data[1] << 8));
+            crc = tables.t[3][x & 0xFF] ^ tables.t[2][x >> 8] ^ tables.t[1][data[2]] ^
+                        tables.t[0][data[3]];
+        }
     }
+#endif
+
+    while (length--) crc = (crc >> 8) ^ tables.t[0][(crc ^ *data++) & 0xFF];
 
-    do {
-        for (i = 0, data = (uint16_t) 0xff & *data_p++; i < 8; i++, data >>= 1) {
-            if ((crc & 0x0001) ^ (data & 0x0001)) {
-                crc = (crc >> 1) ^ uCRC16Lib_POLYNOMIAL;
-            } else {
-                crc >>= 1;
-            }
-        }
-    } while (--length);
     crc = ~crc;
     // Byte swap only needed in certain cases (i.e.: line transmission), so don't perform it.
     // data = crc;
     // crc = (crc << 8) | (data >> 8 & 0xFF);
     return (crc);
 }
-
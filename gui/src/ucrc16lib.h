@@ -6,18 +6,22 @@
  * @email naguissa@foroelectro.net
  * @version 2.0.0
  * @created 2018-04-21
+ *
+ * Table driven, tables are generated at compile time
  */
 #ifndef _uCRC16Lib_
 #define _uCRC16Lib_
 
-typedef unsigned short uint16_t;
-typedef unsigned char uint8_t;
+#include <stdint.h>
 
 #define uCRC16Lib_POLYNOMIAL 0x8408
 
+// Frames at least this long are done four bytes at once (slicing by 4), 0 to disable
+#define uCRC16Lib_SLICE4_MIN 16
+
 class uCRC16Lib {
 public:
-    static uint16_t calculate(char *, uint16_t);
+    static uint16_t calculate(const char *, uint16_t);
     const static uint16_t crc_ok = 0x0F47;
 
 private:
@@ -0,0 +1,95 @@
+#!/usr/bin/python
+
+import set_common as s
+
+# Serial commands received from the GUI, (Command, Enum Name)
+commands = [
+  ("RstCnt", "RESETCENTER"),
+  ("Set", "SET"),
+  ("Flash", "FLASH"),
+  ("Erase", "ERASE"),
+  ("Reboot", "REBOOT"),
+  ("Boot", "BOOTLOADER"),
+  ("Get", "GET"),
+  ("IH", "IMHERE"),
+  ("DatLst", "DATALIST"),
+  ("D--", "STOPDATA"),
+  ("RD", "REQUESTDATA"),
+  ("FW", "FIRMWARE"),
+  ("FE", "FEATURES"),
+  ("RawS", "RAWSTREAM"),
+  ("BootTm", "BOOTTIME"),
+]
+
+seed, size = s.perfectHash([c[0] for c in commands])
+slots = [0] * size
+for i, cmd in enumerate(commands):
+  slots[s.nameHash(cmd[0], seed) & (size - 1)] = i + 1
+
+f = open("../firmware/src/src/serialcommands.h","w")
+f.write("""\
+/*
+* This file is part of the Head Tracker distribution (https://github.com/dlktdr/headtracker)
+* Copyright (c) 2022 Cliff Blackburn
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, version 3.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+* General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**********************************************
+ *
+ *  !!! THIS FILE IS AUTOMATICALLY GENERATED, DO NOT EDIT DIRECTLY !!!
+ *
+ *  Modify buildfwcommands.py and execute buildsettings.py to generate this FW header
+ *
+ ***********************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "basetrackersettings.h"
+
+enum SerialCommand {
+  CMD_UNKNOWN = 0,
+""")
+for cmd in commands:
+  f.write("  CMD_" + cmd[1] + ",\n")
+f.write("""\
+};
+
+// Returns the command matching str, CMD_UNKNOWN if there is none
+static inline SerialCommand serialCommandLookup(const char *str)
+{
+  // Hash slot to command, 0 = empty
+  static const uint8_t slots[""" + str(size) + "] = {\n")
+for i in range(0, size, 16):
+  f.write("    " + ", ".join(str(x) for x in slots[i:i+16]) + ",\n")
+f.write("""\
+  };
+  static const char *const names[""" + str(len(commands)) + "] = {\n")
+for cmd in commands:
+  f.write("    \"" + cmd[0] + "\",\n")
+f.write("""\
+  };
+
+  uint8_t cmd = slots[BaseTrackerSettings::nameHash(str, """ + hex(seed) + "u) & " + str(size - 1) + """];
+  if (cmd == 0 || strcmp(str, names[cmd - 1]) != 0)
+    return CMD_UNKNOWN;
+  return (SerialCommand)cmd;
+}
+""")
+
+f.close()
+
+print("Generated Firmware Serial Commands")
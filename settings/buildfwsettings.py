@@ -99,25 +99,35 @@ for row in events:
 # Write the get + set functions
 f.write("\n")
 
+genid = 0
 for row in s.settings:
   if row[s.coltype].lower().strip() == "bool":
     txt = """\
   // {desc}
   inline const {dtype}& get{cname}() {{return {name};}}
-  void set{cname}({dtype} val={deflt}) {{ {name} = val; }}\n
-""".format(cname = row[s.colname], name = row[s.colname].lower(), dtype = s.typeToC(row[s.coltype]), deflt = row[s.coldefault].lower(), minv = row[s.colmin], maxv = row[s.colmax], desc = row[s.coldesc])
+  void set{cname}({dtype} val={deflt}) {{
+    if({name} != val) {{
+      {name} = val;
+      settinggen[{gen}] = ++generation;
+    }}
+  }}\n
+""".format(cname = row[s.colname], name = row[s.colname].lower(), dtype = s.typeToC(row[s.coltype]), deflt = row[s.coldefault].lower(), minv = row[s.colmin], maxv = row[s.colmax], desc = row[s.coldesc], gen = genid)
   else:
     txt = """\
   // {desc}
   inline const {dtype}& get{cname}() {{return {name};}}
   bool set{cname}({dtype} val={deflt}) {{
     if(val >= {minv} && val <= {maxv}) {{
-      {name} = val;
+      if({name} != val) {{
+        {name} = val;
+        settinggen[{gen}] = ++generation;
+      }}
       return true;
     }}
     return false;
-  }}\n\n""".format(cname = row[s.colname], name = row[s.colname].lower(), dtype = s.typeToC(row[s.coltype]), deflt = row[s.coldefault], minv = row[s.colmin], maxv = row[s.colmax], desc = row[s.coldesc])
+  }}\n\n""".format(cname = row[s.colname], name = row[s.colname].lower(), dtype = s.typeToC(row[s.coltype]), deflt = row[s.coldefault], minv = row[s.colmin], maxv = row[s.colmax], desc = row[s.coldesc], gen = genid)
   f.write(txt)
+  genid += 1
 
 # Get & Set for the Settings Arrays
 for row in s.settingsarrays:
@@ -132,22 +142,29 @@ for row in s.settingsarrays:
     bool changed = false;
     for(int i=0; i < {len}; i++) {{
       if({name}[i] >= {minv} && {name}[i] <= {maxv}) {{
+        if({name}[i] != val[i])
+          settinggen[{gen}] = generation + 1;
         {name}[i] = val[i];
         changed = true;
       }}
     }}
+    if(settinggen[{gen}] > generation)
+      generation++;
     return changed;
-  }}\n\n""".format(cname = row[s.colname][:start], name = row[s.colname][:start].lower(), dtype = s.typeToC(row[s.coltype].strip()), deflt = row[s.coldefault], minv = row[s.colmin], maxv = row[s.colmax], desc = row[s.coldesc], len = arraylength )
+  }}\n\n""".format(cname = row[s.colname][:start], name = row[s.colname][:start].lower(), dtype = s.typeToC(row[s.coltype].strip()), deflt = row[s.coldefault], minv = row[s.colmin], maxv = row[s.colmax], desc = row[s.coldesc], len = arraylength, gen = genid)
   else:
     txt = """\
   // {desc}
   void get{cname}({dtype}* dest) {{strcpy(dest, {name});}}
   void set{cname}(const char *val) {{
+    if(strncmp({name}, val, {len}) != 0)
+      settinggen[{gen}] = ++generation;
     strncpy({name}, val, {len}+1);
     {name}[{len}] = '\\0';
-  }}\n\n""".format(cname = row[s.colname][:start], name = row[s.colname][:start].lower(), dtype = s.typeToC(row[s.coltype].strip()), deflt = row[s.coldefault], minv = row[s.colmin], maxv = row[s.colmax], desc = row[s.coldesc], len = arraylength )
+  }}\n\n""".format(cname = row[s.colname][:start], name = row[s.colname][:start].lower(), dtype = s.typeToC(row[s.coltype].strip()), deflt = row[s.coldefault], minv = row[s.colmin], maxv = row[s.colmax], desc = row[s.coldesc], len = arraylength, gen = genid)
 
   f.write(txt)
+  genid += 1
 
 # Set Functions for the Data Items
 for row in s.data:
@@ -179,9 +196,14 @@ for row in s.dataarrays:
   f.write(txt)
 
 # Write all JSON Settings
-f.write("  void setJSONSettings(JsonDocument &json) {\n")
+f.write("""\
+  // Writes settings changed in generation since or later, 0 = all settings
+  void setJSONSettings(JsonDocument &json, uint32_t since = 0) {
+""")
+genid = 0
 for row in s.settings:
-  f.write("    json[\"" + row[s.colname].lower() + "\"] = " + row[s.colname].lower() + ";\n")
+  f.write("    if (settinggen[" + str(genid) + "] >= since) json[\"" + row[s.colname].lower() + "\"] = " + row[s.colname].lower() + ";\n")
+  genid += 1
 for row in s.settingsarrays:
   start = row[s.colname].find("[")
   end = row[s.colname].find("]")
@@ -193,7 +215,8 @@ for row in s.settingsarrays:
       arlen = str(arlen)
     except ValueError:
       arlen = arraylength
-  f.write("    json[\"" + row[s.colname][:start].lower() + "\"] = " + row[s.colname][:start].lower() + ";\n")
+  f.write("    if (settinggen[" + str(genid) + "] >= since) json[\"" + row[s.colname][:start].lower() + "\"] = " + row[s.colname][:start].lower() + ";\n")
+  genid += 1
 f.write("  }\n")
 
 # Read JSON Settings
@@ -228,6 +251,129 @@ for row in events: # Do the on Change call
     f.write("    if(ch" + row.lower() + ")\n      " + row + "();\n");
 f.write("  }\n")
 
+# Packed binary image of the settings, stored in flash
+# Fields are (name, ctype, type id, size, array length or 0)
+typeids = ["bool", "char", "u8", "s8", "u16", "s16", "u32", "s32", "float", "double"]
+fields = []
+for row in s.settings:
+  type = row[s.coltype].lower().strip()
+  fields.append((row[s.colname].lower().strip(), s.typeToC(type), typeids.index(type), s.typeSize(type), 0))
+for row in s.settingsarrays:
+  type = row[s.coltype].lower().strip()
+  start = row[s.colname].find("[")
+  end = row[s.colname].find("]")
+  arlen = int(row[s.colname][start+1:end])
+  if type == "char":
+    arlen += 1 # Null
+  fields.append((row[s.colname][:start].lower(), s.typeToC(type), typeids.index(type), s.typeSize(type) * arlen, arlen))
+
+# Any change to a name, type or order gives a new schema
+schema = "".join("{}:{}:{};".format(fd[0], fd[2], fd[3]) for fd in fields)
+schemahash = s.nameHash(schema, 2166136261)
+
+f.write("""
+  // Types of the settings image fields, stored in flash so only add to the end
+  enum SettingType : uint8_t {{
+    SETTING_BOOL,
+    SETTING_CHAR,
+    SETTING_U8,
+    SETTING_S8,
+    SETTING_U16,
+    SETTING_S16,
+    SETTING_U32,
+    SETTING_S32,
+    SETTING_FLOAT,
+    SETTING_DOUBLE,
+  }};
+
+  // Hash of the settings image layout, an image with another schema has to be migrated
+  static constexpr uint32_t SETTINGS_SCHEMA = {hash}u;
+
+  struct __attribute__((packed)) SettingsImage {{
+""".format(hash = hex(schemahash)))
+for fd in fields:
+  if fd[4]:
+    f.write("    " + fd[1] + " " + fd[0] + "[" + str(fd[4]) + "];\n")
+  else:
+    f.write("    " + fd[1] + " " + fd[0] + ";\n")
+f.write("""\
+  };
+
+  // Where each setting is in the image, found by name when migrating
+  struct __attribute__((packed)) SettingsField {
+    uint32_t name; // nameHash of the setting name, FNV-1a offset basis seed
+    uint16_t offset;
+    uint8_t type;
+    uint8_t size;
+  };
+
+  static constexpr int SETTINGS_FIELD_COUNT = """ + str(len(fields)) + """;
+
+  static const SettingsField *settingsFields()
+  {
+    static const SettingsField fields[SETTINGS_FIELD_COUNT] = {
+""")
+offset = 0
+for fd in fields:
+  f.write("      {" + hex(s.nameHash(fd[0], 2166136261)) + "u, " + str(offset) + ", " + str(fd[2]) + ", " + str(fd[3]) + "}, // " + fd[0] + "\n")
+  offset += fd[3]
+f.write("""\
+    };
+    return fields;
+  }
+  static_assert(sizeof(SettingsImage) == """ + str(offset) + """, "Settings image layout mismatch");
+
+  // Copies the current settings into img
+  void getSettingsImage(SettingsImage &img) {
+""")
+for fd in fields:
+  if fd[4]:
+    f.write("    memcpy(img." + fd[0] + ", " + fd[0] + ", sizeof(img." + fd[0] + "));\n")
+  else:
+    f.write("    img." + fd[0] + " = " + fd[0] + ";\n")
+f.write("  }\n")
+
+# Load from the image through the setters, out of range values keep their current value
+f.write("""
+  // Loads the settings from img, values out of range are ignored
+  void loadSettingsImage(const SettingsImage &img) {
+""")
+for row in events:
+  if row != "":
+    f.write("    bool ch" + row.lower() + " = false;\n");
+for row in s.settings:
+  name = row[s.colname].lower().strip()
+  f.write("    if(" + name + " != img." + name + ") {set" + row[s.colname] + "(img." + name + ");")
+  if row[s.colfwonevnt] == "":
+    f.write("}\n")
+  else:
+    f.write(" ch" + row[s.colfwonevnt].lower() + " = true;}\n")
+for row in s.settingsarrays:
+  start = row[s.colname].find("[")
+  name = row[s.colname][:start].lower()
+  if row[s.coltype].lower().strip() == "char":
+    f.write("""\
+    {{
+      char {name}buf[sizeof(img.{name})];
+      memcpy({name}buf, img.{name}, sizeof({name}buf));
+      {name}buf[sizeof({name}buf) - 1] = '\\0';
+      set{cname}({name}buf);
+""".format(name = name, cname = row[s.colname][:start]))
+  else:
+    f.write("""\
+    {{
+      {ctype} {name}buf[sizeof(img.{name}) / sizeof({ctype})];
+      memcpy({name}buf, img.{name}, sizeof({name}buf));
+      set{cname}({name}buf);
+""".format(name = name, cname = row[s.colname][:start], ctype = s.typeToC(row[s.coltype].strip())))
+  if row[s.colfwonevnt] != "":
+    f.write("      ch" + row[s.colfwonevnt].lower() + " = true;\n")
+  f.write("    }\n")
+for row in events:
+  if row != "":
+    f.write("    if(ch" + row.lower() + ")\n      " + row + "();\n");
+f.write("  }\n")
+
 # All JSON data Items
 f.write("\n  void setJSONDataList(JsonDocument &json)\n  {\n")
 f.write("    JsonArray array = json.add<JsonArray>();\n")
@@ -238,83 +384,127 @@ for row in s.dataarrays:
   f.write("    array.add(\""+ row[s.colname][:start].lower() + "\");\n")
 f.write("  }\n")
 
-# Choose what items to send
-f.write("""\n\
-  // Sets if a data item should be included while in data to GUI
-  void setDataItemSend(const char *var, bool enabled)
-  {
-""")
-id = 0
+# Data items, singles first then arrays. Index is used by all the data item tables
+dataitemnames = [row[s.colname].lower() for row in s.data]
+dataitemnames += [row[s.colname][:row[s.colname].find("[")].lower() for row in s.dataarrays]
+
+# Default rate (Hz) from the update divisor, a divisor of 1 was ~10Hz
+# Approximate JSON bytes of each item, used against the data budget
+datarates = []
+datasizes = []
 for row in s.data:
-  _else = ""
-  if id > 0:
-    _else = "else "
-  id += 1
-  txt = """\
-    {_else}if (strcmp(var, \"{name}\") == 0) {{
-      enabled == true ? senddatavars |= 1 << {id} : senddatavars &= ~(1 << {id});
-      return;
-    }}
-""".format(_else = _else, name = row[s.colname].lower(), id = id)
-  f.write(txt)
-id = 0
+  datarates.append(max(1, 10 // abs(int(row[s.coldivisor]))))
+  valsize = 5 if row[s.coltype].strip() in ("bool", "u8", "u16", "s8", "s16") else 9
+  datasizes.append(len(row[s.colname]) + 4 + valsize)
 for row in s.dataarrays:
   start = row[s.colname].find("[")
-  id += 1
-  txt = """\
-    else if (strcmp(var, \"{name}\") == 0) {{
-      enabled == true ? senddataarray |= 1 << {id} : senddataarray &= ~(1 << {id});
-      return;
-    }}
-""".format(name = row[s.colname].lower()[:start], id = id)
-  f.write(txt)
-f.write("  }\n")
+  end = row[s.colname].find("]")
+  datarates.append(max(1, 10 // abs(int(row[s.coldivisor]))))
+  bytes = s.typeSize(row[s.coltype].strip()) * int(row[s.colname][start+1:end])
+  datasizes.append(start + 7 + len(s.typeToJson(row[s.coltype].strip())) + 4 * ((bytes + 2) // 3))
+
+# Names are looked up through a perfect hash
+seed, size = s.perfectHash(dataitemnames)
+slots = [0] * size
+for i, name in enumerate(dataitemnames):
+  slots[s.nameHash(name, seed) & (size - 1)] = i + 1
 
 f.write("""\n\
-  void sendArray(JsonDocument &json,
-                 uint8_t bit,
-                 const uint32_t counter,
-                 int divisor,
+  static constexpr int DATA_ITEM_COUNT = {count};
+
+  // FNV-1a hash used by the generated name lookup tables
+  static uint32_t nameHash(const char *str, uint32_t seed)
+  {{
+    uint32_t h = seed;
+    while (*str) {{
+      h ^= (uint8_t)*str++;
+      h *= 16777619u;
+    }}
+    return h;
+  }}
+
+  static const char *dataItemName(int item)
+  {{
+    static const char *const names[DATA_ITEM_COUNT] = {{
+""".format(count = len(dataitemnames)))
+for name in dataitemnames:
+  f.write("      \"" + name + "\",\n")
+f.write("""\
+    };
+    return names[item];
+  }
+
+  // Data item index of name, -1 if it isn't a data item
+  static int dataItemIndex(const char *var)
+  {
+    // Hash slot to data item index + 1, 0 = empty
+    static const uint8_t slots[""" + str(size) + """] = {
+""")
+for i in range(0, size, 16):
+  f.write("      " + ", ".join(str(x) for x in slots[i:i+16]) + ",\n")
+f.write("""\
+    }};
+
+    uint8_t item = slots[nameHash(var, {seed}u) & {mask}];
+    if (item == 0 || strcmp(var, dataItemName(item - 1)) != 0)
+      return -1;
+    return item - 1;
+  }}
+
+  // Sets if a data item should be included while in data to GUI
+  // rate is in Hz, 0 uses the item's default rate
+  // Returns false and counts the name if it isn't a data item
+  bool setDataItemSend(const char *var, bool enabled, uint16_t rate = 0)
+  {{
+    static const uint16_t defaultrate[DATA_ITEM_COUNT] = {{
+""".format(seed = hex(seed), mask = size - 1))
+for i in range(0, len(datarates), 16):
+  f.write("      " + ", ".join(str(x) for x in datarates[i:i+16]) + ",\n")
+f.write("""\
+    };
+
+    int item = dataItemIndex(var);
+    if (item < 0) {
+      unknowndataitems++;
+      return false;
+    }
+    if (!enabled) {
+      datarate[item] = 0;
+      return true;
+    }
+    datarate[item] = rate == 0 ? defaultrate[item] : (rate > 1000 ? 1000 : rate);
+    datadue[item] = 0;
+    return true;
+  }
+
+  // Number of unknown data item names requested
+  uint32_t getUnknownDataItems() { return unknowndataitems; }
+
+  bool sendArray(JsonDocument &json,
                  const char *name,
                  void *item,
                  void *lastitem,
-                 int size)
+                 int size,
+                 bool onchange)
   {
-    bool sendit = false;
     char b64array[200];
-    if (senddataarray & (1 << bit)) {
-      if (divisor < 0) {
-        if (memcmp(lastitem, item, size) != 0)
-          sendit = true;
-        else if (divisor != -1 && counter % abs(divisor) == 0)
-          sendit = true;
-      } else {
-        if (counter % divisor == 0)
-          sendit = true;
-      }
-      if (sendit) {
-        encode_base64((unsigned char *)item, size, (unsigned char *)b64array);
-        json[name] = b64array;
-        memcpy(lastitem, item, size);
-      }
-    }
+    if (onchange && memcmp(lastitem, item, size) == 0)
+      return false;
+    encode_base64((unsigned char *)item, size, (unsigned char *)b64array);
+    json[name] = b64array;
+    memcpy(lastitem, item, size);
+    return true;
   }
-  """)
-
-# Transmit Data items back to the gui
-f.write("\n  void setJSONData(JsonDocument &json)\n  {\n")
-f.write("""\
-    // Sends only requested data items
-    // Updates only as often as specified, 1 = every cycle
-    // Base64 only done on arrays as it ends up on avg more bytes to
-    //   do everything
-
-    static uint32_t counter = 0;
 
+  // Adds a single data item to json, returns false if it didn't need sending
+  // Base64 only done on arrays as it ends up on avg more bytes to
+  //   do everything
+  bool addDataItem(JsonDocument &json, int item)
+  {
+    switch (item) {
 """)
 id = 0
 for row in s.data:
-  id += 1
   try:
     round = int(row[s.colround])
     round = pow(10, round)
@@ -326,37 +516,104 @@ for row in s.data:
   else:
     valtxt = row[s.colname].lower()
 
-  txt = """\
-    if (senddatavars & (1 << {id}) && (counter % {div}) == 0)
-      json["{vname}"] = {value};
-""".format(vname = row[s.colname].lower(), value=valtxt, div= row[s.coldivisor], id=id)
-  f.write(txt)
-
-f.write("\n")
+  f.write("""\
+      case {id}:
+        json["{vname}"] = {value};
+        return true;
+""".format(vname = row[s.colname].lower(), value=valtxt, id=id))
+  id += 1
 
-id = 0
 for row in s.dataarrays:
-  id += 1
   start = row[s.colname].find("[")
   end = row[s.colname].find("]")
   arraylength = row[s.colname][start+1:end]
   name = row[s.colname].lower()[:start]
   name6 = "6" + name + s.typeToJson(row[s.coltype].strip())
   ctype = s.typeToC(row[s.coltype].strip())
-  f.write("    sendArray(json," + str(id) + ",counter," + row[s.coldivisor] + ",\"" + name6 + "\",(void*)" + name + ",(void*)last" + row[s.colname].lower()[:start]  + ", sizeof(" + ctype + ") * " + arraylength + ");\n")
+  onchange = "true" if int(row[s.coldivisor]) < 0 else "false"
+  f.write("""\
+      case {id}:
+        return sendArray(json, "{name6}", (void *){name}, (void *)last{name},
+                         sizeof({ctype}) * {len}, {onchange});
+""".format(id = id, name6 = name6, name = name, ctype = ctype, len = arraylength, onchange = onchange))
+  id += 1
 f.write("""\
+    }
+    return false;
+  }
 
-    // Used for reduced data divisor
-    counter++;
-  }\n\n""")
+  // Sends the requested data items which are due at time now (ms)
+  // Items which don't fit in budget (bytes) wait for the next call, if an item
+  //   misses a whole period it is counted as dropped
+  void setJSONData(JsonDocument &json, uint32_t now, int budget)
+  {
+    static const uint8_t datasize[DATA_ITEM_COUNT] = {
+""")
+for i in range(0, len(datasizes), 16):
+  f.write("      " + ", ".join(str(x) for x in datasizes[i:i+16]) + ",\n")
+f.write("""\
+    };
+
+    // Rotate the starting item so a full budget doesn't always starve the same ones
+    static int first = 0;
+
+    for (int n = 0; n < DATA_ITEM_COUNT; n++) {
+      int item = (first + n) % DATA_ITEM_COUNT;
+      if (datarate[item] == 0 || (int32_t)(now - datadue[item]) < 0) continue;
+
+      uint32_t period = 1000 / datarate[item];
+      if (budget < datasize[item]) {
+        if ((int32_t)(now - datadue[item]) >= (int32_t)period) {
+          datadrops[item]++;
+          datadue[item] += period;
+        }
+        continue;
+      }
 
+      if (addDataItem(json, item)) {
+        budget -= datasize[item];
+        datasent[item]++;
+      }
+      datadue[item] += period;
+      if ((int32_t)(now - datadue[item]) >= 0) datadue[item] = now + period;
+    }
+    first = (first + 1) % DATA_ITEM_COUNT;
+  }
+
+  // Achieved rate (Hz) and drops of each requested item over elapsed (ms)
+  // Counts are reset after each call
+  void setJSONDataRates(JsonDocument &json, uint32_t elapsed)
+  {
+    for (int item = 0; item < DATA_ITEM_COUNT; item++) {
+      if (datarate[item] != 0 && elapsed > 0) {
+        JsonArray rate = json[dataItemName(item)].to<JsonArray>();
+        rate.add(datarate[item]);
+        rate.add(roundf(datasent[item] * 10000.0f / elapsed) / 10);
+        rate.add(datadrops[item]);
+      }
+      datasent[item] = 0;
+      datadrops[item] = 0;
+    }
+  }
+
+""")
+
+# Generation Accessors
+f.write("""\
+  // Settings generation, incremented on every setting change
+  uint32_t getGeneration() {return generation;}
+
+  // Identifies this boot, generations from another id can't be compared
+  uint32_t getGenerationId() {return generationid;}
+  void setGenerationId(uint32_t id) {generationid = id;}
+
+""")
 
 # Stop All Data Function
 f.write("""\
   void stopAllData()
   {
-    senddatavars = 0;
-    senddataarray = 0;
+    memset(datarate, 0, sizeof(datarate));
   }
 """)
 
@@ -364,9 +621,19 @@ f.write("""\
 f.write("\nprotected:\n")
 
 f.write("""\
-  // Bit map of data to send to GUI, max 64 items
-  uint64_t senddatavars;
-  uint64_t senddataarray;
+  // Requested rate of each data item (Hz), 0 = not sent
+  uint16_t datarate[DATA_ITEM_COUNT] = {};
+  uint32_t datadue[DATA_ITEM_COUNT] = {};
+  uint16_t datasent[DATA_ITEM_COUNT] = {};
+  uint16_t datadrops[DATA_ITEM_COUNT] = {};
+
+  // Count of unknown names passed to setDataItemSend
+  uint32_t unknowndataitems = 0;
+
+  // Generation each setting was last changed in, settings first then arrays
+  uint32_t generation = 0;
+  uint32_t generationid = 0;
+  uint32_t settinggen[""" + str(len(s.settings) + len(s.settingsarrays)) + """] = {};
 """)
 
 f.write("\n  // Settings\n")
@@ -389,12 +656,7 @@ for row in s.settingsarrays:
   end = row[s.colname].find("]")
   arlen = row[s.colname][start+1:end]
   if row[s.coltype].lower().strip() == "char":
-    try:
-      arlen = int(arraylength)
-      arlen += 1 # Increment Storage Space For Null
-      arlen = str(arlen)
-    except ValueError:
-      arlen = arraylength
+    arlen = str(int(arlen) + 1) # Increment Storage Space For Null
   f.write("  " + s.typeToC(row[s.coltype]) + " " + row[s.colname][:start].lower() + "[" + arlen + "]; // " + row[s.coldesc] + "\n")
 
 f.write("\n  // Real Time Data\n")
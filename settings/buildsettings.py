@@ -5,5 +5,6 @@ import csv
 
 import buildguisettings
 import buildfwsettings
+import buildfwcommands
 import buildfwbtsettings
 import buildwebblebtsettings
\ No newline at end of file
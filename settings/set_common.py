@@ -109,3 +109,35 @@ def QVariantRet(type):
   if type == "char":
     return ".toString()"
 
+
+# FNV-1a hash of a name, must match nameHash() in the generated firmware headers
+def nameHash(name, seed):
+  h = seed
+  for c in name.encode():
+    h ^= c
+    h = (h * 16777619) & 0xFFFFFFFF
+  return h
+
+# Finds a seed that maps every name to a unique slot of a power of two table
+# Returns (seed, table size)
+def perfectHash(names):
+  size = 1
+  while size < len(names) * 4:
+    size *= 2
+  while True:
+    for seed in range(2166136261, 2166136261 + 100000):
+      slots = set()
+      for name in names:
+        slots.add(nameHash(name, seed) & (size - 1))
+      if len(slots) == len(names):
+        return seed, size
+    size *= 2
+
+def typeSize(type) :
+  if type in ("u8", "s8", "char", "bool"):
+    return 1
+  if type in ("u16", "s16"):
+    return 2
+  if type == "double":
+    return 8
+  return 4